@@ -0,0 +1,39 @@
+#ifndef BASE_MAP_CACHE_H
+#define BASE_MAP_CACHE_H
+
+#include <Arduino.h>
+
+// Keeps the most recent base map frame (map without the information box) in
+// flash so a wake only has to fetch the small widget document. Frames are
+// identified by their Framebuffer::hash, which the server publishes as the
+// base map version.
+class BaseMapCache {
+public:
+    BaseMapCache();
+
+    bool begin();
+
+    // Hash of the stored frame, 0 when the cache is empty
+    uint32_t getStoredHash();
+
+    // Load the stored frame if it has the expected hash; the data is re-hashed
+    // so a corrupted file is never shown
+    bool load(uint8_t* frame, size_t size, uint32_t expectedHash);
+
+    // Replace the stored frame; the old one stays valid until the new one is
+    // completely written
+    bool store(const uint8_t* frame, size_t size, uint32_t hash);
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t hash;
+        uint32_t size;
+    };
+
+    bool mounted;
+
+    bool readHeader(Header& header);
+};
+
+#endif // BASE_MAP_CACHE_H
@@ -0,0 +1,62 @@
+#ifndef BITPLANE_FRAME_H
+#define BITPLANE_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// Optional three-bitplane view of a frame: plane b holds bit b of every
+// pixel's color index, 1 bit per pixel, LSB-first within each uint32_t word.
+// Bulk questions on whole frames (what changed, which pixels are black,
+// masking an overlay) become word-wide boolean operations and popcounts.
+//
+// The width must be a multiple of 32 so every row is a whole number of words.
+class BitplaneFrame {
+public:
+    static const int PLANES = 3;
+
+    BitplaneFrame(int width = DISPLAY_WIDTH, int height = DISPLAY_HEIGHT);
+    ~BitplaneFrame();
+
+    bool isAllocated() const { return planes[0] != nullptr; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getWordsPerPlane() const { return wordsPerPlane; }
+    uint32_t* getPlane(int index) const { return planes[index]; }
+
+    // Converters to and from the packed 4bpp panel format (.bin layout)
+    void fromPacked(const uint8_t* packed);
+    void toPacked(uint8_t* packed) const;
+    // Convert length packed bytes that start offset bytes into the frame, for
+    // frames read piece by piece; both must be multiples of 16 (32 pixels)
+    bool fromPacked(const uint8_t* packed, size_t offset, size_t length);
+
+    // 1 bit per pixel mask of pixels with the given color
+    void colorMask(uint8_t color, uint32_t* mask) const;
+    size_t countColor(uint8_t color) const;
+
+    // 1 bit per pixel mask of pixels that differ between two frames
+    static void diffMask(const BitplaneFrame& a, const BitplaneFrame& b, uint32_t* mask);
+    static size_t countChangedPixels(const BitplaneFrame& a, const BitplaneFrame& b);
+    // First and last changed rows, false when the frames are identical
+    static bool changedRows(const BitplaneFrame& a, const BitplaneFrame& b, int& firstRow, int& lastRow);
+
+    // Take pixels from src wherever mask is set (overlay through a mask)
+    void maskedCopy(const BitplaneFrame& src, const uint32_t* mask);
+
+    // FNV-1a style hash over plane words, a quarter of the steps of a byte hash
+    uint32_t hash() const;
+
+private:
+    int width;
+    int height;
+    size_t wordsPerRow;
+    size_t wordsPerPlane;
+    uint32_t* planes[PLANES];
+
+    // Non-copyable: owns its plane storage
+    BitplaneFrame(const BitplaneFrame&);
+    BitplaneFrame& operator=(const BitplaneFrame&);
+};
+
+#endif // BITPLANE_FRAME_H
@@ -0,0 +1,20 @@
+#ifndef CACHE_FS_H
+#define CACHE_FS_H
+
+#include <Arduino.h>
+
+// LittleFS on the "spiffs" partition of partitions.csv. It only holds caches
+// that can be downloaded again (base map, frame bundle), so when the
+// partition it was formatted for differs from the one in the flashed table
+// (offset or size changed) it is formatted once instead of being mounted
+// with blocks past the new end. The layout is recorded in LAYOUT_FILE.
+class CacheFs {
+public:
+    // Mount, migrating after a partition table change; shared by all users
+    static bool begin();
+
+private:
+    static bool mounted;
+};
+
+#endif // CACHE_FS_H
@@ -0,0 +1,58 @@
+#ifndef COMPRESSED_FRAME_H
+#define COMPRESSED_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "inflate_stream.h"
+
+// Compressed panel frame (.binz) produced by Server/utils/binz_encoder.py:
+// the packed 4bpp frame of the .bin as a raw DEFLATE stream whose matches
+// reach at most one small window back, so the decoder needs ~1 KB of history
+// instead of 32 KB.
+//
+//   Header (16 bytes, little-endian)
+//     uint32 magic "BINZ", uint8 version, uint8 window bits, uint16 width,
+//     uint16 height, uint16 reserved (0), uint32 FNV-1a hash of the frame
+//   Raw DEFLATE stream of width * height / 2 bytes
+class CompressedFrame {
+public:
+    static const uint32_t MAGIC = 0x5A4E4942;  // "BINZ"
+    static const uint8_t VERSION = 1;
+    static const int HEADER_SIZE = 16;
+    static const int MIN_WINDOW_BITS = 9;
+    static const int MAX_WINDOW_BITS = 15;
+
+    CompressedFrame();
+
+    // Read and validate the header from input, then set up the inflater
+    bool begin(StreamInput input, void* context);
+    // Next piece of the frame; returns 0 at the end of the frame or on error
+    size_t read(uint8_t* out, size_t length);
+    // True when the whole frame came out, the stream ended there and its
+    // hash matches the header
+    bool finish();
+    void end();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getFrameSize() const { return frameSize; }
+    size_t getWindowSize() const { return windowSize; }
+    uint32_t getFrameHash() const { return frameHash; }
+    uint32_t getCompressedSize() const { return HEADER_SIZE + inflater.getTotalIn(); }
+    const char* getError() const { return error; }
+
+private:
+    InflateStream inflater;
+    int width;
+    int height;
+    size_t frameSize;
+    size_t windowSize;
+    uint32_t frameHash;
+    size_t produced;
+    uint32_t runningHash;
+    const char* error;
+
+    bool fail(const char* message);
+};
+
+#endif // COMPRESSED_FRAME_H
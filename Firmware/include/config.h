@@ -24,18 +24,74 @@
 #define DNS_PORT        53
 
 // GitHub Configuration
-#define GITHUB_HOST     "raw.githubusercontent.com"
-#define GITHUB_PORT     443
+// Frame sources, tried fastest last-known-good first. {repo} and {path} are
+// replaced by the configured repository and map path; http:// skips TLS
+#define FRAME_SOURCES { \
+    "https://raw.githubusercontent.com/{repo}/main/{path}", \
+    /* "http://192.168.1.20:8080/{path}",  LAN mirror of the repository */ \
+}
+#define MAX_FRAME_SOURCES 4
 #define MAX_IMAGE_SIZE  200000  // 200KB max image size
+#define FETCH_EPD_PNG   true    // Fetch the palette-quantised *_epd.png (~35% smaller) before the .bin
+#define LOCAL_WIDGETS   false   // Draw the weather/time box on a cached base map (*_widgets.json); differs from the server render
+#define MAX_WIDGET_JSON_SIZE 2048
+#define STREAM_FRAME_TO_PANEL true  // Forward landscape .bin frames to the panel while downloading
+#define STREAM_CHUNK_SIZE 2048      // Bytes read from the network per panel write
+#define DOWNLOAD_STALL_MS 250       // A blocking body read waiting longer than this counts as a stall
+#define FETCH_COMPRESSED_FRAME true // Stream the DEFLATE-compressed *.binz (~44% of the .bin) before the .bin
+#define FETCH_FRAME_PATCH true      // Patch the last frame (kept in flash) with *.bpatch (~7-15% of the .bin)
+#define FETCH_TILED_FRAME true      // Range-request only the changed tiles of *.tiles into the last frame
+#define TILED_FRAME_MAX_RANGES 8    // Range requests per wake; closest changed tiles are merged to fit
+#define RESUME_DOWNLOADS true       // Keep the prefix of a broken .bin download in flash, fetch the rest by Range
+#define RESUME_MIN_BYTES 16384      // Smaller prefixes are not worth a flash block erase
+#define CACHE_LAST_FRAME (FETCH_FRAME_PATCH || FETCH_TILED_FRAME || RESUME_DOWNLOADS)  // Keep the last frame in flash
+#define FRAME_CACHE_PARTITION "frames"  // Raw data partition with two frame slots (partitions.csv)
+#define FRAME_CACHE_BUDGET_MS 2000      // Max flash erase + write time caching a frame may add to a wake
+#define FRAME_CACHE_URL_SIZE 160        // Source URL kept with the cached frame
+#define REFRESH_MIN_CHANGED_PIXELS 384  // Fewer changed pixels (0.1%) than the cached frame on screen: no refresh, 0 = always
+#define FETCH_MANIFEST true         // Read *_manifest.json first: no frame request when its hash is on screen
+#define MAX_MANIFEST_SIZE 1024
+#define ENCODINGS_WITHOUT_MANIFEST 0 // FrameManifest::Encoding bits still requested when no manifest came (each missing file is a 404)
+#define VERIFY_FRAME_DIGEST true    // SHA-256 of each frame (hardware engine) against the manifest or a Digest header
+#define FRAME_DIGEST_BENCHMARK false // Log hardware vs software SHA-256 time per MB at boot
+#define FETCH_FRAME_BUNDLE true     // Download *.bundle (frames of the next hours) once, show them from flash without WiFi
+#define FRAME_BUNDLE_MAX_FRAMES 8   // Frames per bundle
+#define FRAME_BUNDLE_MAX_SIZE 655360    // Bundle file in LittleFS, next to the base map (1 MB partition)
+#define FRAME_BUNDLE_WAKE_DELAY_S 5     // Wake this long after a frame's display time
+#define ACCEPT_GZIP_ENCODING true   // Offer Content-Encoding: gzip for .bin/.vmap downloads (inflated on the fly)
+#define FETCH_VECTOR_MAP false  // Rasterise the map from *.vmap vector data (solid colors, ~tens of KB)
+#define TLS_SESSION_RESUMPTION true  // Resume the previous wake's TLS session (kept in RTC memory)
+#define TLS_SESSION_CACHE_SIZE 2048  // Serialised session incl. ticket and peer certificate
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+
+// State kept across deep sleep lives in RTC slow memory (8 KB on the ESP32-S2,
+// shared with ESP-IDF). Each RTC_DATA_ATTR struct is checked against its share
+// at compile time; all of them together stay under RTC_STATE_MAX_BYTES.
+#define RTC_TLS_SESSION_BYTES   (TLS_SESSION_CACHE_SIZE + 64)  // "TLSS": session and handshake counters
+#define RTC_FETCHER_STATE_BYTES 256     // "ETAG" validators, "SHOW" bundle frame, "SRCS" source stats
+#define RTC_RETRY_STATE_BYTES   32      // "RTRY" failed-wake episode
+#define RTC_STATE_MAX_BYTES     4096    // Half of RTC slow memory
+#if RTC_TLS_SESSION_BYTES + RTC_FETCHER_STATE_BYTES + RTC_RETRY_STATE_BYTES > RTC_STATE_MAX_BYTES
+#error "RTC_DATA_ATTR state does not fit RTC_STATE_MAX_BYTES: lower TLS_SESSION_CACHE_SIZE"
+#endif
 
 // Update intervals - optimized for deep sleep operation
-#define UPDATE_INTERVAL_MS      10000    // 10 seconds check interval (only used in config mode)
 #define WIFI_RETRY_DELAY_MS     30000    // 30 seconds between WiFi retries
 #define CONFIG_CHECK_INTERVAL   5000     // Check for configuration every 5 seconds
 
 // Deep sleep configuration
 #define ACTIVE_HOURS_SLEEP_MIN   30      // 30 minutes during active hours (7:00-22:00)
 #define INACTIVE_HOURS_SLEEP_H   9       // 9 hours during inactive hours (22:00-7:00)
+#define SERVER_DRIVEN_SLEEP      true    // Sleep until the server's next update (manifest next_update; max-age, Expires only if longer)
+#define SERVER_UPDATE_MARGIN_S   60      // Wake this long after the expected publication
+#define MIN_SLEEP_S              600     // Bounds of a server-driven sleep
+#define MAX_SLEEP_S              32400   // 9 hours
+
+// Retry policy after a failed update (state in RTC memory)
+#define RETRY_IN_WAKE            2       // Further attempts before sleeping
+#define RETRY_DELAY_MS           2000    // First in-wake retry delay, doubled each time, +/-50% jitter
+#define RETRY_BACKOFF_MIN_S      300     // Sleep after the first failed wake, doubled per failed wake
+#define RETRY_BACKOFF_MAX_S      14400   // Backoff cap: 4 hours
 
 // EEPROM Configuration addresses
 #define EEPROM_SIZE             512
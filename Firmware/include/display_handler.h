@@ -2,7 +2,9 @@
 #define DISPLAY_HANDLER_H
 
 #include "epd7in3f.h"
-#include "qr_code.h"
+#include "framebuffer.h"
+#include "screen_renderer.h"
+#include "vector_map.h"
 #include "config.h"
 
 // Forward declaration
@@ -14,7 +16,18 @@ public:
     ~DisplayHandler();
     
     bool initialize();
-    void displayImage(const uint8_t* imageData, size_t dataSize);
+    void displayImage(const uint8_t* imageData, size_t dataSize, bool portrait = false);
+    // Draw the widget box on a portrait base map in place and show it
+    void displayWidgetFrame(uint8_t* baseMap, size_t dataSize, const WidgetData& widgets);
+    // Streamed landscape frame: begin, feed chunks through frameStreamSink
+    // (the first one opens the panel data phase), then finish (refresh) or
+    // abort (nothing is shown)
+    void beginFrameStream();
+    static bool frameStreamSink(void* context, const uint8_t* data, size_t length);
+    void finishFrameStream();
+    void abortFrameStream();
+    // Rasterise a .vmap band by band while uploading; false if it is invalid
+    bool displayVectorMap(const uint8_t* mapData, size_t dataSize);
     void displayImageWithBatteryOverlay(const uint8_t* imageData, size_t dataSize, BatteryMonitor* batteryMonitor);
     void showStatus(const char* message);
     void showSimpleMessage(const char* message);
@@ -26,6 +39,8 @@ public:
 private:
     EPD7in3f epd;
     bool initialized;
+    size_t streamedBytes;
+    unsigned long streamPanelMicros;
     
     // Convert RGB image data to e-paper format
     void convertImageData(const uint8_t* rgbData, size_t dataSize, uint8_t* epdData);
@@ -33,13 +48,9 @@ private:
     
     // QR code display functions
     void displayQRWithInstructions();
-    void drawText(uint8_t* buffer, const char* text, int x, int y, int scale);
     
-    // Battery overlay functions
-    void drawBatteryOverlay(uint8_t* buffer, int percentage);
-    void drawRoundedRect(uint8_t* buffer, int x, int y, int width, int height, int radius, uint8_t fillColor, uint8_t borderColor);
-    void drawBatteryIcon(uint8_t* buffer, int x, int y, int percentage);
-    void setPixel(uint8_t* buffer, int x, int y, uint8_t color);
+    // Screen rasterisation is done by ScreenRenderer; log its cost and result
+    void logRender(const char* screen, const Framebuffer& fb, unsigned long startMicros);
 };
 
 #endif // DISPLAY_HANDLER_H
@@ -15,6 +15,8 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "config.h"
+#include "epd_colors.h"
+#include "frame_transpose.h"
 
 // Display resolution
 #define EPD_WIDTH       800
@@ -24,17 +26,8 @@
 #define UBYTE   unsigned char
 #define UDOUBLE  unsigned long
 
-/**********************************
-Color Index
-**********************************/
-#define EPD_7IN3F_BLACK   0x0	/// 000
-#define EPD_7IN3F_WHITE   0x1	///	001
-#define EPD_7IN3F_GREEN   0x2	///	010
-#define EPD_7IN3F_BLUE    0x3	///	011
-#define EPD_7IN3F_RED     0x4	///	100
-#define EPD_7IN3F_YELLOW  0x5	///	101
-#define EPD_7IN3F_ORANGE  0x6	///	110
-#define EPD_7IN3F_CLEAN   0x7	///	111   unavailable  Afterimage
+// Fills panel rows [top, top + rows) into band (rows * EPD_WIDTH / 2 bytes)
+typedef void (*EpdBandRenderer)(void* context, UBYTE* band, int top, int rows);
 
 class EPD7in3f {
 public:
@@ -46,6 +39,14 @@ public:
     void sleep(void);
     void clear(UBYTE color);
     void display(const UBYTE *image);
+    // Portrait 480x800 frame, rotated band by band while it is sent
+    void displayPortrait(const UBYTE *image);
+    // Streamed frame: beginFrame(), sendFrameData() in panel order, then
+    // turnOnDisplay(); skipping the refresh abandons the frame unseen
+    void beginFrame(void);
+    void sendFrameData(const UBYTE *data, size_t length);
+    // Frame produced band by band (e.g. rasterised), no frame buffer needed
+    void displayBands(EpdBandRenderer render, void* context, UBYTE* band, int bandRows);
     void displayPart(const UBYTE *image, UWORD xstart, UWORD ystart, 
                      UWORD image_width, UWORD image_height);
     void showColorBlocks(void);
@@ -0,0 +1,17 @@
+#ifndef EPD_COLORS_H
+#define EPD_COLORS_H
+
+/**********************************
+Color Index
+7.3" 7-color e-paper, one nibble per pixel (two pixels per byte)
+**********************************/
+#define EPD_7IN3F_BLACK   0x0	/// 000
+#define EPD_7IN3F_WHITE   0x1	///	001
+#define EPD_7IN3F_GREEN   0x2	///	010
+#define EPD_7IN3F_BLUE    0x3	///	011
+#define EPD_7IN3F_RED     0x4	///	100
+#define EPD_7IN3F_YELLOW  0x5	///	101
+#define EPD_7IN3F_ORANGE  0x6	///	110
+#define EPD_7IN3F_CLEAN   0x7	///	111   unavailable  Afterimage
+
+#endif // EPD_COLORS_H
@@ -0,0 +1,78 @@
+#ifndef FRAME_BUNDLE_H
+#define FRAME_BUNDLE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+#include "compressed_frame.h"
+#include "frame_cache.h"
+
+// Time-indexed frame bundle (.bundle) produced by Server/utils/frame_bundle.py:
+// the frames of the next hours, each a complete .binz, behind an index of
+// display times. It is downloaded once into LittleFS; the wakes after that
+// show the frame that is due straight from flash without starting WiFi.
+//
+//   Header (16 bytes, little-endian)
+//     uint32 magic "FBND", uint8 version, uint8 frame count, uint16 reserved,
+//     uint32 creation time, uint32 stale after
+//   Entry per frame (16 bytes): uint32 display at, uint32 file offset,
+//     uint32 length, uint32 FNV-1a hash of the frame
+//   Frames (.binz), one after the other
+//
+// Times are Unix seconds (UTC).
+class FrameBundle {
+public:
+    static const uint32_t MAGIC = 0x444E4246;  // "FBND"
+    static const uint8_t VERSION = 1;
+    static const int HEADER_SIZE = 16;
+    static const int ENTRY_SIZE = 16;
+
+    struct Entry {
+        uint32_t displayAt;
+        uint32_t offset;
+        uint32_t length;
+        uint32_t hash;          // Framebuffer::hash of the inflated frame
+    };
+
+    FrameBundle();
+
+    // Mount LittleFS and read the index of the stored bundle, if any
+    bool begin();
+    bool isLoaded() const { return loaded; }
+
+    int getCount() const { return count; }
+    uint32_t getCreated() const { return created; }
+    uint32_t getStaleAfter() const { return staleAfter; }
+    const Entry& getEntry(int index) const { return entries[index]; }
+
+    // Last frame whose display time has come, -1 when none has yet
+    int dueFrame(uint32_t now) const;
+    // Inflate a frame from flash into sink in STREAM_CHUNK_SIZE pieces; true
+    // when it came out completely and matches the hash of its entry
+    bool stream(int index, FrameChunkSink sink, void* context);
+
+    // Replace the stored bundle with a size byte download: beginWrite drops
+    // the old one (the partition has no room for both), write in order,
+    // finishWrite validates the index before the file is used
+    bool beginWrite(size_t size);
+    bool write(const uint8_t* data, size_t length);
+    bool finishWrite();
+    void abort();
+
+private:
+    bool mounted;
+    bool loaded;
+    int count;
+    uint32_t created;
+    uint32_t staleAfter;
+    Entry entries[FRAME_BUNDLE_MAX_FRAMES];
+    CompressedFrame decoder;
+
+    File writeFile;
+    size_t writeSize;
+    size_t written;
+
+    bool readIndex(const char* path);
+};
+
+#endif // FRAME_BUNDLE_H
@@ -0,0 +1,142 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "config.h"
+
+// Receives a streamed frame body in order; return false to abort the transfer
+typedef bool (*FrameChunkSink)(void* context, const uint8_t* data, size_t length);
+
+// Keeps the last full frame the device downloaded in the raw "frames" flash
+// partition (partitions.csv), the base for frame patches and tile updates. The
+// partition holds two slots; each starts with a header sector followed by the
+// frame data:
+//
+//   | header | frame ........ |  slot A
+//   | header | frame ........ |  slot B
+//
+// A new frame always goes to the slot that is not current, either from a
+// buffer or piece by piece while it streams to the panel, with each 64 KB
+// block erased just before it is written. The header is written last, on
+// commit() once the frame is on screen; its sequence number makes it the
+// current slot, so a power loss at any point leaves the previous frame valid.
+//
+// A download that breaks off can be kept as a partial frame: the received
+// prefix stays in the pending slot and a Partial record in its (still erased)
+// header sector names the URL, validator and length, so the next attempt asks
+// only for the rest. Each later attempt appends one more record; the last
+// valid one wins.
+class FrameCache {
+public:
+    enum Format : uint8_t {
+        FORMAT_NONE = 0,
+        FORMAT_LANDSCAPE = 1,   // Packed 4bpp, 800x480 panel order
+        FORMAT_PORTRAIT = 2     // Packed 4bpp, 480x800, rotated while uploading
+    };
+
+    // Stored frame description, the first bytes of a slot
+    struct Entry {
+        uint32_t magic;
+        uint32_t sequence;      // Highest valid sequence is the current slot
+        uint32_t hash;          // Framebuffer::hash of the frame
+        uint32_t size;
+        uint32_t timestamp;     // Unix time of the download, 0 without clock
+        uint8_t format;
+        uint8_t reserved[3];
+        char url[FRAME_CACHE_URL_SIZE];
+        uint32_t check;         // Framebuffer::hash of the fields above
+    };
+
+    // Prefix of an interrupted download, kept in the pending slot
+    struct Partial {
+        uint32_t magic;
+        uint32_t sequence;      // Sequence the frame gets once complete
+        uint32_t size;          // Full frame size
+        uint32_t received;      // Bytes of the frame in the slot
+        uint32_t hash;          // Framebuffer::hash of those bytes
+        uint8_t format;
+        uint8_t reserved[3];
+        char url[FRAME_CACHE_URL_SIZE];
+        char validator[80];     // ETag or Last-Modified for If-Range
+        uint32_t check;         // Framebuffer::hash of the fields above
+    };
+
+    FrameCache();
+
+    bool begin();
+
+    // Hash of the current frame, 0 when the cache is empty
+    uint32_t getStoredHash();
+    // Header of the current frame; false when the cache is empty
+    bool getStoredEntry(Entry& entry);
+
+    // Load the current frame if it has the expected hash; the data is
+    // re-hashed so a corrupted slot is never patched
+    bool load(uint8_t* frame, size_t size, uint32_t expectedHash);
+    // Read the current frame sequentially into sink in STREAM_CHUNK_SIZE
+    // pieces; true when it was read completely and its hash matches
+    bool stream(FrameChunkSink sink, void* context);
+
+    // Write a pending frame: beginWrite, write in order, finishWrite with the
+    // hash of the whole frame. store() does all three for a buffer. Writing
+    // stops (and the frame is not cached) once erase and write time exceed
+    // FRAME_CACHE_BUDGET_MS.
+    bool beginWrite(const char* url, Format format);
+    bool write(const uint8_t* data, size_t length);
+    bool finishWrite(uint32_t hash);
+    bool store(const uint8_t* frame, size_t size, uint32_t hash, const char* url, Format format);
+    // Drop an unfinished or uncommitted pending frame
+    void abort();
+
+    // Partial download of url, if one is kept
+    bool findPartial(const char* url, Partial& partial);
+    // Read its prefix (partial.received bytes) and check the hash
+    bool readPartial(uint8_t* frame, size_t size);
+    // Continue writing the partial frame after its prefix
+    bool resumeWrite();
+    // Keep the unfinished pending frame as a partial download of a size
+    // byte resource; validator must identify the same version later
+    bool savePartial(const char* validator, size_t size);
+
+    // Make the finished pending frame the current one; no-op without one
+    bool commit();
+
+private:
+    static const uint32_t MAGIC = 0x434D5246;   // "FRMC"
+    static const size_t DATA_OFFSET = 4096;     // Header sector
+    static const size_t ERASE_BLOCK = 65536;
+    static const uint32_t PARTIAL_MAGIC = 0x50524650;   // "PFRP"
+    static const size_t PARTIAL_OFFSET = 512;   // Records after the entry, in the header sector
+    static const size_t PARTIAL_STRIDE = 512;
+    static const int PARTIAL_RECORDS = 7;
+
+    const esp_partition_t* partition;
+    bool scanned;
+    size_t slotSize;
+    int currentSlot;            // -1 when empty
+    Entry current;
+
+    int pendingSlot;
+    Entry pending;
+    bool writing;               // Pending slot being written
+    bool finished;              // Pending frame complete, waiting for commit()
+    bool writeFailed;
+    size_t erasedBytes;         // Slot bytes erased so far, from the slot start
+    unsigned long eraseMs;
+    unsigned long writeMs;
+    uint32_t pendingHash;       // Running hash of the pending frame data
+
+    bool hasPartial;
+    Partial partial;
+    int nextPartialRecord;      // First unused record of the pending slot
+
+    bool readEntry(int slot, Entry& entry);
+    bool eraseUpTo(size_t end);
+    size_t slotOffset(int slot) const { return (size_t)slot * slotSize; }
+    static uint32_t entryCheck(const Entry& entry);
+    static uint32_t partialCheck(const Partial& record);
+    void scanPartial();
+};
+
+#endif // FRAME_CACHE_H
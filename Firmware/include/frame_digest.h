@@ -0,0 +1,43 @@
+#ifndef FRAME_DIGEST_H
+#define FRAME_DIGEST_H
+
+#include <Arduino.h>
+#include <mbedtls/sha256.h>
+
+// SHA-256 of a frame, fed piece by piece as the bytes arrive. On the
+// ESP32-S2 mbedtls runs it on the SHA accelerator (CONFIG_MBEDTLS_HARDWARE_SHA),
+// so the CPU is free for TLS and the panel writes; the time spent in the
+// engine is measured so the overhead per MB shows up in the log.
+class FrameDigest {
+public:
+    static const int SIZE = 32;
+
+    FrameDigest();
+    ~FrameDigest();
+
+    void begin();
+    // No-op unless begin() was called
+    void update(const uint8_t* data, size_t length);
+    // Finish and compare with expected; logs the outcome and the hashing time
+    bool verify(const uint8_t* expected);
+    // Stop hashing a frame that will not be verified
+    void cancel() { active = false; }
+    bool isActive() const { return active; }
+
+    // 64 hex digits, as in *_manifest.json
+    static bool parseHex(const char* hex, uint8_t* digest);
+    // "SHA-256=<base64>" from a Digest response header (RFC 3230)
+    static bool parseDigestHeader(const String& value, uint8_t* digest);
+
+    // Hash bytes with the hardware engine, a portable software SHA-256 and
+    // FNV-1a (Framebuffer::hash), and log the time per MB of each
+    static void benchmark(size_t bytes);
+
+private:
+    mbedtls_sha256_context context;
+    bool active;
+    uint32_t bytes;
+    unsigned long hashMicros;
+};
+
+#endif // FRAME_DIGEST_H
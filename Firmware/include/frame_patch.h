@@ -0,0 +1,55 @@
+#ifndef FRAME_PATCH_H
+#define FRAME_PATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "inflate_stream.h"
+
+// Frame patch (.bpatch) produced by Server/utils/frame_patch.py: the byte
+// runs of the packed .bin frame that changed since the previous server run,
+// applied to a copy of that previous frame.
+//
+//   Header (20 bytes, little-endian)
+//     uint32 magic "BPAT", uint8 version, uint8 window bits, uint16 reserved,
+//     uint32 FNV-1a hash of the base frame, uint32 FNV-1a hash of the result,
+//     uint32 run count
+//   Raw DEFLATE stream of runs: varint bytes kept since the end of the
+//   previous run, varint length, length replacement bytes
+class FramePatch {
+public:
+    static const uint32_t MAGIC = 0x54415042;  // "BPAT"
+    static const uint8_t VERSION = 1;
+    static const int HEADER_SIZE = 20;
+    static const int MIN_WINDOW_BITS = 9;
+    static const int MAX_WINDOW_BITS = 15;
+
+    FramePatch();
+
+    // Read and validate the header from input, then set up the inflater
+    bool begin(StreamInput input, void* context);
+    // Patch frame, which must hold the base frame, in place. True when every
+    // run fits, the stream ends after the last one and the result has the
+    // target hash; on failure frame is partly patched and must be discarded.
+    bool apply(uint8_t* frame, size_t size);
+    void end();
+
+    uint32_t getBaseHash() const { return baseHash; }
+    uint32_t getFrameHash() const { return frameHash; }
+    uint32_t getRunCount() const { return runCount; }
+    uint32_t getChangedBytes() const { return changedBytes; }
+    uint32_t getPatchSize() const { return HEADER_SIZE + inflater.getTotalIn(); }
+    const char* getError() const { return error; }
+
+private:
+    InflateStream inflater;
+    uint32_t baseHash;
+    uint32_t frameHash;
+    uint32_t runCount;
+    uint32_t changedBytes;
+    const char* error;
+
+    bool readVarint(uint32_t& value);
+    bool fail(const char* message);
+};
+
+#endif // FRAME_PATCH_H
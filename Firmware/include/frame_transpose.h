@@ -0,0 +1,39 @@
+#ifndef FRAME_TRANSPOSE_H
+#define FRAME_TRANSPOSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// Portrait frames are DISPLAY_HEIGHT x DISPLAY_WIDTH (480x800) packed 4bpp,
+// the same layout the server uses before it rotates maps for the panel
+#define PORTRAIT_WIDTH          DISPLAY_HEIGHT
+#define PORTRAIT_HEIGHT         DISPLAY_WIDTH
+
+// Rotates portrait frames clockwise into panel (landscape) rows, matching the
+// server converter: landscape (x, y) = portrait (y, PORTRAIT_HEIGHT - 1 - x).
+//
+// Work is done in 8x8 pixel tiles: eight 4-byte portrait row segments are
+// transposed in registers and written as eight 4-byte landscape row segments.
+// A band of BAND_ROWS landscape rows (3200 bytes) is enough to feed the panel
+// in row order, so no second full-frame buffer is needed.
+class FrameTranspose {
+public:
+    static const int TILE = 8;
+    static const int BAND_ROWS = TILE;
+    static const int BAND_SIZE = BAND_ROWS * (DISPLAY_WIDTH / 2);
+    static const int BAND_COUNT = DISPLAY_HEIGHT / BAND_ROWS;
+
+    // Transpose an 8x8 nibble matrix in place; rows[r] holds pixel c of row r
+    // in nibble 7 - c (first pixel in the most significant nibble)
+    static void transposeTile(uint32_t rows[TILE]);
+
+    // Produce landscape rows [band * BAND_ROWS, band * BAND_ROWS + BAND_ROWS)
+    // of a portrait frame into bandBuffer (BAND_SIZE bytes)
+    static void portraitBand(const uint8_t* portrait, int band, uint8_t* bandBuffer);
+
+    // Whole-frame rotation, for callers that do have a destination frame
+    static void portraitToLandscape(const uint8_t* portrait, uint8_t* landscape);
+};
+
+#endif // FRAME_TRANSPOSE_H
@@ -0,0 +1,86 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "epd_colors.h"
+
+// Maximum nesting of viewports (full frame + widgets + sub-widgets)
+#define FRAMEBUFFER_MAX_VIEWPORTS 8
+
+// Packed 4bpp e-paper frame: two pixels per byte, left pixel in the upper nibble.
+// Plain C++ without Arduino dependencies so screens can also be rendered on a host.
+//
+// Drawing coordinates are relative to the active viewport. Each primitive is
+// clipped once against the viewport's clip rect and then runs unchecked loops.
+class Framebuffer {
+public:
+    Framebuffer(uint8_t* buffer, int width = DISPLAY_WIDTH, int height = DISPLAY_HEIGHT);
+
+    uint8_t* getBuffer() const { return buffer; }
+    size_t getSize() const { return (size_t)stride * height; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+
+    // Viewport stack: pushViewport moves the origin to (x, y) and clips to the
+    // w x h rect, pushClip only narrows the clip. Both fail when the stack is
+    // full; call popViewport only after a successful push.
+    bool pushViewport(int x, int y, int w, int h);
+    bool pushClip(int x, int y, int w, int h);
+    void popViewport();
+    int getViewportWidth() const { return viewports[depth].width; }
+    int getViewportHeight() const { return viewports[depth].height; }
+
+    // Drawing primitives (clear fills the active clip rect)
+    void clear(uint8_t color);
+    void setPixel(int x, int y, uint8_t color);
+    uint8_t getPixel(int x, int y) const;
+    void fillRect(int x, int y, int w, int h, uint8_t color);
+    void drawText(const char* text, int x, int y, int scale, uint8_t color = EPD_7IN3F_BLACK);
+    void drawRoundedRect(int x, int y, int width, int height, int radius, uint8_t fillColor, uint8_t borderColor);
+    void fillCircle(int centerX, int centerY, int radius, uint8_t color);
+    // Line with a square pen of thickness x thickness pixels
+    void drawLine(int x0, int y0, int x1, int y1, int thickness, uint8_t color);
+    // 1bpp mask of w x h pixels in color; rows of (w + 7) / 8 bytes, bit i of
+    // byte n is pixel 8n + i (the pixelMask order), clear bits are left alone
+    void drawMask(int x, int y, int w, int h, const uint8_t* bits, uint8_t color);
+
+    // Bulk operations between frames
+    // Same geometry: copy the rect from src
+    void copyRect(const Framebuffer& src, int x, int y, int w, int h);
+    // Draw sprite (any size) with its top left at (x, y); keyColor pixels are
+    // transparent. An 8-pixel aligned position takes the word path.
+    void composite(const Framebuffer& sprite, int x, int y, uint8_t keyColor);
+
+    // Width in pixels of text rendered by drawText (5x7 font, 1px spacing)
+    static int textWidth(const char* text, int scale);
+
+    // FNV-1a hash of the packed frame, used to compare rendered screens.
+    // Pass the previous result as seed to hash data arriving in pieces.
+    static const uint32_t HASH_SEED = 2166136261u;  // FNV-1a offset basis
+    uint32_t hash() const;
+    static uint32_t hash(const uint8_t* data, size_t length, uint32_t seed = HASH_SEED);
+
+private:
+    struct Viewport {
+        int originX, originY;      // Absolute position of local (0, 0)
+        int width, height;         // Nominal viewport size
+        int clipX0, clipY0;        // Absolute clip rect, [x0, x1) x [y0, y1)
+        int clipX1, clipY1;
+    };
+
+    uint8_t* buffer;
+    int width;
+    int height;
+    int stride;
+    Viewport viewports[FRAMEBUFFER_MAX_VIEWPORTS];
+    int depth;
+
+    // Translate a local rect to absolute coordinates and clip it to the active
+    // viewport; returns false when nothing is left to draw
+    bool clipToViewport(int x, int y, int w, int h, int& x0, int& y0, int& x1, int& y1) const;
+};
+
+#endif // FRAMEBUFFER_H
@@ -5,31 +5,256 @@
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include "config_manager.h"
+#include "png_decoder.h"
+#include "compressed_frame.h"
+#include "frame_patch.h"
+#include "tiled_frame.h"
+#include "frame_cache.h"
+#include "base_map_cache.h"
+#include "frame_bundle.h"
+#include "frame_digest.h"
+#include "screen_renderer.h"
+#include "tls_session_client.h"
+
+// Body bytes received during one wake, over all downloads
+struct DownloadStats {
+    uint32_t bytes;
+    uint32_t chunks;            // Blocking reads that returned data
+    uint32_t minChunk;
+    uint32_t maxChunk;
+    uint16_t stalls;            // Reads that waited over DOWNLOAD_STALL_MS or timed out
+    unsigned long waitMs;       // Time blocked in reads
+    unsigned long wallMs;       // First read to last byte of each body
+};
+
+// Published frame as described by *_manifest.json (Server/utils/frame_manifest.py)
+struct FrameManifest {
+    enum Encoding : uint8_t {
+        ENCODING_BIN = 1,
+        ENCODING_BINZ = 2,
+        ENCODING_EPD_PNG = 4,
+        ENCODING_BPATCH = 8,
+        ENCODING_TILES = 16,
+        ENCODING_BUNDLE = 32,
+        ENCODING_WIDGETS = 64,
+        ENCODING_VMAP = 128
+    };
+    
+    bool loaded;
+    uint32_t hash;              // Framebuffer::hash of the .bin frame
+    uint32_t size;              // .bin bytes
+    uint16_t width;             // .bin frame layout: 800x480 (panel order) unless
+    uint16_t height;            // the manifest says 480x800 (portrait)
+    uint32_t generated;         // Unix time of the server run
+    uint32_t nextUpdate;        // Unix time the next run is expected, 0 if unknown
+    uint32_t patchBase;         // Frame the .bpatch applies to, 0 without one
+    uint8_t encodings;          // Encoding bits of the files published with it
+    bool hasSha256;
+    uint8_t sha256[FrameDigest::SIZE];  // SHA-256 of the .bin frame
+};
 
 class GitHubImageFetcher {
 private:
     ConfigManager* configManager;
+#if TLS_SESSION_RESUMPTION
+    ResumableTlsClient client;
+#else
     WiFiClientSecure client;
+    WiFiClient plainClient;         // http:// sources
+#endif
     HTTPClient http;
+    PngStreamDecoder pngDecoder;
+    CompressedFrame compressedFrame;
+    InflateStream bodyInflater;     // Content-Encoding: gzip responses
+    FramePatch framePatch;
+    TiledFrame tiledFrame;
+    BaseMapCache baseMapCache;
+    FrameCache frameCache;          // Last full frame, the base of patches and tile updates
+    FrameBundle frameBundle;        // Frames of the next hours, shown without WiFi
+    WidgetData widgetData;
     uint8_t* imageBuffer;
     size_t bufferSize;
     bool bufferAllocated;
+    bool portraitImage;
+    uint32_t expectedFrameHash;  // FNV-1a of the .bin from the widget document, 0 if unknown
+    FrameManifest manifest;
+    FrameDigest frameDigest;        // SHA-256 of the frame being received
+    bool digestExpected;
+    uint8_t expectedDigest[FrameDigest::SIZE];
+    
+    // Validators of the last 200 response, kept until the frame is shown
+    bool notModified;
+    uint32_t pendingUrlHash;
+    String pendingEtag;
+    String pendingLastModified;
+    uint32_t pendingBodyBytes;
+    uint32_t pendingFrameHash;      // Frame the pending validators belong to, 0 if unknown
+    bool refreshSkipped;            // The pending frame was not sent to the panel
+    
+    // Freshness of the last 200/206/304 response, for the next wake time
+    struct ResponseFreshness {
+        uint32_t date;              // Date header (server clock), 0 if absent
+        uint32_t expires;           // Expires header, 0 if absent
+        int32_t maxAge;             // Cache-Control max-age less Age, -1 if absent
+        unsigned long receivedMs;   // millis() when the headers arrived
+    } freshness;
+    
+    // Entry of FRAME_SOURCES all URLs of this wake go to, -1 until the first
+    int source;
+    bool sourceSecure;
+    bool sourceRecorded;            // Its result for this wake is in the RTC stats
+    unsigned long sourceConnectMs;
+    
+    // Per-wake cost of the shared keep-alive connection
+    struct ConnectionStats {
+        uint16_t connections;       // TLS handshakes (1 unless the server closed)
+        uint16_t requests;
+        unsigned long handshakeMs;  // DNS + TCP + TLS
+        unsigned long requestMs;    // Request sent until response headers
+        unsigned long maxRequestMs;
+        bool unreachable;           // Connect failed: no more attempts this wake
+    } connectionStats;
+    DownloadStats downloadStats;
     
     String buildImageURL();
-    bool downloadImage(const String& url, uint8_t*& buffer, size_t& size);
+    String buildPngURL();
+    String buildMapAssetURL(const char* suffix);
+    // path (relative to the repository root) on this wake's source
+    String buildSourceURL(const String& path);
+    // Connect to the first reachable source other than skip, the fastest
+    // last-known-good first; false (and no requests this wake) when none answers
+    bool selectSource(int skip = -1);
+    bool connectSource(int index);
+    // url of source from as the same path on the current source
+    String rebaseURL(const String& url, int from);
+    void recordSourceResult(bool ok, unsigned long latencyMs);
+    // Client of the current source: TLS or plain TCP
+    WiFiClient& connection();
+    bool downloadWidgetData(const String& url);
+    // Frames (cacheAs set) also go to the frame cache; a transfer that breaks
+    // off leaves its prefix there and the next call requests only the rest
+    bool downloadImage(const String& url, uint8_t*& buffer, size_t& size,
+                       FrameCache::Format cacheAs = FrameCache::FORMAT_NONE);
+    // rotateToPanel turns a portrait decode into panel (landscape) order
+    bool downloadPngImage(const String& url, bool conditional = true, bool rotateToPanel = false);
+    // Inflate a gzip body of contentLength bytes into buffer; fails when the
+    // result does not fit capacity or the trailer (CRC-32, size) does not match
+    bool inflateBody(uint8_t* buffer, size_t capacity, size_t& length, int contentLength);
+    // All requests of a wake go through http over one TLS connection
+    bool beginRequest(const String& url, uint16_t timeoutMs);
+    int sendRequest();
+    // Keep Date, Expires and Cache-Control max-age of a usable response
+    void recordFreshness();
+    // Keeps the connection open only when the whole body was read
+    void endRequest(bool bodyConsumed);
+    // Conditional GET for the resource on screen (validators in RTC memory)
+    void addConditionalHeaders(HTTPClient& request, const String& url);
+    bool checkNotModified(int httpCode);
+    void rememberValidators(HTTPClient& request, const String& url, int bodyBytes);
+    // Write the buffered frame from url to flash; it replaces the cached
+    // frame in commitValidators()
+    void stageFrameCache(const String& url);
+    // Write a downloaded frame (received of size bytes, from offset on when
+    // resumed) to flash: the whole frame, or the prefix to resume from.
+    // False when a complete frame does not match the published hash
+    bool cacheDownload(const String& url, const uint8_t* data, size_t offset, size_t received,
+                       size_t size, bool resumed, FrameCache::Format format);
+    // A partial .bin download is waiting to be resumed
+    bool hasPartialFrame();
+    // Start hashing the frame when its SHA-256 is published: the manifest's,
+    // else the Digest header of a response whose body is the frame itself
+    void beginFrameDigest(bool bodyIsFrame);
+    // True when no digest was published or the frame matches it
+    bool checkFrameDigest();
+    // Drop the digest of a transfer that failed before checkFrameDigest()
+    void abandonFrameDigest();
+    // Whole frame at once (patched or tiled frames built in RAM)
+    bool checkFrameDigest(const uint8_t* frame, size_t size);
+    // The published .bin is a portrait frame (manifest width/height); raw
+    // frames carry no header, so without a manifest they are panel order
+    bool publishedPortrait() const;
+    // False when the manifest was read and does not list the encoding
+    bool manifestOffers(FrameManifest::Encoding encoding, const char* name);
     void freeBuffer();
     
 public:
     GitHubImageFetcher(ConfigManager* configMgr);
     ~GitHubImageFetcher();
     
+    // Read *_manifest.json (under 1 KB): published frame hash, size and
+    // encodings. When the hash is the frame on screen wasNotModified() is
+    // true and no frame request needs to be made
+    bool fetchManifest();
+    const FrameManifest& getManifest() const { return manifest; }
+    
     bool fetchLatestImage();
+    // Cached last frame patched with the published .bpatch; fails when no
+    // patch exists or it was made for another frame, so the caller falls
+    // back to the full frame
+    bool fetchPatchedFrame();
+    // Cached last frame with its changed tiles replaced from the published
+    // .tiles: one Range request for the index, then at most
+    // TILED_FRAME_MAX_RANGES for the tiles whose hash differs
+    bool fetchTiledFrame();
+    // Base map (from flash when unchanged) plus the current widget data;
+    // the image buffer then holds the portrait base map without overlay
+    bool fetchWidgetFrame();
+    // Landscape .bin frame straight into sink without a frame buffer; true only
+    // when the full frame arrived and matches the published hash (if any)
+    bool streamLatestImage(FrameChunkSink sink, void* sinkContext);
+    // Same for the .binz: inflated with its small window on the way to sink
+    bool streamCompressedImage(FrameChunkSink sink, void* sinkContext);
+    // Last landscape frame from the flash cache into sink, without WiFi
+    bool streamCachedFrame(FrameChunkSink sink, void* sinkContext);
+    // Download the published .bundle into flash; true when it has a frame
+    // due now. A 304 means the bundle in flash is still the latest one
+    bool fetchFrameBundle();
+    // Frame of the bundle in flash to show now, without WiFi: -1 without a
+    // bundle or clock, when it is stale, when nothing is due yet or when its
+    // last frame is already on screen (exhausted)
+    int dueBundleFrame();
+    // The bundle frame index is the one on screen
+    bool isBundleFrameShown(int index);
+    // Inflate a bundle frame from flash into sink; remembered as shown
+    bool streamBundleFrame(int index, FrameChunkSink sink, void* sinkContext);
+    // Seconds until the frame after the one on screen is due, 0 when none
+    uint32_t secondsToNextBundleFrame();
+    // Vector map (.vmap) into the image buffer, rasterised by the display
+    bool fetchVectorMap();
+    const WidgetData& getWidgetData() const { return widgetData; }
     uint8_t* getImageBuffer() const { return imageBuffer; }
     size_t getImageSize() const { return bufferSize; }
     bool hasImage() const { return bufferAllocated && imageBuffer != nullptr; }
+    // Portrait (480x800) frames are rotated by the display while uploading
+    bool isPortraitImage() const { return portraitImage; }
+    // The buffered frame differs from the one on screen (the cached last
+    // frame) in fewer than REFRESH_MIN_CHANGED_PIXELS pixels, counted with
+    // bitplane XOR + popcount: not worth a refresh. Never true twice in a
+    // row, so the panel is at most one small change behind
+    bool isMinorChange();
+    
+    // Seconds until the server publishes the next frame: the manifest's
+    // next_update, else Cache-Control max-age, else Expires of the last
+    // response (0 when overdue). The last two count only when they end
+    // after scheduleS, the fixed sleep. False when no response said
+    bool secondsToNextUpdate(uint32_t& seconds, uint32_t scheduleS);
+    
+    // True when the last request got 304: the frame on screen is current
+    bool wasNotModified() const { return notModified; }
+    // Call once the fetched frame is on screen; its validators go with the
+    // next wake's request and it becomes the base for the next frame patch
+    void commitValidators();
+    // Count a 304 wake and log hit rate, bytes and awake time saved
+    void recordNotModified();
+    
+    // Drop the connection and the source choice before another attempt in
+    // the same wake; a source that just failed is then ranked last
+    void resetConnection();
+    
+    // Handshakes, requests, latency and body throughput of this wake
+    void logConnectionStats() const;
     
     // Testing and debugging
-    bool testConnection();
     String getLastError() const;
 };
 
@@ -0,0 +1,117 @@
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Pull-based input for decoders: copy up to length bytes into buffer and
+// return how many were copied, 0 once the input is exhausted
+typedef size_t (*StreamInput)(void* context, uint8_t* buffer, size_t length);
+
+// Streaming DEFLATE (RFC 1951) decoder with a history window of up to 32 KB.
+// Input is pulled through a StreamInput as needed and output is produced in
+// caller sized pieces, so neither the compressed nor the decompressed data has
+// to be held in memory as a whole. Plain C++ so it can be checked on a host.
+class InflateStream {
+public:
+    static const size_t WINDOW_SIZE = 32768;     // Full DEFLATE window, the default
+    static const size_t MIN_WINDOW_SIZE = 512;
+
+    enum Format {
+        FORMAT_RAW,     // Bare DEFLATE blocks
+        FORMAT_ZLIB,    // RFC 1950 header and Adler-32 trailer (PNG IDAT)
+        FORMAT_GZIP     // RFC 1952 header, CRC-32 and size trailer (Content-Encoding)
+    };
+
+    InflateStream();
+    ~InflateStream();
+
+    // Allocates the window on first use; returns false when out of memory.
+    // Streams known to reference at most windowSize bytes back (a power of
+    // two) can use a smaller window; further distances are an error.
+    bool begin(Format format, StreamInput input, void* context, size_t windowSize = WINDOW_SIZE);
+    void end();
+
+    // Decompress up to length bytes into out. Returns the number of bytes
+    // produced; fewer than length only at the end of the stream or on error.
+    size_t read(uint8_t* out, size_t length);
+
+    bool isFinished() const { return state == STATE_DONE; }
+    bool hasError() const { return state == STATE_ERROR; }
+    const char* getError() const { return error; }
+    uint32_t getTotalIn() const { return totalIn; }
+    uint32_t getTotalOut() const { return totalOut; }
+
+private:
+    static const int FAST_BITS = 9;
+    static const int MAX_BITS = 15;
+
+    // Canonical Huffman code: a FAST_BITS lookup table for short codes
+    // ((length << 9) | symbol, 0 = not in table) and counts/symbols for the rest
+    struct Huffman {
+        uint16_t fast[1 << FAST_BITS];
+        uint16_t count[MAX_BITS + 1];
+        uint16_t symbol[288];
+    };
+
+    enum State {
+        STATE_IDLE,
+        STATE_HEADER,
+        STATE_BLOCK,
+        STATE_STORED,
+        STATE_CODES,
+        STATE_COPY,
+        STATE_TRAILER,
+        STATE_DONE,
+        STATE_ERROR
+    };
+
+    Format format;
+    State state;
+    const char* error;
+
+    StreamInput input;
+    void* inputContext;
+    uint8_t inputBuffer[256];
+    size_t inputPos;
+    size_t inputLength;
+    uint32_t totalIn;
+
+    uint32_t bitBuffer;
+    int bitCount;
+    int paddingBits;            // Zero bits appended past the end of input
+
+    uint8_t* window;
+    size_t windowSize;
+    uint32_t totalOut;          // Also the write position in the window
+    uint32_t adler;
+    uint32_t crc;
+
+    bool lastBlock;
+    bool fixedTablesLoaded;
+    uint32_t storedRemaining;
+    uint32_t copyLength;
+    uint32_t copyDistance;
+
+    Huffman literalCode;
+    Huffman distanceCode;
+
+    bool fillBits(int count);
+    uint32_t getBits(int count);
+    void dropBits(int count);
+    int decodeSymbol(const Huffman& code);
+    bool buildHuffman(Huffman& code, const uint8_t* lengths, int symbols);
+
+    bool readHeader();
+    bool readBlockHeader();
+    bool readDynamicTables();
+    bool readTrailer();
+    void updateCheck(const uint8_t* data, size_t length);
+    void fail(const char* message);
+
+    // Non-copyable: owns its window
+    InflateStream(const InflateStream&);
+    InflateStream& operator=(const InflateStream&);
+};
+
+#endif // INFLATE_STREAM_H
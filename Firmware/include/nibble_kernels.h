@@ -0,0 +1,50 @@
+#ifndef NIBBLE_KERNELS_H
+#define NIBBLE_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Word-parallel kernels for packed 4bpp rows. A uint32_t holds 8 pixels; the
+// layout assumes a little-endian CPU (ESP32-S2 and x86 hosts), so byte n of a
+// word carries pixels 2n (upper nibble) and 2n+1 (lower nibble).
+class NibbleKernels {
+public:
+    // Color replicated into all 8 nibbles of a word
+    static inline uint32_t replicate(uint8_t color) {
+        return (uint32_t)(color & 0x0F) * 0x11111111u;
+    }
+
+    // Masked blend: take src where mask nibbles are 0xF, keep dst elsewhere
+    static inline uint32_t blend(uint32_t dst, uint32_t src, uint32_t mask) {
+        return (dst & ~mask) | (src & mask);
+    }
+
+    // 0xF in every nibble of word that differs from the key color
+    // (keyWord = replicate(keyColor)); SWAR nonzero-nibble detection
+    static inline uint32_t opaqueMask(uint32_t word, uint32_t keyWord) {
+        uint32_t diff = word ^ keyWord;
+        diff |= diff >> 2;
+        diff |= diff >> 1;
+        return (diff & 0x11111111u) * 0xF;
+    }
+
+    // Nibble mask for an 8-bit pixel mask (bit i selects pixel i of the word)
+    static uint32_t pixelMask(uint8_t pixels);
+
+    // Fill pixels [x0, x1) of a packed row
+    static void fillSpan(uint8_t* row, int x0, int x1, uint8_t color);
+
+    // Copy pixels [x0, x1) between two rows with the same layout
+    static void copySpan(uint8_t* dst, const uint8_t* src, int x0, int x1);
+
+    // Blend src into dst through per-pixel masks (one mask byte per 8 pixels)
+    static void blendWords(uint32_t* dst, const uint32_t* src, const uint8_t* pixelMasks, size_t words);
+
+    // Composite src over dst; src pixels equal to keyColor are transparent
+    static void compositeKeyed(uint8_t* dst, const uint8_t* src, size_t bytes, uint8_t keyColor);
+
+    // compositeKeyed for pixels [x0, x1) of two rows with the same layout
+    static void compositeSpan(uint8_t* dst, const uint8_t* src, int x0, int x1, uint8_t keyColor);
+};
+
+#endif // NIBBLE_KERNELS_H
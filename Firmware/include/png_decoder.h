@@ -0,0 +1,66 @@
+#ifndef PNG_DECODER_H
+#define PNG_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "inflate_stream.h"
+
+// Receives each decoded row as packed 4bpp panel pixels (left pixel in the
+// upper nibble, (width + 1) / 2 bytes). Return false to abort decoding.
+typedef bool (*PngRowSink)(void* context, int row, const uint8_t* packedRow, size_t length);
+
+// Streaming PNG decoder for e-paper frames. The file is pulled through a
+// StreamInput, IDAT data is inflated with a 32 KB window and unfiltered one
+// row at a time against the previous row, and pixels are mapped to panel
+// color indices. Memory use is the inflate window plus two raw rows.
+//
+// Supported: non-interlaced indexed (1/2/4/8 bit) and 8-bit RGB/RGBA images.
+// Colors map to the nearest entry of the 7-color panel palette, which is exact
+// for images produced by the server (Server/utils/epaper_visualizer.py).
+class PngStreamDecoder {
+public:
+    PngStreamDecoder();
+    ~PngStreamDecoder();
+
+    bool decode(StreamInput input, void* inputContext, PngRowSink sink, void* sinkContext);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const char* getError() const { return error; }
+    uint32_t getCompressedSize() const { return inflater.getTotalIn(); }
+
+private:
+    StreamInput input;
+    void* inputContext;
+    InflateStream inflater;
+
+    int width;
+    int height;
+    uint8_t bitDepth;
+    uint8_t colorType;
+    uint8_t paletteMap[256];     // Palette index -> panel color
+    bool identityPalette;        // 4-bit palette already in panel order
+    const char* error;
+
+    // Current chunk while streaming IDAT payloads into the inflater
+    uint32_t chunkRemaining;
+    uint32_t chunkCrc;
+    uint32_t chunkType;
+    bool chunkError;
+
+    bool readExact(uint8_t* buffer, size_t length);
+    bool readChunkHeader(uint32_t& length, uint32_t& type);
+    bool readChunkData(uint8_t* buffer, uint32_t length);
+    bool finishChunk();
+    bool skipChunk(uint32_t length);
+    bool readHeader(uint32_t length);
+    bool readPalette(uint32_t length);
+    bool decodeRows(PngRowSink sink, void* sinkContext);
+    void packRow(const uint8_t* raw, uint8_t* packed) const;
+    bool fail(const char* message);
+
+    // Feeds the payload of consecutive IDAT chunks to the inflater
+    static size_t readImageData(void* context, uint8_t* buffer, size_t length);
+};
+
+#endif // PNG_DECODER_H
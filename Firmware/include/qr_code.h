@@ -1,7 +1,7 @@
 #ifndef QR_CODE_H
 #define QR_CODE_H
 
-#include <Arduino.h>
+#include <stdint.h>
 
 class QRCode {
 public:
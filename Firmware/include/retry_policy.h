@@ -0,0 +1,34 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// What to do after a failed update, with its state in RTC memory so it
+// carries over deep sleep. A failure episode starts with the first wake that
+// could not update and ends with the next one that could. Within a wake the
+// update is retried RETRY_IN_WAKE times after short jittered delays; then
+// the device sleeps RETRY_BACKOFF_MIN_S, doubled with every further failed
+// wake up to RETRY_BACKOFF_MAX_S, instead of retrying with WiFi up.
+class RetryPolicy {
+public:
+    RetryPolicy();
+
+    // Delay before the next attempt of this wake (RETRY_DELAY_MS doubled
+    // per attempt, +/-50% jitter); 0 once the wake's retries are used up
+    uint32_t nextRetryDelayMs();
+    // The wake gave up: grow the backoff. radioMs is this wake's WiFi-on time
+    void recordFailure(unsigned long radioMs);
+    // An update went through or the frame on screen is current: end the episode
+    void recordSuccess(unsigned long radioMs);
+
+    // Last wake failed: sleep getBackoffSeconds() rather than the schedule
+    bool isBackingOff() const;
+    uint32_t getBackoffSeconds() const;
+    void logState() const;
+
+private:
+    int attempts;   // Retries made in this wake
+};
+
+#endif // RETRY_POLICY_H
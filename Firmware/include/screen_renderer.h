@@ -0,0 +1,39 @@
+#ifndef SCREEN_RENDERER_H
+#define SCREEN_RENDERER_H
+
+#include "framebuffer.h"
+
+// Contents of the <map>_widgets.json document published next to each map
+struct WidgetData {
+    char city[32];
+    char country[32];
+    float latitude;
+    float longitude;
+    char date[24];              // e.g. "18 October"
+    char time[8];               // e.g. "14:30"
+    bool hasWeather;
+    int temperature;            // Degrees Celsius
+    char icon[4];               // OpenWeatherMap icon code, e.g. "10d"
+    uint32_t baseMapHash;       // Framebuffer::hash of the base map frame
+};
+
+// Rasterises the firmware's built-in screens into a packed 4bpp frame.
+// Kept free of display and Arduino dependencies so every screen can be
+// rendered, hashed and timed off-device as well as on the ESP32-S2.
+class ScreenRenderer {
+public:
+    static void renderConfigurationQR(Framebuffer& fb);
+    static void renderSimpleMessage(Framebuffer& fb, const char* message);
+    static void renderBatteryOverlay(Framebuffer& fb, int percentage);
+    static void renderColorTest(Framebuffer& fb);
+    // Information box (city, coordinates, date/time, weather) drawn over a
+    // portrait 480x800 base map, laid out like Server/image_composition/overlay.py
+    static void renderWeatherWidget(Framebuffer& fb, const WidgetData& data);
+
+private:
+    static void drawBatteryIcon(Framebuffer& fb, int x, int y, int percentage);
+    static void drawWeatherIcon(Framebuffer& fb, int x, int y, int size, const char* icon);
+    static void drawCloud(Framebuffer& fb, int x, int y, int size);
+};
+
+#endif // SCREEN_RENDERER_H
@@ -0,0 +1,75 @@
+#ifndef TILED_FRAME_H
+#define TILED_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "inflate_stream.h"
+#include "config.h"
+
+// Tiled landscape frame (.tiles) produced by Server/utils/tiled_frame.py: the
+// panel frame cut into 80x48 pixel tiles (40 bytes x 48 rows), each its own
+// raw DEFLATE stream, behind an index of tile hashes and data offsets. Every
+// tile is one contiguous byte range, so a device that holds an older frame
+// requests only the tiles whose hash differs.
+//
+//   Header (20 bytes, little-endian)
+//     uint32 magic "TILE", uint8 version, uint8 window bits, uint16 width,
+//     uint16 height, uint16 tile width, uint16 tile height, uint16 tile count,
+//     uint32 FNV-1a hash of the frame
+//   Index: uint32 tile hash, uint32 end offset of the tile data, per tile
+//   Tile data, row-major, starting right after the index
+class TiledFrame {
+public:
+    static const uint32_t MAGIC = 0x454C4954;  // "TILE"
+    static const uint8_t VERSION = 1;
+    static const int HEADER_SIZE = 20;
+    static const int ENTRY_SIZE = 8;
+    static const int TILE_WIDTH = 80;
+    static const int TILE_HEIGHT = 48;
+    static const int TILE_STRIDE = TILE_WIDTH / 2;
+    static const int COLUMNS = DISPLAY_WIDTH / TILE_WIDTH;
+    static const int TILE_COUNT = COLUMNS * (DISPLAY_HEIGHT / TILE_HEIGHT);
+    static const size_t INDEX_SIZE = HEADER_SIZE + ENTRY_SIZE * TILE_COUNT;
+
+    // Tiles [first, end) in index order, one byte range of the file
+    struct Range {
+        uint16_t first;
+        uint16_t end;
+    };
+
+    TiledFrame();
+
+    // Validate header and index (INDEX_SIZE bytes from the start of the file)
+    bool parseIndex(const uint8_t* data, size_t length);
+
+    // Tiles of frame whose hash differs from the index, as at most maxRanges
+    // ranges: runs of changed tiles, the closest ones merged until they fit
+    int planRanges(const uint8_t* frame, Range* ranges, int maxRanges);
+    // File offsets of a range: first byte and one past the last
+    uint32_t rangeStart(const Range& range) const;
+    uint32_t rangeEnd(const Range& range) const;
+
+    // Inflate the tiles of range from input (positioned at rangeStart) into
+    // frame; each tile must use exactly its bytes and match its hash
+    bool decodeRange(const Range& range, StreamInput input, void* context, uint8_t* frame);
+    void end();
+
+    uint32_t getFrameHash() const { return frameHash; }
+    int getChangedTiles() const { return changedTiles; }
+    const char* getError() const { return error; }
+
+private:
+    InflateStream inflater;
+    uint32_t tileHash[TILE_COUNT];
+    uint32_t tileEnd[TILE_COUNT];   // Relative to the end of the index
+    uint32_t frameHash;
+    size_t windowSize;
+    int changedTiles;
+    const char* error;
+
+    uint32_t tileStart(int tile) const { return tile == 0 ? 0 : tileEnd[tile - 1]; }
+    static uint32_t hashTile(const uint8_t* frame, int tile);
+    bool fail(const char* message);
+};
+
+#endif // TILED_FRAME_H
@@ -0,0 +1,103 @@
+#ifndef TLS_SESSION_CLIENT_H
+#define TLS_SESSION_CLIENT_H
+
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/net_sockets.h>
+#include "config.h"
+
+// TLS client that resumes the previous wake's session. WiFiClientSecure
+// negotiates a fresh session on every connect and loses it in deep sleep;
+// this client offers the session (ticket or session ID plus master secret)
+// saved in RTC memory, so the server can answer with an abbreviated
+// handshake: no certificate, no key exchange. Like setInsecure(), the
+// server certificate is not verified.
+//
+// Drop-in for HTTPClient::begin(WiFiClient&, url): the TCP connection is a
+// plain WiFiClient and mbedtls runs on top of it. With setPlaintext(true)
+// the next connect skips TLS altogether (http:// sources) and reads still
+// wait in select() the same way.
+class ResumableTlsClient : public WiFiClient {
+public:
+    ResumableTlsClient();
+    ~ResumableTlsClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout) override;
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() { return connected(); }
+
+    // Read up to size bytes, waiting for the first one in select() on the
+    // socket rather than polling: bytes read, 0 when timeoutMs passed
+    // without data, -1 once the connection is closed
+    int receive(uint8_t* buffer, size_t size, uint32_t timeoutMs);
+
+    // Serialise the current session into RTC memory for the next wake
+    bool saveSession();
+    bool wasResumed() const { return resumed; }
+    // Takes effect on the next connect
+    void setPlaintext(bool enabled) { plaintext = enabled; }
+    bool isPlaintext() const { return plaintext; }
+    unsigned long getHandshakeMs() const { return handshakeMs; }
+
+private:
+    WiFiClient tcp;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    bool rngReady;
+    bool sslReady;
+    bool established;
+    bool resumed;
+    bool sessionSaved;
+    bool plaintext;
+    unsigned long handshakeMs;
+    int peeked;            // Byte returned by peek(), -1 if none
+    uint32_t hostHash;
+
+    // Plaintext TLS 1.2 records the server sends before its ChangeCipherSpec,
+    // followed only as far as handshake message types: a full handshake has
+    // a Certificate message there, a resumed one goes straight to CCS. Needs
+    // no mbedtls internals; under TLS 1.3 the certificate is encrypted and
+    // every handshake with a saved session would count as resumed.
+    struct HandshakeScan {
+        bool active;
+        uint8_t header[5];
+        uint8_t headerLength;
+        uint8_t recordType;
+        uint16_t recordLeft;
+        uint8_t messageHeaderLength;
+        uint32_t messageLeft;
+        bool certificateSeen;
+    };
+    HandshakeScan scan;
+
+    bool handshake(const char* host, int32_t timeout);
+    bool offerSavedSession();
+    void scanHandshake(const uint8_t* data, size_t length);
+    bool waitReadable(uint32_t timeoutMs);
+    bool waitWritable(uint32_t timeoutMs);
+    void freeSsl();
+    static int sendCallback(void* context, const unsigned char* buffer, size_t length);
+    static int receiveCallback(void* context, unsigned char* buffer, size_t length);
+
+    // Non-copyable: owns the mbedtls contexts
+    ResumableTlsClient(const ResumableTlsClient&);
+    ResumableTlsClient& operator=(const ResumableTlsClient&);
+};
+
+#endif // TLS_SESSION_CLIENT_H
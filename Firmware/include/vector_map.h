@@ -0,0 +1,102 @@
+#ifndef VECTOR_MAP_H
+#define VECTOR_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "framebuffer.h"
+
+// Compact vector map (.vmap) produced by Server/utils/vector_map_encoder.py:
+// quantised, delta-encoded polygons and polylines in panel (landscape)
+// coordinates, one style per layer, drawn in file order.
+//
+//   Header (16 bytes, little-endian)
+//     uint32 magic "VMAP", uint8 version, uint8 precision (fractional bits),
+//     uint8 background color, uint8 layer count, uint16 width, uint16 height,
+//     uint32 FNV-1a hash of everything after the header
+//   Layer
+//     uint8 kind (fill/line), uint8 color, uint8 line width in pixels,
+//     varint feature count
+//   Feature
+//     varint part count; per part a varint point count followed by
+//     zigzag varint (dx, dy) pairs relative to the previous point of the layer
+//
+// Fill features are rasterised with an even-odd scanline filler (all parts of
+// a feature form one polygon, so holes work), lines as one quad per segment
+// with round joins. Rendering works on any band of panel rows, so a frame can
+// be streamed to the panel without a full frame buffer.
+class VectorMap {
+public:
+    static const uint32_t MAGIC = 0x50414D56;  // "VMAP"
+    static const uint8_t VERSION = 1;
+    static const int HEADER_SIZE = 16;
+    static const int MAX_PRECISION = 4;
+    // Largest polygon the device agrees to fill (scratch is ~24 bytes/point)
+    static const size_t MAX_FEATURE_POINTS = 8192;
+
+    // Panel rows rendered per band when streaming
+    static const int BAND_ROWS = 24;
+    static const int BAND_SIZE = BAND_ROWS * (DISPLAY_WIDTH / 2);
+
+    enum LayerKind {
+        LAYER_FILL = 0,
+        LAYER_LINE = 1
+    };
+
+    VectorMap();
+    ~VectorMap();
+
+    // Validate the whole file (hash, structure, coordinate ranges) and size
+    // the scratch buffers. data must stay valid while rendering.
+    bool load(const uint8_t* data, size_t length);
+
+    // Render panel rows [top, top + band.getHeight()) into band
+    void renderBand(Framebuffer& band, int top) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getLayerCount() const { return layerCount; }
+    size_t getFeatureCount() const { return featureCount; }
+    size_t getPointCount() const { return pointCount; }
+    const char* getError() const { return error; }
+
+private:
+    struct Edge {
+        int32_t x0, y0;   // Upper end (y0 < y1)
+        int32_t x1, y1;
+    };
+
+    const uint8_t* data;
+    size_t length;
+    int precision;
+    int width;
+    int height;
+    uint8_t background;
+    int layerCount;
+    size_t featureCount;
+    size_t pointCount;
+    size_t maxFeaturePoints;
+    const char* error;
+
+    // Per-feature scratch, sized for the largest feature in load()
+    int32_t* points;      // x, y pairs of one part
+    Edge* edges;          // Edges of all rings of one fill feature
+    int32_t* crossings;
+    uint16_t* active;
+
+    void freeScratch();
+    bool fail(const char* message);
+    static int compareEdges(const void* a, const void* b);
+
+    // Fill the even-odd interior of edges into the band; sorts edgeList
+    void fillEdges(Framebuffer& band, int top, Edge* edgeList, size_t count,
+                   int32_t* xs, uint16_t* activeList, uint8_t color) const;
+    void drawPolyline(Framebuffer& band, int top, const int32_t* pts,
+                      size_t count, int lineWidth, uint8_t color) const;
+
+    // Non-copyable: owns its scratch buffers
+    VectorMap(const VectorMap&);
+    VectorMap& operator=(const VectorMap&);
+};
+
+#endif // VECTOR_MAP_H
@@ -0,0 +1,106 @@
+#include "base_map_cache.h"
+#include "cache_fs.h"
+#include "framebuffer.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <LittleFS.h>
+
+#define BASE_MAP_MAGIC      0x50414D42  // "BMAP"
+#define BASE_MAP_FILE       "/basemap.bin"
+#define BASE_MAP_TEMP_FILE  "/basemap.tmp"
+
+BaseMapCache::BaseMapCache() : mounted(false) {
+}
+
+bool BaseMapCache::begin() {
+    if (mounted) return true;
+    
+    if (!CacheFs::begin()) {
+        Serial.println("Base map cache: failed to mount LittleFS");
+        return false;
+    }
+    
+    mounted = true;
+    return true;
+}
+
+bool BaseMapCache::readHeader(Header& header) {
+    File file = LittleFS.open(BASE_MAP_FILE, "r");
+    if (!file) return false;
+    
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.magic == BASE_MAP_MAGIC;
+    file.close();
+    return ok;
+}
+
+uint32_t BaseMapCache::getStoredHash() {
+    Header header;
+    if (!begin() || !readHeader(header)) return 0;
+    return header.hash;
+}
+
+bool BaseMapCache::load(uint8_t* frame, size_t size, uint32_t expectedHash) {
+    if (!begin()) return false;
+    
+    File file = LittleFS.open(BASE_MAP_FILE, "r");
+    if (!file) {
+        Serial.println("Base map cache: empty");
+        return false;
+    }
+    
+    Header header;
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != BASE_MAP_MAGIC || header.size != size) {
+        Serial.println("Base map cache: invalid header");
+        file.close();
+        return false;
+    }
+    
+    if (header.hash != expectedHash) {
+        Serial.printf("Base map cache: stale (have 0x%08X, need 0x%08X)\n", header.hash, expectedHash);
+        file.close();
+        return false;
+    }
+    
+    unsigned long readStart = millis();
+    size_t bytesRead = file.read(frame, size);
+    file.close();
+    
+    if (bytesRead != size || Framebuffer::hash(frame, size) != expectedHash) {
+        Serial.println("Base map cache: corrupted frame");
+        return false;
+    }
+    
+    Serial.printf("Base map cache: loaded 0x%08X in %lu ms\n", expectedHash, millis() - readStart);
+    return true;
+}
+
+bool BaseMapCache::store(const uint8_t* frame, size_t size, uint32_t hash) {
+    if (!begin()) return false;
+    
+    unsigned long writeStart = millis();
+    File file = LittleFS.open(BASE_MAP_TEMP_FILE, "w");
+    if (!file) {
+        Serial.println("Base map cache: cannot create file");
+        return false;
+    }
+    
+    Header header = { BASE_MAP_MAGIC, hash, (uint32_t)size };
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write(frame, size) == size;
+    file.close();
+    
+    // Swap in the new file only once it is complete
+    if (ok) {
+        LittleFS.remove(BASE_MAP_FILE);
+        ok = LittleFS.rename(BASE_MAP_TEMP_FILE, BASE_MAP_FILE);
+    }
+    
+    if (!ok) {
+        Serial.println("Base map cache: write failed");
+        LittleFS.remove(BASE_MAP_TEMP_FILE);
+        return false;
+    }
+    
+    Serial.printf("Base map cache: stored 0x%08X in %lu ms\n", hash, millis() - writeStart);
+    return true;
+}
@@ -0,0 +1,180 @@
+#include "bitplane_frame.h"
+#include "nibble_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Gather bit `plane` of the 8 pixels in a packed word into one byte, pixel i
+// at bit i. Nibble k of a little-endian word holds pixel k ^ 1.
+static inline uint8_t gatherPlaneBits(uint32_t packed, int plane) {
+    uint32_t bits = (packed >> plane) & 0x11111111u;  // Bit 4k = nibble k
+    bits |= bits >> 3;
+    bits &= 0x03030303u;                               // Nibble pairs
+    bits |= bits >> 6;
+    bits &= 0x000F000Fu;                               // Nibble quads
+    bits |= bits >> 12;
+    uint8_t nibbleOrder = bits & 0xFF;
+    // Swap adjacent bits: nibble order -> pixel order
+    return ((nibbleOrder & 0x55) << 1) | ((nibbleOrder >> 1) & 0x55);
+}
+
+static inline uint32_t loadPacked(const uint8_t* p) {
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+BitplaneFrame::BitplaneFrame(int width, int height) :
+    width(width), height(height), wordsPerRow(width / 32), wordsPerPlane(0) {
+    for (int plane = 0; plane < PLANES; plane++) {
+        planes[plane] = nullptr;
+    }
+
+    if (width <= 0 || height <= 0 || width % 32 != 0) return;
+
+    wordsPerPlane = wordsPerRow * height;
+    uint32_t* storage = (uint32_t*)calloc(wordsPerPlane * PLANES, sizeof(uint32_t));
+    if (!storage) {
+        wordsPerPlane = 0;
+        return;
+    }
+
+    for (int plane = 0; plane < PLANES; plane++) {
+        planes[plane] = storage + plane * wordsPerPlane;
+    }
+}
+
+BitplaneFrame::~BitplaneFrame() {
+    free(planes[0]);
+}
+
+void BitplaneFrame::fromPacked(const uint8_t* packed) {
+    fromPacked(packed, 0, wordsPerPlane * 16);
+}
+
+bool BitplaneFrame::fromPacked(const uint8_t* packed, size_t offset, size_t length) {
+    if (!isAllocated() || offset % 16 != 0 || length % 16 != 0 || offset + length > wordsPerPlane * 16) {
+        return false;
+    }
+
+    // Each plane word covers 32 pixels = 16 packed bytes = 4 packed words
+    size_t first = offset / 16;
+    for (size_t i = first; i < first + length / 16; i++) {
+        const uint8_t* src = packed + (i - first) * 16;
+        uint32_t p0 = 0, p1 = 0, p2 = 0;
+
+        for (int part = 0; part < 4; part++) {
+            uint32_t word = loadPacked(src + part * 4);
+            int shift = part * 8;
+            p0 |= (uint32_t)gatherPlaneBits(word, 0) << shift;
+            p1 |= (uint32_t)gatherPlaneBits(word, 1) << shift;
+            p2 |= (uint32_t)gatherPlaneBits(word, 2) << shift;
+        }
+
+        planes[0][i] = p0;
+        planes[1][i] = p1;
+        planes[2][i] = p2;
+    }
+    return true;
+}
+
+void BitplaneFrame::toPacked(uint8_t* packed) const {
+    if (!isAllocated()) return;
+
+    for (size_t i = 0; i < wordsPerPlane; i++) {
+        uint8_t* dst = packed + i * 16;
+
+        for (int part = 0; part < 4; part++) {
+            int shift = part * 8;
+            // pixelMask spreads pixel bits to their nibbles (0xF each); keep bit 0
+            uint32_t word = (NibbleKernels::pixelMask((planes[0][i] >> shift) & 0xFF) & 0x11111111u)
+                          | (NibbleKernels::pixelMask((planes[1][i] >> shift) & 0xFF) & 0x22222222u)
+                          | (NibbleKernels::pixelMask((planes[2][i] >> shift) & 0xFF) & 0x44444444u);
+            memcpy(dst + part * 4, &word, sizeof(word));
+        }
+    }
+}
+
+void BitplaneFrame::colorMask(uint8_t color, uint32_t* mask) const {
+    // Invert each plane where the color's bit is 0, then AND the planes
+    uint32_t invert0 = (color & 1) ? 0 : 0xFFFFFFFFu;
+    uint32_t invert1 = (color & 2) ? 0 : 0xFFFFFFFFu;
+    uint32_t invert2 = (color & 4) ? 0 : 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < wordsPerPlane; i++) {
+        mask[i] = (planes[0][i] ^ invert0) & (planes[1][i] ^ invert1) & (planes[2][i] ^ invert2);
+    }
+}
+
+size_t BitplaneFrame::countColor(uint8_t color) const {
+    uint32_t invert0 = (color & 1) ? 0 : 0xFFFFFFFFu;
+    uint32_t invert1 = (color & 2) ? 0 : 0xFFFFFFFFu;
+    uint32_t invert2 = (color & 4) ? 0 : 0xFFFFFFFFu;
+    size_t count = 0;
+
+    for (size_t i = 0; i < wordsPerPlane; i++) {
+        count += __builtin_popcount((planes[0][i] ^ invert0) & (planes[1][i] ^ invert1) & (planes[2][i] ^ invert2));
+    }
+    return count;
+}
+
+void BitplaneFrame::diffMask(const BitplaneFrame& a, const BitplaneFrame& b, uint32_t* mask) {
+    if (a.wordsPerPlane != b.wordsPerPlane) return;
+
+    for (size_t i = 0; i < a.wordsPerPlane; i++) {
+        mask[i] = (a.planes[0][i] ^ b.planes[0][i]) | (a.planes[1][i] ^ b.planes[1][i]) | (a.planes[2][i] ^ b.planes[2][i]);
+    }
+}
+
+size_t BitplaneFrame::countChangedPixels(const BitplaneFrame& a, const BitplaneFrame& b) {
+    if (a.wordsPerPlane != b.wordsPerPlane) return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < a.wordsPerPlane; i++) {
+        count += __builtin_popcount((a.planes[0][i] ^ b.planes[0][i]) | (a.planes[1][i] ^ b.planes[1][i]) | (a.planes[2][i] ^ b.planes[2][i]));
+    }
+    return count;
+}
+
+bool BitplaneFrame::changedRows(const BitplaneFrame& a, const BitplaneFrame& b, int& firstRow, int& lastRow) {
+    firstRow = -1;
+    lastRow = -1;
+    if (a.wordsPerPlane != b.wordsPerPlane || a.wordsPerPlane == 0) return false;
+
+    for (int row = 0; row < a.height; row++) {
+        size_t start = row * a.wordsPerRow;
+        uint32_t changed = 0;
+
+        for (size_t i = start; i < start + a.wordsPerRow; i++) {
+            changed |= (a.planes[0][i] ^ b.planes[0][i]) | (a.planes[1][i] ^ b.planes[1][i]) | (a.planes[2][i] ^ b.planes[2][i]);
+        }
+
+        if (changed) {
+            if (firstRow < 0) firstRow = row;
+            lastRow = row;
+        }
+    }
+    return firstRow >= 0;
+}
+
+void BitplaneFrame::maskedCopy(const BitplaneFrame& src, const uint32_t* mask) {
+    if (src.wordsPerPlane != wordsPerPlane) return;
+
+    for (int plane = 0; plane < PLANES; plane++) {
+        uint32_t* dst = planes[plane];
+        const uint32_t* from = src.planes[plane];
+        for (size_t i = 0; i < wordsPerPlane; i++) {
+            dst[i] = (dst[i] & ~mask[i]) | (from[i] & mask[i]);
+        }
+    }
+}
+
+uint32_t BitplaneFrame::hash() const {
+    uint32_t h = 2166136261u;
+    for (int plane = 0; plane < PLANES && isAllocated(); plane++) {
+        for (size_t i = 0; i < wordsPerPlane; i++) {
+            h ^= planes[plane][i];
+            h *= 16777619u;
+        }
+    }
+    return h;
+}
@@ -0,0 +1,81 @@
+#include "cache_fs.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <LittleFS.h>
+#include <esp_partition.h>
+
+#define CACHE_FS_PARTITION  "spiffs"
+#define LAYOUT_FILE         "/layout.bin"
+#define LAYOUT_MAGIC        0x5459414C  // "LAYT"
+
+// Partition the file system was formatted on
+struct Layout {
+    uint32_t magic;
+    uint32_t address;
+    uint32_t size;
+};
+
+bool CacheFs::mounted = false;
+
+static bool readLayout(Layout& layout) {
+    File file = LittleFS.open(LAYOUT_FILE, "r");
+    if (!file) return false;
+
+    bool ok = file.read((uint8_t*)&layout, sizeof(layout)) == sizeof(layout) && layout.magic == LAYOUT_MAGIC;
+    file.close();
+    return ok;
+}
+
+static bool writeLayout(const Layout& layout) {
+    File file = LittleFS.open(LAYOUT_FILE, "w");
+    if (!file) return false;
+
+    bool ok = file.write((const uint8_t*)&layout, sizeof(layout)) == sizeof(layout);
+    file.close();
+    return ok;
+}
+
+bool CacheFs::begin() {
+    if (mounted) return true;
+
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+                                                                CACHE_FS_PARTITION);
+    if (!partition) {
+        Serial.printf("Cache FS: no \"%s\" partition (see partitions.csv)\n", CACHE_FS_PARTITION);
+        return false;
+    }
+    Layout expected = { LAYOUT_MAGIC, partition->address, partition->size };
+
+    // Unformatted, or formatted at another offset: nothing to keep
+    bool fresh = false;
+    if (!LittleFS.begin(false)) {
+        Serial.printf("Cache FS: no file system at 0x%06X, formatting\n", expected.address);
+        if (!LittleFS.format() || !LittleFS.begin(false)) {
+            Serial.println("Cache FS: format failed");
+            return false;
+        }
+        fresh = true;
+    }
+
+    // Mounted, but made for another partition (resized by a new
+    // partitions.csv, or from before the layout was recorded)
+    Layout stored;
+    if (!fresh && (!readLayout(stored) || stored.address != expected.address || stored.size != expected.size)) {
+        Serial.printf("Cache FS: partition changed to 0x%06X/%u KB, formatting; caches are downloaded again\n",
+                      expected.address, expected.size / 1024);
+        LittleFS.end();
+        if (!LittleFS.format() || !LittleFS.begin(false)) {
+            Serial.println("Cache FS: format failed");
+            return false;
+        }
+        fresh = true;
+    }
+
+    if (fresh && !writeLayout(expected)) {
+        Serial.println("Cache FS: could not record the partition layout");
+    }
+
+    mounted = true;
+    Serial.printf("Cache FS: %u of %u bytes used\n", (unsigned)LittleFS.usedBytes(), (unsigned)LittleFS.totalBytes());
+    return true;
+}
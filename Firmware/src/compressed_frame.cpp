@@ -0,0 +1,92 @@
+#include "compressed_frame.h"
+#include "framebuffer.h"
+#include "frame_transpose.h"
+
+static inline uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+CompressedFrame::CompressedFrame() :
+    width(0), height(0), frameSize(0), windowSize(0), frameHash(0),
+    produced(0), runningHash(Framebuffer::HASH_SEED), error(nullptr) {
+}
+
+bool CompressedFrame::fail(const char* message) {
+    if (!error) error = message;
+    return false;
+}
+
+bool CompressedFrame::begin(StreamInput input, void* context) {
+    error = nullptr;
+    produced = 0;
+    runningHash = Framebuffer::HASH_SEED;
+
+    uint8_t header[HEADER_SIZE];
+    size_t filled = 0;
+    while (filled < sizeof(header)) {
+        size_t received = input(context, header + filled, sizeof(header) - filled);
+        if (received == 0) return fail("truncated header");
+        filled += received;
+    }
+
+    if (readLE32(header) != MAGIC) return fail("not a .binz frame");
+    if (header[4] != VERSION) return fail("unsupported version");
+
+    int windowBits = header[5];
+    if (windowBits < MIN_WINDOW_BITS || windowBits > MAX_WINDOW_BITS) {
+        return fail("unsupported window size");
+    }
+
+    width = readLE16(header + 6);
+    height = readLE16(header + 8);
+    frameHash = readLE32(header + 12);
+    bool landscape = width == DISPLAY_WIDTH && height == DISPLAY_HEIGHT;
+    bool portrait = width == PORTRAIT_WIDTH && height == PORTRAIT_HEIGHT;
+    if (!landscape && !portrait) return fail("unexpected frame dimensions");
+
+    frameSize = (size_t)width * height / 2;
+    windowSize = (size_t)1 << windowBits;
+    if (!inflater.begin(InflateStream::FORMAT_RAW, input, context, windowSize)) {
+        return fail(inflater.getError());
+    }
+    return true;
+}
+
+size_t CompressedFrame::read(uint8_t* out, size_t length) {
+    if (error || produced >= frameSize) {
+        return 0;
+    }
+    if (length > frameSize - produced) {
+        length = frameSize - produced;
+    }
+
+    size_t count = inflater.read(out, length);
+    if (count < length) {
+        fail(inflater.hasError() ? inflater.getError() : "frame data ended early");
+    }
+    runningHash = Framebuffer::hash(out, count, runningHash);
+    produced += count;
+    return count;
+}
+
+bool CompressedFrame::finish() {
+    if (error) return false;
+    if (produced != frameSize) return fail("frame incomplete");
+
+    // Drive the inflater to the end of the stream: nothing may follow the frame
+    uint8_t extra;
+    if (inflater.read(&extra, 1) != 0) return fail("data past the end of the frame");
+    if (!inflater.isFinished()) {
+        return fail(inflater.hasError() ? inflater.getError() : "stream not terminated");
+    }
+    if (runningHash != frameHash) return fail("frame hash mismatch");
+    return true;
+}
+
+void CompressedFrame::end() {
+    inflater.end();
+}
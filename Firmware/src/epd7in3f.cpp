@@ -217,6 +217,44 @@ void EPD7in3f::display(const UBYTE *image) {
     turnOnDisplay();
 }
 
+void EPD7in3f::displayPortrait(const UBYTE *image) {
+    // One band of landscape rows; the panel takes the frame in row order
+    static UBYTE band[FrameTranspose::BAND_SIZE];
+
+    sendCommand(0x10);
+    for (int b = 0; b < FrameTranspose::BAND_COUNT; b++) {
+        FrameTranspose::portraitBand(image, b, band);
+        for (int i = 0; i < FrameTranspose::BAND_SIZE; i++) {
+            sendData(band[i]);
+        }
+    }
+    turnOnDisplay();
+}
+
+void EPD7in3f::beginFrame(void) {
+    sendCommand(0x10);
+}
+
+void EPD7in3f::sendFrameData(const UBYTE *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        sendData(data[i]);
+    }
+}
+
+void EPD7in3f::displayBands(EpdBandRenderer render, void* context, UBYTE* band, int bandRows) {
+    UWORD Width = (EPD_WIDTH % 2 == 0)? (EPD_WIDTH / 2 ): (EPD_WIDTH / 2 + 1);
+
+    sendCommand(0x10);
+    for (int top = 0; top < EPD_HEIGHT; top += bandRows) {
+        int rows = (top + bandRows <= EPD_HEIGHT) ? bandRows : EPD_HEIGHT - top;
+        render(context, band, top, rows);
+        for (int i = 0; i < rows * Width; i++) {
+            sendData(band[i]);
+        }
+    }
+    turnOnDisplay();
+}
+
 void EPD7in3f::displayPart(const UBYTE *image, UWORD xstart, UWORD ystart, 
                            UWORD image_width, UWORD image_height) {
     UWORD Width, Height;
@@ -0,0 +1,195 @@
+#include "frame_bundle.h"
+#include "cache_fs.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <LittleFS.h>
+
+#define FRAME_BUNDLE_FILE       "/bundle.bin"
+#define FRAME_BUNDLE_TEMP_FILE  "/bundle.tmp"
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Hands the decoder the bytes of one frame of the bundle file
+struct BundleInput {
+    File* file;
+    uint32_t remaining;
+};
+
+static size_t readBundleFrame(void* context, uint8_t* buffer, size_t length) {
+    BundleInput* input = (BundleInput*)context;
+    if (length > input->remaining) length = input->remaining;
+    if (length == 0) return 0;
+
+    size_t received = input->file->read(buffer, length);
+    input->remaining -= received;
+    return received;
+}
+
+FrameBundle::FrameBundle() :
+    mounted(false), loaded(false), count(0), created(0), staleAfter(0), writeSize(0), written(0) {
+    memset(entries, 0, sizeof(entries));
+}
+
+bool FrameBundle::begin() {
+    if (mounted) return true;
+
+    // Same file system as the base map cache
+    if (!CacheFs::begin()) {
+        Serial.println("Frame bundle: failed to mount LittleFS");
+        return false;
+    }
+    mounted = true;
+
+    if (readIndex(FRAME_BUNDLE_FILE)) {
+        Serial.printf("Frame bundle: %d frames, created %u, stale after %u\n", count, created, staleAfter);
+    }
+    return true;
+}
+
+bool FrameBundle::readIndex(const char* path) {
+    loaded = false;
+    File file = LittleFS.open(path, "r");
+    if (!file) return false;
+
+    uint8_t header[HEADER_SIZE + ENTRY_SIZE * FRAME_BUNDLE_MAX_FRAMES];
+    size_t fileSize = file.size();
+    size_t headerBytes = file.read(header, sizeof(header));
+    file.close();
+
+    if (headerBytes < HEADER_SIZE || readLE32(header) != MAGIC || header[4] != VERSION) {
+        Serial.println("Frame bundle: not a frame bundle");
+        return false;
+    }
+    int frames = header[5];
+    size_t indexSize = HEADER_SIZE + ENTRY_SIZE * frames;
+    if (frames < 1 || frames > FRAME_BUNDLE_MAX_FRAMES || headerBytes < indexSize) {
+        Serial.printf("Frame bundle: %d frames, at most %d supported\n", frames, FRAME_BUNDLE_MAX_FRAMES);
+        return false;
+    }
+
+    const uint8_t* entry = header + HEADER_SIZE;
+    for (int i = 0; i < frames; i++, entry += ENTRY_SIZE) {
+        Entry& e = entries[i];
+        e.displayAt = readLE32(entry);
+        e.offset = readLE32(entry + 4);
+        e.length = readLE32(entry + 8);
+        e.hash = readLE32(entry + 12);
+
+        if (e.offset < indexSize || e.length <= CompressedFrame::HEADER_SIZE || e.offset + e.length > fileSize ||
+            (i > 0 && e.displayAt <= entries[i - 1].displayAt)) {
+            Serial.printf("Frame bundle: invalid entry %d\n", i);
+            return false;
+        }
+    }
+
+    count = frames;
+    created = readLE32(header + 8);
+    staleAfter = readLE32(header + 12);
+    loaded = true;
+    return true;
+}
+
+int FrameBundle::dueFrame(uint32_t now) const {
+    int due = -1;
+    for (int i = 0; i < count && entries[i].displayAt <= now; i++) {
+        due = i;
+    }
+    return loaded ? due : -1;
+}
+
+bool FrameBundle::stream(int index, FrameChunkSink sink, void* context) {
+    if (!loaded || index < 0 || index >= count) return false;
+
+    const Entry& entry = entries[index];
+    File file = LittleFS.open(FRAME_BUNDLE_FILE, "r");
+    if (!file || !file.seek(entry.offset)) {
+        Serial.println("Frame bundle: cannot read file");
+        return false;
+    }
+
+    unsigned long readStart = millis();
+    BundleInput input = { &file, entry.length };
+    if (!decoder.begin(readBundleFrame, &input)) {
+        Serial.printf("Frame bundle: frame %d rejected: %s\n", index, decoder.getError());
+        file.close();
+        return false;
+    }
+    if (decoder.getWidth() != DISPLAY_WIDTH || decoder.getFrameHash() != entry.hash) {
+        Serial.printf("Frame bundle: frame %d does not match its entry\n", index);
+        decoder.end();
+        file.close();
+        return false;
+    }
+
+    static uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t produced;
+    bool aborted = false;
+    while ((produced = decoder.read(chunk, sizeof(chunk))) > 0) {
+        if (!sink(context, chunk, produced)) {
+            aborted = true;
+            break;
+        }
+    }
+    bool complete = !aborted && decoder.finish() && input.remaining == 0;
+    decoder.end();
+    file.close();
+
+    if (!complete) {
+        Serial.printf("Frame bundle: frame %d failed: %s\n", index,
+                      aborted ? "panel rejected data" : decoder.getError());
+        return false;
+    }
+
+    Serial.printf("Frame bundle: showed frame %d/%d (0x%08X) in %lu ms\n",
+                  index + 1, count, entry.hash, millis() - readStart);
+    return true;
+}
+
+bool FrameBundle::beginWrite(size_t size) {
+    if (!begin()) return false;
+
+    loaded = false;
+    LittleFS.remove(FRAME_BUNDLE_FILE);
+    writeFile = LittleFS.open(FRAME_BUNDLE_TEMP_FILE, "w");
+    if (!writeFile) {
+        Serial.println("Frame bundle: cannot create file");
+        return false;
+    }
+    writeSize = size;
+    written = 0;
+    return true;
+}
+
+bool FrameBundle::write(const uint8_t* data, size_t length) {
+    if (!writeFile || written + length > writeSize) return false;
+    if (writeFile.write(data, length) != length) {
+        Serial.println("Frame bundle: write failed");
+        return false;
+    }
+    written += length;
+    return true;
+}
+
+bool FrameBundle::finishWrite() {
+    if (!writeFile) return false;
+    writeFile.close();
+
+    // Swap in the new file only once it is complete and its index checks out
+    bool ok = written == writeSize && readIndex(FRAME_BUNDLE_TEMP_FILE) &&
+              LittleFS.rename(FRAME_BUNDLE_TEMP_FILE, FRAME_BUNDLE_FILE);
+    if (!ok) {
+        Serial.println("Frame bundle: download incomplete or invalid");
+        abort();
+        return false;
+    }
+
+    Serial.printf("Frame bundle: stored %u bytes, %d frames\n", (unsigned)written, count);
+    return true;
+}
+
+void FrameBundle::abort() {
+    if (writeFile) writeFile.close();
+    LittleFS.remove(FRAME_BUNDLE_TEMP_FILE);
+    loaded = false;
+}
@@ -0,0 +1,352 @@
+#include "frame_cache.h"
+#include "framebuffer.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <time.h>
+
+FrameCache::FrameCache() :
+    partition(nullptr), scanned(false), slotSize(0), currentSlot(-1), pendingSlot(-1),
+    writing(false), finished(false), writeFailed(false), erasedBytes(0), eraseMs(0), writeMs(0),
+    pendingHash(0), hasPartial(false), nextPartialRecord(0) {
+    memset(&current, 0, sizeof(current));
+    memset(&pending, 0, sizeof(pending));
+    memset(&partial, 0, sizeof(partial));
+}
+
+uint32_t FrameCache::entryCheck(const Entry& entry) {
+    return Framebuffer::hash((const uint8_t*)&entry, offsetof(Entry, check));
+}
+
+uint32_t FrameCache::partialCheck(const Partial& record) {
+    return Framebuffer::hash((const uint8_t*)&record, offsetof(Partial, check));
+}
+
+bool FrameCache::readEntry(int slot, Entry& entry) {
+    return esp_partition_read(partition, slotOffset(slot), &entry, sizeof(entry)) == ESP_OK &&
+           entry.magic == MAGIC && entry.check == entryCheck(entry) &&
+           entry.size <= slotSize - DATA_OFFSET;
+}
+
+bool FrameCache::begin() {
+    if (scanned) return partition != nullptr;
+    scanned = true;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         FRAME_CACHE_PARTITION);
+    if (!partition) {
+        Serial.printf("Frame cache: no \"%s\" partition (see partitions.csv)\n", FRAME_CACHE_PARTITION);
+        return false;
+    }
+
+    // Slots start on erase block boundaries so erasing uses 64 KB block erases
+    slotSize = (partition->size / 2) & ~(ERASE_BLOCK - 1);
+    if (slotSize < DATA_OFFSET + (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2) {
+        Serial.println("Frame cache: partition too small for two frames");
+        partition = nullptr;
+        return false;
+    }
+
+    Entry entry;
+    for (int slot = 0; slot < 2; slot++) {
+        if (readEntry(slot, entry) && (currentSlot < 0 || entry.sequence > current.sequence)) {
+            current = entry;
+            currentSlot = slot;
+        }
+    }
+
+    if (currentSlot >= 0) {
+        Serial.printf("Frame cache: slot %c, 0x%08X (%u bytes) from %s\n",
+                      'A' + currentSlot, current.hash, current.size, current.url);
+    } else {
+        Serial.println("Frame cache: empty");
+    }
+
+    scanPartial();
+    if (hasPartial) {
+        Serial.printf("Frame cache: partial download, %u/%u bytes of %s\n",
+                      partial.received, partial.size, partial.url);
+    }
+    return true;
+}
+
+void FrameCache::scanPartial() {
+    // Only the slot the next frame goes to, and only records for its sequence
+    int slot = currentSlot == 0 ? 1 : 0;
+    uint32_t sequence = currentSlot >= 0 ? current.sequence + 1 : 1;
+    hasPartial = false;
+    nextPartialRecord = 0;
+
+    Partial record;
+    for (int i = 0; i < PARTIAL_RECORDS; i++) {
+        if (esp_partition_read(partition, slotOffset(slot) + PARTIAL_OFFSET + i * PARTIAL_STRIDE,
+                               &record, sizeof(record)) != ESP_OK || record.magic == 0xFFFFFFFF) {
+            break;  // Erased: end of the records
+        }
+        nextPartialRecord = i + 1;
+        if (record.magic == PARTIAL_MAGIC && record.check == partialCheck(record) &&
+            record.sequence == sequence && record.received < record.size &&
+            record.size <= slotSize - DATA_OFFSET) {
+            partial = record;
+            hasPartial = true;
+        }
+    }
+}
+
+uint32_t FrameCache::getStoredHash() {
+    if (!begin() || currentSlot < 0) return 0;
+    return current.hash;
+}
+
+bool FrameCache::getStoredEntry(Entry& entry) {
+    if (!begin() || currentSlot < 0) return false;
+    entry = current;
+    return true;
+}
+
+bool FrameCache::load(uint8_t* frame, size_t size, uint32_t expectedHash) {
+    if (!begin() || currentSlot < 0 || current.size != size || current.hash != expectedHash) {
+        Serial.println("Frame cache: no matching frame");
+        return false;
+    }
+
+    unsigned long readStart = millis();
+    if (esp_partition_read(partition, slotOffset(currentSlot) + DATA_OFFSET, frame, size) != ESP_OK ||
+        Framebuffer::hash(frame, size) != expectedHash) {
+        Serial.println("Frame cache: corrupted frame");
+        return false;
+    }
+
+    Serial.printf("Frame cache: loaded 0x%08X in %lu ms\n", expectedHash, millis() - readStart);
+    return true;
+}
+
+bool FrameCache::stream(FrameChunkSink sink, void* context) {
+    if (!begin() || currentSlot < 0) return false;
+
+    static uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t offset = slotOffset(currentSlot) + DATA_OFFSET;
+    uint32_t hash = Framebuffer::HASH_SEED;
+    unsigned long readStart = millis();
+
+    for (size_t done = 0; done < current.size; ) {
+        size_t length = current.size - done;
+        if (length > sizeof(chunk)) length = sizeof(chunk);
+
+        if (esp_partition_read(partition, offset + done, chunk, length) != ESP_OK) {
+            Serial.println("Frame cache: read failed");
+            return false;
+        }
+        hash = Framebuffer::hash(chunk, length, hash);
+        if (!sink(context, chunk, length)) {
+            return false;
+        }
+        done += length;
+    }
+
+    if (hash != current.hash) {
+        Serial.println("Frame cache: corrupted frame");
+        return false;
+    }
+
+    Serial.printf("Frame cache: streamed 0x%08X in %lu ms\n", current.hash, millis() - readStart);
+    return true;
+}
+
+bool FrameCache::eraseUpTo(size_t end) {
+    while (erasedBytes < end) {
+        unsigned long eraseStart = millis();
+        esp_err_t err = esp_partition_erase_range(partition, slotOffset(pendingSlot) + erasedBytes, ERASE_BLOCK);
+        eraseMs += millis() - eraseStart;
+        if (err != ESP_OK) {
+            Serial.printf("Frame cache: erase failed (%d)\n", err);
+            return false;
+        }
+        erasedBytes += ERASE_BLOCK;
+    }
+    return true;
+}
+
+bool FrameCache::beginWrite(const char* url, Format format) {
+    abort();
+    if (!begin()) return false;
+
+    memset(&pending, 0, sizeof(pending));
+    pending.magic = MAGIC;
+    pending.sequence = currentSlot >= 0 ? current.sequence + 1 : 1;
+    pending.format = format;
+    strncpy(pending.url, url, sizeof(pending.url) - 1);
+
+    // The slot that is not current; its header goes with the first block,
+    // which also clears any partial download records
+    pendingSlot = currentSlot == 0 ? 1 : 0;
+    erasedBytes = 0;
+    eraseMs = 0;
+    writeMs = 0;
+    pendingHash = Framebuffer::HASH_SEED;
+    hasPartial = false;
+    nextPartialRecord = 0;
+    writing = true;
+    writeFailed = !eraseUpTo(DATA_OFFSET);
+    return !writeFailed;
+}
+
+bool FrameCache::write(const uint8_t* data, size_t length) {
+    if (!writing || writeFailed) return false;
+
+    size_t start = DATA_OFFSET + pending.size;
+    if (length > slotSize - start) {
+        Serial.println("Frame cache: frame larger than a slot");
+        writeFailed = true;
+        return false;
+    }
+
+    if (!eraseUpTo(start + length)) {
+        writeFailed = true;
+        return false;
+    }
+
+    unsigned long writeStart = millis();
+    writeFailed = esp_partition_write(partition, slotOffset(pendingSlot) + start, data, length) != ESP_OK;
+    writeMs += millis() - writeStart;
+    pending.size += length;
+    pendingHash = Framebuffer::hash(data, length, pendingHash);
+
+    // The cache is an optimisation: never let it stretch the wake
+    if (!writeFailed && eraseMs + writeMs > FRAME_CACHE_BUDGET_MS) {
+        Serial.printf("Frame cache: %lu ms erase + %lu ms write exceed the %d ms budget - not cached\n",
+                      eraseMs, writeMs, FRAME_CACHE_BUDGET_MS);
+        writeFailed = true;
+    }
+    return !writeFailed;
+}
+
+bool FrameCache::finishWrite(uint32_t hash) {
+    if (!writing) return false;
+    writing = false;
+
+    if (writeFailed) {
+        Serial.println("Frame cache: write failed");
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    pending.hash = hash;
+    pending.timestamp = now > 1600000000 ? (uint32_t)now : 0;  // Only once NTP set the clock
+    pending.check = entryCheck(pending);
+    finished = true;
+
+    Serial.printf("Frame cache: slot %c, %u bytes, erase %lu ms, write %lu ms\n",
+                  'A' + pendingSlot, pending.size, eraseMs, writeMs);
+    return true;
+}
+
+bool FrameCache::store(const uint8_t* frame, size_t size, uint32_t hash, const char* url, Format format) {
+    return beginWrite(url, format) && write(frame, size) && finishWrite(hash);
+}
+
+void FrameCache::abort() {
+    // The pending slot is not current, so its partial data needs no cleanup
+    writing = false;
+    finished = false;
+    writeFailed = false;
+}
+
+bool FrameCache::findPartial(const char* url, Partial& found) {
+    if (!begin() || !hasPartial || strncmp(partial.url, url, sizeof(partial.url)) != 0) {
+        return false;
+    }
+    found = partial;
+    return true;
+}
+
+bool FrameCache::readPartial(uint8_t* frame, size_t size) {
+    if (!hasPartial || size < partial.received) return false;
+
+    int slot = currentSlot == 0 ? 1 : 0;
+    if (esp_partition_read(partition, slotOffset(slot) + DATA_OFFSET, frame, partial.received) != ESP_OK ||
+        Framebuffer::hash(frame, partial.received) != partial.hash) {
+        Serial.println("Frame cache: corrupted partial download");
+        hasPartial = false;
+        return false;
+    }
+    return true;
+}
+
+bool FrameCache::resumeWrite() {
+    if (!begin() || !hasPartial) return false;
+    abort();
+
+    memset(&pending, 0, sizeof(pending));
+    pending.magic = MAGIC;
+    pending.sequence = partial.sequence;
+    pending.format = partial.format;
+    memcpy(pending.url, partial.url, sizeof(pending.url));
+    pending.size = partial.received;
+
+    // The blocks holding the prefix were erased before it was written
+    pendingSlot = currentSlot == 0 ? 1 : 0;
+    erasedBytes = (DATA_OFFSET + partial.received + ERASE_BLOCK - 1) & ~(ERASE_BLOCK - 1);
+    eraseMs = 0;
+    writeMs = 0;
+    pendingHash = partial.hash;
+    writing = true;
+    return true;
+}
+
+bool FrameCache::savePartial(const char* validator, size_t size) {
+    if (!writing) return false;
+    writing = false;
+
+    if (writeFailed || pending.size == 0 || pending.size >= size || !validator[0] ||
+        strlen(validator) >= sizeof(partial.validator)) {
+        return false;
+    }
+    if (nextPartialRecord >= PARTIAL_RECORDS) {
+        // Bytes past the last record are written now: start over next time
+        Serial.println("Frame cache: no room for another partial record");
+        hasPartial = false;
+        return false;
+    }
+
+    Partial record;
+    memset(&record, 0, sizeof(record));
+    record.magic = PARTIAL_MAGIC;
+    record.sequence = pending.sequence;
+    record.size = size;
+    record.received = pending.size;
+    record.hash = pendingHash;
+    record.format = pending.format;
+    memcpy(record.url, pending.url, sizeof(record.url));
+    strncpy(record.validator, validator, sizeof(record.validator) - 1);
+    record.check = partialCheck(record);
+
+    size_t offset = slotOffset(pendingSlot) + PARTIAL_OFFSET + nextPartialRecord * PARTIAL_STRIDE;
+    if (esp_partition_write(partition, offset, &record, sizeof(record)) != ESP_OK) {
+        Serial.println("Frame cache: partial record write failed");
+        return false;
+    }
+    nextPartialRecord++;
+    partial = record;
+    hasPartial = true;
+
+    Serial.printf("Frame cache: kept %u/%u bytes of %s to resume\n", record.received, record.size, record.url);
+    return true;
+}
+
+bool FrameCache::commit() {
+    if (!finished) return false;
+    finished = false;
+
+    // A single small write flips the current slot
+    unsigned long writeStart = millis();
+    if (esp_partition_write(partition, slotOffset(pendingSlot), &pending, sizeof(pending)) != ESP_OK) {
+        Serial.println("Frame cache: commit failed");
+        return false;
+    }
+
+    current = pending;
+    currentSlot = pendingSlot;
+    hasPartial = false;
+    Serial.printf("Frame cache: committed 0x%08X to slot %c in %lu ms\n",
+                  current.hash, 'A' + currentSlot, millis() - writeStart);
+    return true;
+}
@@ -0,0 +1,234 @@
+#include "frame_digest.h"
+#include "config.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <mbedtls/base64.h>
+#include <mbedtls/version.h>
+#include "framebuffer.h"
+
+#define BENCHMARK_BLOCK 4096
+
+// mbedtls 3 (arduino-esp32 3.x) dropped the *_ret names, its plain ones
+// return the status; 2.x keeps the plain ones only as deprecated void calls
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define mbedtls_sha256_starts_ret mbedtls_sha256_starts
+#define mbedtls_sha256_update_ret mbedtls_sha256_update
+#define mbedtls_sha256_finish_ret mbedtls_sha256_finish
+#endif
+
+static float msPerMB(unsigned long micros, uint64_t bytes) {
+    return bytes > 0 ? micros * 1048.576f / bytes : 0.0f;
+}
+
+FrameDigest::FrameDigest() : active(false), bytes(0), hashMicros(0) {
+    mbedtls_sha256_init(&context);
+}
+
+FrameDigest::~FrameDigest() {
+    mbedtls_sha256_free(&context);
+}
+
+void FrameDigest::begin() {
+    // A digest abandoned by a failed download is simply restarted
+    mbedtls_sha256_free(&context);
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts_ret(&context, 0);
+    active = true;
+    bytes = 0;
+    hashMicros = 0;
+}
+
+void FrameDigest::update(const uint8_t* data, size_t length) {
+    if (!active || length == 0) return;
+
+    unsigned long start = micros();
+    mbedtls_sha256_update_ret(&context, data, length);
+    hashMicros += micros() - start;
+    bytes += length;
+}
+
+bool FrameDigest::verify(const uint8_t* expected) {
+    if (!active) return false;
+    active = false;
+
+    uint8_t digest[SIZE];
+    unsigned long start = micros();
+    mbedtls_sha256_finish_ret(&context, digest);
+    hashMicros += micros() - start;
+
+    bool match = memcmp(digest, expected, SIZE) == 0;
+    Serial.printf("SHA-256 of %u bytes %s: %lu us (%.1f ms/MB)\n", bytes,
+                  match ? "matches" : "DOES NOT MATCH the published digest", hashMicros,
+                  msPerMB(hashMicros, bytes));
+    return match;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool FrameDigest::parseHex(const char* hex, uint8_t* digest) {
+    if (!hex || strlen(hex) != SIZE * 2) return false;
+
+    for (int i = 0; i < SIZE; i++) {
+        int high = hexValue(hex[2 * i]);
+        int low = hexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) return false;
+        digest[i] = (high << 4) | low;
+    }
+    return true;
+}
+
+bool FrameDigest::parseDigestHeader(const String& value, uint8_t* digest) {
+    // Several algorithms may be listed: "SHA-256=...,MD5=..."
+    String header = value;
+    header.toLowerCase();
+    int start = header.indexOf("sha-256=");
+    if (start < 0) return false;
+    start += 8;
+    int end = value.indexOf(',', start);
+    String encoded = value.substring(start, end < 0 ? value.length() : end);
+    encoded.trim();
+
+    size_t length = 0;
+    return mbedtls_base64_decode(digest, SIZE, &length, (const unsigned char*)encoded.c_str(),
+                                 encoded.length()) == 0 && length == SIZE;
+}
+
+#if FRAME_DIGEST_BENCHMARK
+// Plain C SHA-256 (FIPS 180-4), only to compare against the engine
+struct SoftwareSha256 {
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t used;
+    uint64_t total;
+};
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void softwareCompress(SoftwareSha256& sha, const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+               ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = sha.state[0], b = sha.state[1], c = sha.state[2], d = sha.state[3];
+    uint32_t e = sha.state[4], f = sha.state[5], g = sha.state[6], h = sha.state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    sha.state[0] += a; sha.state[1] += b; sha.state[2] += c; sha.state[3] += d;
+    sha.state[4] += e; sha.state[5] += f; sha.state[6] += g; sha.state[7] += h;
+}
+
+static void softwareStart(SoftwareSha256& sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(sha.state, initial, sizeof(initial));
+    sha.used = 0;
+    sha.total = 0;
+}
+
+static void softwareUpdate(SoftwareSha256& sha, const uint8_t* data, size_t length) {
+    sha.total += length;
+    while (length > 0) {
+        size_t take = 64 - sha.used;
+        if (take > length) take = length;
+        memcpy(sha.block + sha.used, data, take);
+        sha.used += take;
+        data += take;
+        length -= take;
+        if (sha.used == 64) {
+            softwareCompress(sha, sha.block);
+            sha.used = 0;
+        }
+    }
+}
+
+static void softwareFinish(SoftwareSha256& sha, uint8_t* digest) {
+    uint64_t bits = sha.total * 8;
+    uint8_t padding[72] = { 0x80 };
+    size_t padLength = (sha.used < 56 ? 56 : 120) - sha.used;
+    for (int i = 0; i < 8; i++) {
+        padding[padLength + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    softwareUpdate(sha, padding, padLength + 8);
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = sha.state[i] >> 24;
+        digest[4 * i + 1] = sha.state[i] >> 16;
+        digest[4 * i + 2] = sha.state[i] >> 8;
+        digest[4 * i + 3] = sha.state[i];
+    }
+}
+
+void FrameDigest::benchmark(size_t bytes) {
+    static uint8_t block[BENCHMARK_BLOCK];
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    size_t blocks = (bytes + BENCHMARK_BLOCK - 1) / BENCHMARK_BLOCK;
+    uint64_t total = (uint64_t)blocks * BENCHMARK_BLOCK;
+
+    uint8_t hardware[SIZE];
+    mbedtls_sha256_context engine;
+    mbedtls_sha256_init(&engine);
+    unsigned long start = micros();
+    mbedtls_sha256_starts_ret(&engine, 0);
+    for (size_t i = 0; i < blocks; i++) {
+        mbedtls_sha256_update_ret(&engine, block, sizeof(block));
+    }
+    mbedtls_sha256_finish_ret(&engine, hardware);
+    unsigned long hardwareMicros = micros() - start;
+    mbedtls_sha256_free(&engine);
+
+    uint8_t software[SIZE];
+    SoftwareSha256 sha;
+    start = micros();
+    softwareStart(sha);
+    for (size_t i = 0; i < blocks; i++) {
+        softwareUpdate(sha, block, sizeof(block));
+    }
+    softwareFinish(sha, software);
+    unsigned long softwareMicros = micros() - start;
+
+    uint32_t fnv = Framebuffer::HASH_SEED;
+    start = micros();
+    for (size_t i = 0; i < blocks; i++) {
+        fnv = Framebuffer::hash(block, sizeof(block), fnv);
+    }
+    unsigned long fnvMicros = micros() - start;
+
+    Serial.printf("Hash benchmark over %u KB: SHA-256 hardware %.1f ms/MB, software %.1f ms/MB%s, FNV-1a %.1f ms/MB\n",
+                  (uint32_t)(total / 1024), msPerMB(hardwareMicros, total), msPerMB(softwareMicros, total),
+                  memcmp(hardware, software, SIZE) == 0 ? "" : " (digests differ!)", msPerMB(fnvMicros, total));
+}
+#else
+void FrameDigest::benchmark(size_t bytes) {
+    (void)bytes;
+}
+#endif
@@ -0,0 +1,88 @@
+#include "frame_patch.h"
+#include "framebuffer.h"
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FramePatch::FramePatch() :
+    baseHash(0), frameHash(0), runCount(0), changedBytes(0), error(nullptr) {
+}
+
+bool FramePatch::fail(const char* message) {
+    if (!error) error = message;
+    return false;
+}
+
+bool FramePatch::begin(StreamInput input, void* context) {
+    error = nullptr;
+    changedBytes = 0;
+
+    uint8_t header[HEADER_SIZE];
+    size_t filled = 0;
+    while (filled < sizeof(header)) {
+        size_t received = input(context, header + filled, sizeof(header) - filled);
+        if (received == 0) return fail("truncated header");
+        filled += received;
+    }
+
+    if (readLE32(header) != MAGIC) return fail("not a frame patch");
+    if (header[4] != VERSION) return fail("unsupported version");
+
+    int windowBits = header[5];
+    if (windowBits < MIN_WINDOW_BITS || windowBits > MAX_WINDOW_BITS) {
+        return fail("unsupported window size");
+    }
+
+    baseHash = readLE32(header + 8);
+    frameHash = readLE32(header + 12);
+    runCount = readLE32(header + 16);
+    if (!inflater.begin(InflateStream::FORMAT_RAW, input, context, (size_t)1 << windowBits)) {
+        return fail(inflater.getError());
+    }
+    return true;
+}
+
+bool FramePatch::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        uint8_t byte;
+        if (inflater.read(&byte, 1) != 1) return fail("patch data ended early");
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) return true;
+    }
+    return fail("invalid run header");
+}
+
+bool FramePatch::apply(uint8_t* frame, size_t size) {
+    if (error) return false;
+
+    size_t position = 0;
+    for (uint32_t run = 0; run < runCount; run++) {
+        uint32_t skip, length;
+        if (!readVarint(skip) || !readVarint(length)) return false;
+        if (skip > size - position || length > size - position - skip) {
+            return fail("run outside the frame");
+        }
+
+        position += skip;
+        if (inflater.read(frame + position, length) != length) {
+            return fail(inflater.hasError() ? inflater.getError() : "patch data ended early");
+        }
+        position += length;
+        changedBytes += length;
+    }
+
+    // Nothing may follow the last run
+    uint8_t extra;
+    if (inflater.read(&extra, 1) != 0) return fail("data past the last run");
+    if (!inflater.isFinished()) {
+        return fail(inflater.hasError() ? inflater.getError() : "stream not terminated");
+    }
+    if (Framebuffer::hash(frame, size) != frameHash) return fail("patched frame hash mismatch");
+    return true;
+}
+
+void FramePatch::end() {
+    inflater.end();
+}
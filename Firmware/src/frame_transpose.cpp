@@ -0,0 +1,70 @@
+#include "frame_transpose.h"
+
+// Portrait and landscape strides in bytes
+static const int PORTRAIT_STRIDE = PORTRAIT_WIDTH / 2;
+static const int LANDSCAPE_STRIDE = DISPLAY_WIDTH / 2;
+
+// Segments are assembled big-endian so the first pixel of the segment lands
+// in the top nibble regardless of CPU byte order
+static inline uint32_t loadSegment(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void storeSegment(uint8_t* p, uint32_t segment) {
+    p[0] = segment >> 24;
+    p[1] = segment >> 16;
+    p[2] = segment >> 8;
+    p[3] = segment;
+}
+
+// Exchange the off-diagonal blocks of rows a and b: block size is given by
+// shift (bits) and mask selects the lower block of every pair
+static inline void swapBlocks(uint32_t& a, uint32_t& b, int shift, uint32_t mask) {
+    uint32_t t = (a ^ (b >> shift)) & mask;
+    a ^= t;
+    b ^= t << shift;
+}
+
+void FrameTranspose::transposeTile(uint32_t rows[TILE]) {
+    // 4x4 blocks, then 2x2 blocks, then single nibbles
+    for (int r = 0; r < 4; r++) {
+        swapBlocks(rows[r], rows[r + 4], 16, 0x0000FFFFu);
+    }
+    for (int r = 0; r < TILE; r += 4) {
+        swapBlocks(rows[r], rows[r + 2], 8, 0x00FF00FFu);
+        swapBlocks(rows[r + 1], rows[r + 3], 8, 0x00FF00FFu);
+    }
+    for (int r = 0; r < TILE; r += 2) {
+        swapBlocks(rows[r], rows[r + 1], 4, 0x0F0F0F0Fu);
+    }
+}
+
+void FrameTranspose::portraitBand(const uint8_t* portrait, int band, uint8_t* bandBuffer) {
+    // Landscape rows y0..y0+7 are portrait columns y0..y0+7, a 4-byte column
+    // slice of every portrait row
+    int y0 = band * BAND_ROWS;
+    const uint8_t* column = portrait + y0 / 2;
+
+    for (int x0 = 0; x0 < DISPLAY_WIDTH; x0 += TILE) {
+        // Landscape x0 + r comes from portrait row PORTRAIT_HEIGHT - 1 - x0 - r
+        const uint8_t* src = column + (PORTRAIT_HEIGHT - 1 - x0) * PORTRAIT_STRIDE;
+        uint32_t tile[TILE];
+
+        for (int r = 0; r < TILE; r++) {
+            tile[r] = loadSegment(src - r * PORTRAIT_STRIDE);
+        }
+
+        transposeTile(tile);
+
+        uint8_t* dst = bandBuffer + x0 / 2;
+        for (int r = 0; r < TILE; r++) {
+            storeSegment(dst + r * LANDSCAPE_STRIDE, tile[r]);
+        }
+    }
+}
+
+void FrameTranspose::portraitToLandscape(const uint8_t* portrait, uint8_t* landscape) {
+    for (int band = 0; band < BAND_COUNT; band++) {
+        portraitBand(portrait, band, landscape + band * BAND_SIZE);
+    }
+}
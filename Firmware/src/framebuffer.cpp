@@ -0,0 +1,461 @@
+#include "framebuffer.h"
+#include "nibble_kernels.h"
+#include <string.h>
+
+// Simple 5x7 font bitmap for basic characters
+static const uint8_t font5x7[][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // Space
+    {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
+    {0x00, 0x07, 0x00, 0x07, 0x00}, // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // $
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, // &
+    {0x00, 0x05, 0x03, 0x00, 0x00}, // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
+    {0x08, 0x2A, 0x1C, 0x2A, 0x08}, // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+    {0x00, 0x60, 0x60, 0x00, 0x00}, // .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31}, // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30}, // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E}, // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00}, // :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
+    {0x00, 0x08, 0x14, 0x22, 0x41}, // <
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+    {0x41, 0x22, 0x14, 0x08, 0x00}, // >
+    {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
+    {0x32, 0x49, 0x79, 0x41, 0x3E}, // @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
+    {0x7F, 0x09, 0x09, 0x01, 0x01}, // F
+    {0x3E, 0x41, 0x41, 0x51, 0x32}, // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
+    {0x7F, 0x02, 0x04, 0x02, 0x7F}, // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01}, // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
+    {0x7F, 0x20, 0x18, 0x20, 0x7F}, // W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+    {0x03, 0x04, 0x78, 0x04, 0x03}, // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
+};
+
+Framebuffer::Framebuffer(uint8_t* buffer, int width, int height) :
+    buffer(buffer), width(width), height(height), stride(width / 2), depth(0) {
+    Viewport& root = viewports[0];
+    root.originX = 0;
+    root.originY = 0;
+    root.width = width;
+    root.height = height;
+    root.clipX0 = 0;
+    root.clipY0 = 0;
+    root.clipX1 = width;
+    root.clipY1 = height;
+}
+
+bool Framebuffer::pushViewport(int x, int y, int w, int h) {
+    if (depth + 1 >= FRAMEBUFFER_MAX_VIEWPORTS) return false;
+    
+    const Viewport& parent = viewports[depth];
+    Viewport& child = viewports[depth + 1];
+    
+    child.originX = parent.originX + x;
+    child.originY = parent.originY + y;
+    child.width = w;
+    child.height = h;
+    
+    // Intersect the new rect with the parent clip (may end up empty)
+    child.clipX0 = child.originX > parent.clipX0 ? child.originX : parent.clipX0;
+    child.clipY0 = child.originY > parent.clipY0 ? child.originY : parent.clipY0;
+    child.clipX1 = child.originX + w < parent.clipX1 ? child.originX + w : parent.clipX1;
+    child.clipY1 = child.originY + h < parent.clipY1 ? child.originY + h : parent.clipY1;
+    
+    depth++;
+    return true;
+}
+
+bool Framebuffer::pushClip(int x, int y, int w, int h) {
+    const Viewport& parent = viewports[depth];
+    if (!pushViewport(x, y, w, h)) return false;
+    
+    // Keep the parent's coordinate system, only the clip rect narrows
+    Viewport& child = viewports[depth];
+    child.originX = parent.originX;
+    child.originY = parent.originY;
+    child.width = parent.width;
+    child.height = parent.height;
+    return true;
+}
+
+void Framebuffer::popViewport() {
+    if (depth > 0) depth--;
+}
+
+bool Framebuffer::clipToViewport(int x, int y, int w, int h, int& x0, int& y0, int& x1, int& y1) const {
+    const Viewport& vp = viewports[depth];
+    
+    x0 = vp.originX + x;
+    y0 = vp.originY + y;
+    x1 = x0 + w;
+    y1 = y0 + h;
+    
+    if (x0 < vp.clipX0) x0 = vp.clipX0;
+    if (y0 < vp.clipY0) y0 = vp.clipY0;
+    if (x1 > vp.clipX1) x1 = vp.clipX1;
+    if (y1 > vp.clipY1) y1 = vp.clipY1;
+    
+    return x0 < x1 && y0 < y1;
+}
+
+void Framebuffer::clear(uint8_t color) {
+    if (depth == 0) {
+        memset(buffer, (color << 4) | color, getSize());
+        return;
+    }
+    
+    const Viewport& vp = viewports[depth];
+    fillRect(vp.clipX0 - vp.originX, vp.clipY0 - vp.originY,
+             vp.clipX1 - vp.clipX0, vp.clipY1 - vp.clipY0, color);
+}
+
+void Framebuffer::setPixel(int x, int y, uint8_t color) {
+    const Viewport& vp = viewports[depth];
+    x += vp.originX;
+    y += vp.originY;
+    
+    if (x < vp.clipX0 || x >= vp.clipX1 || y < vp.clipY0 || y >= vp.clipY1) return;
+    
+    int bufferIndex = (y * stride) + (x / 2);
+    
+    if (x % 2 == 0) {
+        // Left pixel (upper 4 bits)
+        buffer[bufferIndex] = (buffer[bufferIndex] & 0x0F) | (color << 4);
+    } else {
+        // Right pixel (lower 4 bits)
+        buffer[bufferIndex] = (buffer[bufferIndex] & 0xF0) | color;
+    }
+}
+
+uint8_t Framebuffer::getPixel(int x, int y) const {
+    x += viewports[depth].originX;
+    y += viewports[depth].originY;
+    
+    if (x < 0 || x >= width || y < 0 || y >= height) return EPD_7IN3F_WHITE;
+    
+    uint8_t packed = buffer[(y * stride) + (x / 2)];
+    return (x % 2 == 0) ? (packed >> 4) : (packed & 0x0F);
+}
+
+void Framebuffer::fillRect(int x, int y, int w, int h, uint8_t color) {
+    int x0, y0, x1, y1;
+    if (!clipToViewport(x, y, w, h, x0, y0, x1, y1)) return;
+    
+    // Already clipped: fill whole rows 8 pixels per word
+    for (int row = y0; row < y1; row++) {
+        NibbleKernels::fillSpan(buffer + (size_t)row * stride, x0, x1, color);
+    }
+}
+
+// Widest row drawMask handles through blendWords, in words
+#define MASK_MAX_WORDS ((DISPLAY_WIDTH > DISPLAY_HEIGHT ? DISPLAY_WIDTH : DISPLAY_HEIGHT) / 8 + 1)
+
+// 8 mask bits from bit p of a mask row (bit i of a byte is pixel i), 0 outside it
+static uint8_t maskBits(const uint8_t* row, int rowBytes, int p) {
+    int index = (p + 8) / 8 - 1;  // Floor division for p >= -8
+    int shift = p - index * 8;
+    uint16_t window = 0;
+    if (index >= 0 && index < rowBytes) window |= row[index];
+    if (index + 1 >= 0 && index + 1 < rowBytes) window |= row[index + 1] << 8;
+    return (window >> shift) & 0xFF;
+}
+
+void Framebuffer::drawMask(int x, int y, int w, int h, const uint8_t* bits, uint8_t color) {
+    int x0, y0, x1, y1;
+    if (!clipToViewport(x, y, w, h, x0, y0, x1, y1)) return;
+    
+    const Viewport& vp = viewports[depth];
+    int maskX = vp.originX + x;
+    int maskY = vp.originY + y;
+    int rowBytes = (w + 7) / 8;
+    
+    // Mask bytes per frame word, blended with the replicated color
+    int firstWord = x0 / 8;
+    int words = (x1 + 7) / 8 - firstWord;
+    uint8_t pixelMasks[MASK_MAX_WORDS];
+    uint32_t colorWords[MASK_MAX_WORDS];
+    bool wordPath = words <= MASK_MAX_WORDS && stride % 4 == 0 && ((uintptr_t)buffer & 3) == 0;
+    if (wordPath) {
+        uint32_t colorWord = NibbleKernels::replicate(color);
+        for (int i = 0; i < words; i++) colorWords[i] = colorWord;
+    }
+    
+    for (int row = y0; row < y1; row++) {
+        const uint8_t* maskRow = bits + (size_t)(row - maskY) * rowBytes;
+        uint8_t* frameRow = buffer + (size_t)row * stride;
+        
+        if (!wordPath) {
+            for (int px = x0; px < x1; px++) {
+                if (!(maskRow[(px - maskX) / 8] & (1 << ((px - maskX) % 8)))) continue;
+                uint8_t& packed = frameRow[px / 2];
+                packed = (px % 2 == 0) ? ((packed & 0x0F) | (color << 4)) : ((packed & 0xF0) | color);
+            }
+            continue;
+        }
+        
+        for (int i = 0; i < words; i++) {
+            int wordX = (firstWord + i) * 8;
+            uint8_t pixels = maskBits(maskRow, rowBytes, wordX - maskX);
+            // Clip the first and last word to [x0, x1)
+            if (wordX < x0) pixels &= 0xFF << (x0 - wordX);
+            if (wordX + 8 > x1) pixels &= 0xFF >> (wordX + 8 - x1);
+            pixelMasks[i] = pixels;
+        }
+        NibbleKernels::blendWords((uint32_t*)frameRow + firstWord, colorWords, pixelMasks, words);
+    }
+}
+
+void Framebuffer::copyRect(const Framebuffer& src, int x, int y, int w, int h) {
+    if (src.width != width || src.height != height) return;
+    
+    int x0, y0, x1, y1;
+    if (!clipToViewport(x, y, w, h, x0, y0, x1, y1)) return;
+    
+    for (int row = y0; row < y1; row++) {
+        size_t offset = (size_t)row * stride;
+        NibbleKernels::copySpan(buffer + offset, src.buffer + offset, x0, x1);
+    }
+}
+
+void Framebuffer::composite(const Framebuffer& sprite, int x, int y, uint8_t keyColor) {
+    int x0, y0, x1, y1;
+    if (!clipToViewport(x, y, sprite.width, sprite.height, x0, y0, x1, y1)) return;
+    
+    const Viewport& vp = viewports[depth];
+    int spriteX = vp.originX + x;
+    int spriteY = vp.originY + y;
+    
+    for (int row = y0; row < y1; row++) {
+        uint8_t* frameRow = buffer + (size_t)row * stride;
+        const uint8_t* spriteRow = sprite.buffer + (size_t)(row - spriteY) * sprite.stride;
+        
+        if (spriteX % 2 != 0) {
+            // Sprite nibbles fall across frame bytes: pixel by pixel
+            for (int px = x0; px < x1; px++) {
+                int sx = px - spriteX;
+                uint8_t pixel = (sx % 2 == 0) ? (spriteRow[sx / 2] >> 4) : (spriteRow[sx / 2] & 0x0F);
+                if (pixel == keyColor) continue;
+                uint8_t& packed = frameRow[px / 2];
+                packed = (px % 2 == 0) ? ((packed & 0x0F) | (pixel << 4)) : ((packed & 0xF0) | pixel);
+            }
+        } else if (spriteX >= 0) {
+            // Both rows in sprite coordinates
+            NibbleKernels::compositeSpan(frameRow + spriteX / 2, spriteRow, x0 - spriteX, x1 - spriteX, keyColor);
+        } else {
+            // Both rows in frame coordinates
+            NibbleKernels::compositeSpan(frameRow, spriteRow - spriteX / 2, x0, x1, keyColor);
+        }
+    }
+}
+
+int Framebuffer::textWidth(const char* text, int scale) {
+    return strlen(text) * 6 * scale;  // 5 pixel glyph + 1 pixel spacing
+}
+
+void Framebuffer::drawText(const char* text, int x, int y, int scale, uint8_t color) {
+    int textLength = strlen(text);
+    
+    // Reject text that lies entirely outside the clip rect up front
+    int x0, y0, x1, y1;
+    if (!clipToViewport(x, y, textLength * 6 * scale, 7 * scale, x0, y0, x1, y1)) return;
+    
+    for (int i = 0; i < textLength; i++) {
+        char c = text[i];
+        int charIndex;
+        
+        // Convert character to font index; the font has no lower case
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        if (c >= ' ' && c <= 'Z') {
+            charIndex = c - ' ';
+        } else {
+            charIndex = 0; // Default to space for unknown characters
+        }
+        
+        // Glyphs are stored as 5 columns with the top row in bit 0; draw one
+        // filled block per horizontal run of set bits
+        const uint8_t* glyph = font5x7[charIndex];
+        int charX = x + i * 6 * scale;
+        for (int row = 0; row < 7; row++) {
+            int col = 0;
+            while (col < 5) {
+                if (!(glyph[col] & (1 << row))) {
+                    col++;
+                    continue;
+                }
+                
+                int runStart = col;
+                while (col < 5 && (glyph[col] & (1 << row))) {
+                    col++;
+                }
+                
+                fillRect(charX + runStart * scale, y + row * scale, (col - runStart) * scale, scale, color);
+            }
+        }
+    }
+}
+
+void Framebuffer::drawRoundedRect(int x, int y, int width, int height, int radius, uint8_t fillColor, uint8_t borderColor) {
+    // Draw rounded rectangle with proper corners
+    
+    // Clamp radius to not exceed half the smaller dimension
+    if (radius > width / 2) radius = width / 2;
+    if (radius > height / 2) radius = height / 2;
+    
+    // Fill the main body (rectangular part without corners)
+    fillRect(x, y + radius, width, height - 2 * radius, fillColor);
+    
+    // Fill the top and bottom rectangles (between corners)
+    fillRect(x + radius, y, width - 2 * radius, radius, fillColor);                   // Top
+    fillRect(x + radius, y + height - radius, width - 2 * radius, radius, fillColor); // Bottom
+    
+    // Draw rounded corners using simple circle approximation
+    for (int dy = 0; dy < radius; dy++) {
+        for (int dx = 0; dx < radius; dx++) {
+            // Distance from corner center
+            int distSq = (dx - radius + 1) * (dx - radius + 1) + (dy - radius + 1) * (dy - radius + 1);
+            int radiusSq = radius * radius;
+            
+            if (distSq <= radiusSq) {
+                // Top-left corner
+                setPixel(x + radius - 1 - dx, y + radius - 1 - dy, fillColor);
+                // Top-right corner
+                setPixel(x + width - radius + dx, y + radius - 1 - dy, fillColor);
+                // Bottom-left corner
+                setPixel(x + radius - 1 - dx, y + height - radius + dy, fillColor);
+                // Bottom-right corner
+                setPixel(x + width - radius + dx, y + height - radius + dy, fillColor);
+            }
+        }
+    }
+    
+    // Draw border edges (straight parts)
+    // Top and bottom edges
+    fillRect(x + radius, y, width - 2 * radius, 1, borderColor);                 // Top edge
+    fillRect(x + radius, y + height - 1, width - 2 * radius, 1, borderColor);    // Bottom edge
+    
+    // Left and right edges  
+    fillRect(x, y + radius, 1, height - 2 * radius, borderColor);                // Left edge
+    fillRect(x + width - 1, y + radius, 1, height - 2 * radius, borderColor);    // Right edge
+    
+    // Draw rounded border corners
+    for (int dy = 0; dy < radius; dy++) {
+        for (int dx = 0; dx < radius; dx++) {
+            int distSq = (dx - radius + 1) * (dx - radius + 1) + (dy - radius + 1) * (dy - radius + 1);
+            int radiusSq = radius * radius;
+            int innerRadiusSq = (radius - 1) * (radius - 1);
+            
+            if (distSq <= radiusSq && distSq > innerRadiusSq) {
+                // Top-left corner border
+                setPixel(x + radius - 1 - dx, y + radius - 1 - dy, borderColor);
+                // Top-right corner border
+                setPixel(x + width - radius + dx, y + radius - 1 - dy, borderColor);
+                // Bottom-left corner border
+                setPixel(x + radius - 1 - dx, y + height - radius + dy, borderColor);
+                // Bottom-right corner border
+                setPixel(x + width - radius + dx, y + height - radius + dy, borderColor);
+            }
+        }
+    }
+}
+
+uint32_t Framebuffer::hash() const {
+    return hash(buffer, getSize());
+}
+
+uint32_t Framebuffer::hash(const uint8_t* data, size_t length, uint32_t seed) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 16777619u;        // FNV-1a prime
+    }
+    return h;
+}
+
+void Framebuffer::fillCircle(int centerX, int centerY, int radius, uint8_t color) {
+    if (radius < 0) return;
+
+    // One span per row; the half width follows the circle outline
+    int halfWidth = radius;
+    for (int dy = 0; dy <= radius; dy++) {
+        while (halfWidth > 0 && halfWidth * halfWidth + dy * dy > radius * radius) {
+            halfWidth--;
+        }
+        fillRect(centerX - halfWidth, centerY - dy, 2 * halfWidth + 1, 1, color);
+        if (dy > 0) {
+            fillRect(centerX - halfWidth, centerY + dy, 2 * halfWidth + 1, 1, color);
+        }
+    }
+}
+
+void Framebuffer::drawLine(int x0, int y0, int x1, int y1, int thickness, uint8_t color) {
+    if (thickness < 1) thickness = 1;
+    int offset = thickness / 2;
+
+    // Axis-aligned lines are a single rectangle
+    if (y0 == y1 || x0 == x1) {
+        int left = x0 < x1 ? x0 : x1;
+        int top = y0 < y1 ? y0 : y1;
+        int w = (x0 < x1 ? x1 - x0 : x0 - x1) + thickness;
+        int h = (y0 < y1 ? y1 - y0 : y0 - y1) + thickness;
+        fillRect(left - offset, top - offset, w, h, color);
+        return;
+    }
+
+    // Bresenham, stamping the pen at every step
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int stepX = x0 < x1 ? 1 : -1;
+    int stepY = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+
+    while (true) {
+        fillRect(x0 - offset, y0 - offset, thickness, thickness, color);
+        if (x0 == x1 && y0 == y1) break;
+
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
@@ -2,133 +2,1824 @@
 #include "config.h"
 #include "serial_config.h"  // Must be included before Arduino.h
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include <time.h>
+#include "frame_transpose.h"
+#include "framebuffer.h"
+#include "bitplane_frame.h"
+
+#define CONDITIONAL_STATE_MAGIC 0x45544147  // "ETAG"
+#define DOWNLOAD_PROGRESS_BYTES 32768       // Progress log interval of buffered downloads
+#define MANIFEST_READ_BUFFER 64             // Bytes per socket read while parsing the manifest
+
+// Validators of the resource on screen and conditional GET counters. RTC
+// slow memory survives deep sleep; a power cycle starts from scratch.
+struct ConditionalState {
+    uint32_t magic;
+    uint32_t urlHash;
+    char etag[80];
+    char lastModified[40];
+    uint32_t lastBodyBytes;      // Size of the resource on screen
+    uint32_t frameHash;          // Framebuffer::hash of the frame on screen, 0 if unknown
+    uint32_t panelBehind;        // Refresh skipped: the panel still shows the frame before frameHash
+    uint32_t lastAwakeMs;        // Awake time of the wake that fetched it
+    uint32_t wakes;
+    uint32_t notModified;
+    uint32_t bytesSaved;
+    uint32_t awakeMsSaved;
+};
+
+RTC_DATA_ATTR static ConditionalState conditionalState;
+
+#define BUNDLE_STATE_MAGIC 0x574F4853   // "SHOW"
+#define CLOCK_VALID_AFTER 1600000000    // Unix time; earlier means the clock was never set
+
+// Bundle frame on screen, identified by the bundle's creation time
+struct BundleState {
+    uint32_t magic;
+    uint32_t created;
+    int32_t shown;
+};
+
+RTC_DATA_ATTR static BundleState bundleState;
+
+#define SOURCE_STATE_MAGIC 0x53435253   // "SRCS"
+#define SOURCE_STATS_WINDOW 100         // Attempts after which a source's counts are halved
+
+static const char* const frameSources[] = FRAME_SOURCES;
+#define FRAME_SOURCE_COUNT (int)(sizeof(frameSources) / sizeof(frameSources[0]))
+static_assert(sizeof(frameSources) / sizeof(frameSources[0]) <= MAX_FRAME_SOURCES,
+              "FRAME_SOURCES has more entries than MAX_FRAME_SOURCES");
+
+// Latency and success rate per frame source, reset when FRAME_SOURCES changes
+struct SourceStats {
+    uint16_t attempts;
+    uint16_t successes;
+    uint16_t latencyMs;         // Running average of connect plus first response
+    bool lastOk;
+};
+
+struct SourceState {
+    uint32_t magic;
+    uint32_t listHash;
+    SourceStats sources[MAX_FRAME_SOURCES];
+};
+
+RTC_DATA_ATTR static SourceState sourceState;
+static_assert(sizeof(ConditionalState) + sizeof(BundleState) + sizeof(SourceState) <= RTC_FETCHER_STATE_BYTES,
+              "Fetcher RTC state exceeds RTC_FETCHER_STATE_BYTES");
+
+static uint32_t sourceListHash() {
+    uint32_t hash = Framebuffer::HASH_SEED;
+    for (int i = 0; i < FRAME_SOURCE_COUNT; i++) {
+        hash = Framebuffer::hash((const uint8_t*)frameSources[i], strlen(frameSources[i]) + 1, hash);
+    }
+    return hash;
+}
+
+// Lower goes first: untried sources (to measure them), then the ones whose
+// last attempt worked by average latency, then the failed ones in list order
+static uint32_t sourceRank(int index) {
+    const SourceStats& stats = sourceState.sources[index];
+    if (stats.attempts == 0) return 0;
+    if (stats.lastOk) return 1 + stats.latencyMs;
+    return 0x10000 + index;
+}
+
+// Scheme, host and port of a FRAME_SOURCES entry
+static bool parseSourceOrigin(const char* source, bool& secure, String& host, uint16_t& port) {
+    String url = source;
+    int hostStart;
+    if (url.startsWith("https://")) {
+        secure = true;
+        port = 443;
+        hostStart = 8;
+    } else if (url.startsWith("http://")) {
+        secure = false;
+        port = 80;
+        hostStart = 7;
+    } else {
+        return false;
+    }
+    
+    int pathStart = url.indexOf('/', hostStart);
+    host = url.substring(hostStart, pathStart < 0 ? url.length() : pathStart);
+    int colon = host.indexOf(':');
+    if (colon >= 0) {
+        port = host.substring(colon + 1).toInt();
+        host = host.substring(0, colon);
+    }
+    return host.length() > 0 && port > 0;
+}
+
+static uint32_t urlHash(const String& url) {
+    return Framebuffer::hash((const uint8_t*)url.c_str(), url.length());
+}
+
+// Pulls an HTTP body for the decoders, never past Content-Length
+struct HttpBodyInput {
+    WiFiClient* stream;
+    int remaining;          // -1 when the server sent no Content-Length
+    DownloadStats* stats;   // Optional
+    unsigned long lastReadMs;
+};
+
+// Unix time of an HTTP date (IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT"),
+// 0 when the value is not one (e.g. "Expires: 0")
+static uint32_t parseHttpDate(const String& value) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char monthName[4];
+    int day, year, hour, minute, second;
+    if (sscanf(value.c_str(), "%*3s, %d %3s %d %d:%d:%d",
+               &day, monthName, &year, &hour, &minute, &second) != 6) {
+        return 0;
+    }
+    const char* found = strstr(months, monthName);
+    if (!found || strlen(monthName) != 3 || (found - months) % 3 != 0 || year < 1970) {
+        return 0;
+    }
+    
+    // Days since 1970-01-01 in the proleptic Gregorian calendar, years from March
+    int month = (found - months) / 3 + 1;
+    int y = year - (month <= 2);
+    int era = y / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long days = era * 146097L + dayOfEra - 719468;
+    return (uint32_t)days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// If-Range needs a strong ETag; the date works as well
+static String rangeValidator(const String& etag, const String& lastModified) {
+    return etag.length() > 0 && !etag.startsWith("W/") ? etag : lastModified;
+}
+
+// Next piece of the body, at most length bytes. Blocks until some arrived,
+// waiting on the socket up to the client timeout (set by beginRequest);
+// 0 at the end of the body, on timeout or when the connection closed.
+static size_t receiveChunk(HttpBodyInput* body, uint8_t* buffer, size_t length) {
+    if (body->remaining == 0) return 0;
+    if (body->remaining > 0 && length > (size_t)body->remaining) {
+        length = body->remaining;
+    }
+
+    unsigned long start = millis();
+    if (body->lastReadMs == 0) body->lastReadMs = start;
+#if TLS_SESSION_RESUMPTION
+    // Every request goes through the fetcher's ResumableTlsClient
+    int received = static_cast<ResumableTlsClient*>(body->stream)->receive(buffer, length,
+                                                                           body->stream->getTimeout());
+#else
+    int received = (int)body->stream->readBytes(buffer, length);
+#endif
+    unsigned long now = millis();
+
+    // A stall is a slow read that still delivered, or a timeout on an open
+    // connection with body bytes outstanding (remaining is > 0 or unknown
+    // here); the close ending a body without Content-Length is not one
+    DownloadStats* stats = body->stats;
+    if (stats) {
+        stats->waitMs += now - start;
+        bool timedOut = received == 0 && body->stream->connected();
+        if (timedOut || (received > 0 && now - start > DOWNLOAD_STALL_MS)) stats->stalls++;
+    }
+    if (received <= 0) return 0;
+
+    if (body->remaining > 0) body->remaining -= received;
+    if (stats) {
+        stats->bytes += received;
+        stats->chunks++;
+        if (stats->minChunk == 0 || (uint32_t)received < stats->minChunk) stats->minChunk = received;
+        if ((uint32_t)received > stats->maxChunk) stats->maxChunk = received;
+        stats->wallMs += now - body->lastReadMs;
+    }
+    body->lastReadMs = now;
+    return received;
+}
+
+// StreamInput for the decoders: fills length bytes unless the body ends
+static size_t readHttpBody(void* context, uint8_t* buffer, size_t length) {
+    HttpBodyInput* body = (HttpBodyInput*)context;
+    size_t total = 0;
+    while (total < length) {
+        size_t received = receiveChunk(body, buffer + total, length - total);
+        if (received == 0) break;
+        total += received;
+    }
+    return total;
+}
+
+// ArduinoJson reader over an HTTP body: small blocking reads instead of one
+// socket read per character, never past Content-Length
+struct HttpJsonReader {
+    HttpBodyInput* body;
+    uint8_t buffer[MANIFEST_READ_BUFFER];
+    size_t length;
+    size_t position;
+
+    int read() {
+        if (position == length) {
+            length = receiveChunk(body, buffer, sizeof(buffer));
+            position = 0;
+            if (length == 0) return -1;
+        }
+        return buffer[position++];
+    }
+
+    size_t readBytes(char* out, size_t count) {
+        size_t done = 0;
+        int c;
+        while (done < count && (c = read()) >= 0) {
+            out[done++] = (char)c;
+        }
+        return done;
+    }
+};
+
+// Stores decoded PNG rows into the frame buffer
+struct FrameRowSink {
+    const PngStreamDecoder* decoder;
+    uint8_t* frame;
+};
+
+static bool storeFrameRow(void* context, int row, const uint8_t* packedRow, size_t length) {
+    FrameRowSink* sink = (FrameRowSink*)context;
+
+    // Only full-size panel frames, landscape or portrait, fit the buffer
+    int width = sink->decoder->getWidth();
+    int height = sink->decoder->getHeight();
+    bool landscape = width == DISPLAY_WIDTH && height == DISPLAY_HEIGHT;
+    bool portrait = width == PORTRAIT_WIDTH && height == PORTRAIT_HEIGHT;
+    if (!landscape && !portrait) {
+        Serial.printf("PNG is %dx%d, expected %dx%d or %dx%d\n", width, height,
+                      DISPLAY_WIDTH, DISPLAY_HEIGHT, PORTRAIT_WIDTH, PORTRAIT_HEIGHT);
+        return false;
+    }
+
+    memcpy(sink->frame + row * length, packedRow, length);
+    return true;
+}
 
 GitHubImageFetcher::GitHubImageFetcher(ConfigManager* configMgr) : 
-    configManager(configMgr), imageBuffer(nullptr), bufferSize(0), bufferAllocated(false) {
+    configManager(configMgr), imageBuffer(nullptr), bufferSize(0), bufferAllocated(false),
+    portraitImage(false), expectedFrameHash(0), digestExpected(false), notModified(false), pendingUrlHash(0),
+    pendingBodyBytes(0), pendingFrameHash(0), refreshSkipped(false), source(-1), sourceSecure(true), sourceRecorded(false),
+    sourceConnectMs(0) {
+    memset(&widgetData, 0, sizeof(widgetData));
+    memset(&manifest, 0, sizeof(manifest));
+    memset(&connectionStats, 0, sizeof(connectionStats));
+    memset(&downloadStats, 0, sizeof(downloadStats));
+    memset(&freshness, 0, sizeof(freshness));
+    freshness.maxAge = -1;
+    
+#if !TLS_SESSION_RESUMPTION
+    // Configure SSL client to skip certificate verification for GitHub
+    client.setInsecure();
+#endif
+}
+
+GitHubImageFetcher::~GitHubImageFetcher() {
+    freeBuffer();
+}
+
+bool GitHubImageFetcher::fetchManifest() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch manifest: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch manifest: WiFi not connected");
+        return false;
+    }
+    
+    memset(&manifest, 0, sizeof(manifest));
+    notModified = false;
+    String manifestURL = buildMapAssetURL("_manifest.json");
+    Serial.printf("Fetching manifest: %s\n", manifestURL.c_str());
+    
+    if (!beginRequest(manifestURL, 10000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/json");
+    
+    int httpCode = sendRequest();
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Manifest GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    int size = http.getSize();
+    if (size <= 0 || size > MAX_MANIFEST_SIZE) {
+        Serial.printf("Invalid manifest size: %d bytes\n", size);
+        endRequest(false);
+        return false;
+    }
+    
+    // Parsed as it arrives; the filter keeps only the fields used here, so
+    // fields a later server adds cost neither memory nor time
+    JsonDocument filter;
+    filter["hash"] = true;
+    filter["size"] = true;
+    filter["width"] = true;
+    filter["height"] = true;
+    filter["generated"] = true;
+    filter["next_update"] = true;
+    filter["patch_base"] = true;
+    filter["encodings"] = true;
+    filter["sha256"] = true;
+    
+    HttpBodyInput body = { http.getStreamPtr(), size, &downloadStats };
+    HttpJsonReader reader = { &body };
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, reader, DeserializationOption::Filter(filter));
+    
+    // Trailing whitespace after the document still belongs to the body
+    uint8_t rest[16];
+    while (!error && readHttpBody(&body, rest, sizeof(rest)) > 0) {
+    }
+    endRequest(!error && body.remaining == 0);
+    
+    if (error) {
+        Serial.printf("Manifest parse error: %s\n", error.c_str());
+        return false;
+    }
+    
+    manifest.hash = doc["hash"] | (uint32_t)0;
+    manifest.size = doc["size"] | (uint32_t)0;
+    manifest.width = doc["width"] | (uint16_t)DISPLAY_WIDTH;
+    manifest.height = doc["height"] | (uint16_t)DISPLAY_HEIGHT;
+    manifest.generated = doc["generated"] | (uint32_t)0;
+    manifest.nextUpdate = doc["next_update"] | (uint32_t)0;
+    manifest.patchBase = doc["patch_base"] | (uint32_t)0;
+    manifest.hasSha256 = FrameDigest::parseHex(doc["sha256"] | "", manifest.sha256);
+    JsonObject encodings = doc["encodings"];
+    static const struct { const char* name; FrameManifest::Encoding bit; } names[] = {
+        { "bin", FrameManifest::ENCODING_BIN }, { "binz", FrameManifest::ENCODING_BINZ },
+        { "epd_png", FrameManifest::ENCODING_EPD_PNG }, { "bpatch", FrameManifest::ENCODING_BPATCH },
+        { "tiles", FrameManifest::ENCODING_TILES }, { "bundle", FrameManifest::ENCODING_BUNDLE },
+        { "widgets", FrameManifest::ENCODING_WIDGETS }, { "vmap", FrameManifest::ENCODING_VMAP }
+    };
+    for (const auto& entry : names) {
+        if (!encodings[entry.name].isNull()) manifest.encodings |= entry.bit;
+    }
+    if (manifest.hash == 0) {
+        Serial.println("Manifest has no frame hash");
+        return false;
+    }
+    manifest.loaded = true;
+    expectedFrameHash = manifest.hash;
+    
+    Serial.printf("Manifest: %d bytes, frame 0x%08X (%u bytes%s), generated %u, next update %u, encodings 0x%02X\n",
+                  size, manifest.hash, manifest.size, manifest.hasSha256 ? ", SHA-256" : "", manifest.generated,
+                  manifest.nextUpdate, manifest.encodings);
+    
+    if (conditionalState.magic == CONDITIONAL_STATE_MAGIC && conditionalState.frameHash == manifest.hash) {
+        Serial.println("Manifest: published frame is on screen");
+        notModified = true;
+    }
+    return true;
+}
+
+void GitHubImageFetcher::beginFrameDigest(bool bodyIsFrame) {
+    digestExpected = false;
+#if VERIFY_FRAME_DIGEST
+    if (manifest.loaded && manifest.hasSha256) {
+        memcpy(expectedDigest, manifest.sha256, sizeof(expectedDigest));
+        digestExpected = true;
+    } else if (bodyIsFrame) {
+        digestExpected = FrameDigest::parseDigestHeader(http.header("Digest"), expectedDigest);
+    }
+    if (digestExpected) {
+        frameDigest.begin();
+    }
+#endif
+}
+
+bool GitHubImageFetcher::checkFrameDigest() {
+    if (!digestExpected) {
+        return true;
+    }
+    digestExpected = false;
+    return frameDigest.verify(expectedDigest);
+}
+
+void GitHubImageFetcher::abandonFrameDigest() {
+    digestExpected = false;
+    frameDigest.cancel();
+}
+
+bool GitHubImageFetcher::checkFrameDigest(const uint8_t* frame, size_t size) {
+    beginFrameDigest(false);
+    frameDigest.update(frame, size);
+    return checkFrameDigest();
+}
+
+bool GitHubImageFetcher::publishedPortrait() const {
+    return manifest.loaded && manifest.width == PORTRAIT_WIDTH && manifest.height == PORTRAIT_HEIGHT;
+}
+
+bool GitHubImageFetcher::manifestOffers(FrameManifest::Encoding encoding, const char* name) {
+    if (manifest.loaded) {
+        if (manifest.encodings & encoding) return true;
+        Serial.printf("Manifest lists no %s - skipped\n", name);
+        return false;
+    }
+    
+    // Nothing says the file exists: only request it when configured to
+    if ((ENCODINGS_WITHOUT_MANIFEST) & encoding) return true;
+    Serial.printf("No manifest - %s not requested\n", name);
+    return false;
+}
+
+bool GitHubImageFetcher::fetchLatestImage() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch image: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch image: WiFi not connected");
+        return false;
+    }
+    
+    String imageURL = buildImageURL();
+    if (imageURL.length() == 0) {
+        Serial.println("Cannot fetch image: invalid URL");
+        return false;
+    }
+    
+    Serial.printf("Fetching image from: %s\n", imageURL.c_str());
+    
+    // Free previous buffer if exists
+    freeBuffer();
+    
+#if FETCH_EPD_PNG
+    // The palette PNG carries the same frame in fewer bytes; maps without
+    // one (or a failed decode) fall back to the raw binary frame
+    String pngURL = buildPngURL();
+    if (pngURL.length() > 0 && manifestOffers(FrameManifest::ENCODING_EPD_PNG, "_epd.png")) {
+        Serial.printf("Trying PNG frame: %s\n", pngURL.c_str());
+        if (downloadPngImage(pngURL, true, !publishedPortrait())) {
+            if (checkFrameDigest(imageBuffer, bufferSize)) {
+                stageFrameCache(pngURL);
+                return true;
+            }
+            freeBuffer();
+        }
+        if (notModified) {
+            return false;
+        }
+        Serial.println("PNG frame not available - falling back to binary frame");
+    }
+#endif
+    
+    portraitImage = publishedPortrait();
+    return downloadImage(imageURL, imageBuffer, bufferSize,
+                         portraitImage ? FrameCache::FORMAT_PORTRAIT : FrameCache::FORMAT_LANDSCAPE);
+}
+
+bool GitHubImageFetcher::fetchPatchedFrame() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch frame patch: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch frame patch: WiFi not connected");
+        return false;
+    }
+    
+    FrameCache::Entry cached;
+    if (!frameCache.getStoredEntry(cached)) {
+        Serial.println("No cached frame to patch");
+        return false;
+    }
+    uint32_t cachedHash = cached.hash;
+    if (!manifestOffers(FrameManifest::ENCODING_BPATCH, ".bpatch")) {
+        return false;
+    }
+    if (manifest.loaded && manifest.patchBase != cachedHash) {
+        Serial.printf("Manifest: patch is for 0x%08X, cached frame is 0x%08X\n", manifest.patchBase, cachedHash);
+        return false;
+    }
+    
+    String patchURL = buildMapAssetURL(".bpatch");
+    Serial.printf("Fetching frame patch: %s\n", patchURL.c_str());
+    
+    if (!beginRequest(patchURL, 30000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/octet-stream");
+    addConditionalHeaders(http, patchURL);
+    
+    unsigned long requestStart = millis();
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Frame patch GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    int size = http.getSize();
+    if (size <= FramePatch::HEADER_SIZE || size > MAX_IMAGE_SIZE) {
+        Serial.printf("Invalid frame patch size: %d bytes\n", size);
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, patchURL, size);
+    
+    // The header names the frame the patch was made against: a device that
+    // missed a server run has an older one and needs the full frame
+    HttpBodyInput body = { http.getStreamPtr(), size, &downloadStats };
+    if (!framePatch.begin(readHttpBody, &body)) {
+        Serial.printf("Frame patch rejected: %s\n", framePatch.getError());
+        endRequest(false);
+        return false;
+    }
+    if (framePatch.getBaseHash() != cachedHash) {
+        Serial.printf("Frame patch is for 0x%08X, cached frame is 0x%08X\n",
+                      framePatch.getBaseHash(), cachedHash);
+        framePatch.end();
+        endRequest(false);
+        return false;
+    }
+    
+    freeBuffer();
+    size_t frameSize = (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2;
+    uint8_t* frame = (uint8_t*)ps_malloc(frameSize);
+    if (!frame) {
+        frame = (uint8_t*)malloc(frameSize);
+    }
+    if (!frame || !frameCache.load(frame, frameSize, cachedHash)) {
+        free(frame);
+        framePatch.end();
+        endRequest(false);
+        return false;
+    }
+    
+    // Runs are inflated straight into the cached frame
+    unsigned long bodyStart = millis();
+    bool applied = framePatch.apply(frame, frameSize);
+    framePatch.end();
+    endRequest(applied && body.remaining == 0);
+    
+    Serial.printf("Frame patch: %u bytes, %u runs, %u bytes changed: %lu ms request, %lu ms body\n",
+                  framePatch.getPatchSize(), framePatch.getRunCount(), framePatch.getChangedBytes(),
+                  bodyStart - requestStart, millis() - bodyStart);
+    
+    if (!applied) {
+        Serial.printf("Frame patch failed: %s\n", framePatch.getError());
+        free(frame);
+        return false;
+    }
+    
+    if (expectedFrameHash != 0 && framePatch.getFrameHash() != expectedFrameHash) {
+        Serial.printf("Frame hash 0x%08X does not match published 0x%08X\n",
+                      framePatch.getFrameHash(), expectedFrameHash);
+        free(frame);
+        return false;
+    }
+    if (!checkFrameDigest(frame, frameSize)) {
+        free(frame);
+        return false;
+    }
+    
+    imageBuffer = frame;
+    bufferSize = frameSize;
+    bufferAllocated = true;
+    // A patch keeps the layout of the frame it was made against
+    portraitImage = cached.format == FrameCache::FORMAT_PORTRAIT;
+    stageFrameCache(patchURL);
+    return true;
+}
+
+bool GitHubImageFetcher::fetchTiledFrame() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch tiled frame: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch tiled frame: WiFi not connected");
+        return false;
+    }
+    
+    // Tiles exist for landscape frames only
+    FrameCache::Entry entry;
+    if (publishedPortrait() || !frameCache.getStoredEntry(entry) || entry.format != FrameCache::FORMAT_LANDSCAPE) {
+        Serial.println("No cached landscape frame to update tiles of");
+        return false;
+    }
+    if (!manifestOffers(FrameManifest::ENCODING_TILES, ".tiles")) {
+        return false;
+    }
+    
+    String tilesURL = buildMapAssetURL(".tiles");
+    Serial.printf("Fetching tile index: %s\n", tilesURL.c_str());
+    
+    if (!beginRequest(tilesURL, 30000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/octet-stream");
+    http.addHeader("Range", "bytes=0-" + String(TiledFrame::INDEX_SIZE - 1));
+    addConditionalHeaders(http, tilesURL);
+    
+    unsigned long requestStart = millis();
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_PARTIAL_CONTENT || http.getSize() != (int)TiledFrame::INDEX_SIZE) {
+        Serial.printf("Tile index GET failed with code: %d (%d bytes)\n", httpCode, http.getSize());
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, tilesURL, TiledFrame::INDEX_SIZE);
+    
+    // Tile ranges must come from the file the index was read from
+    String validator = rangeValidator(pendingEtag, pendingLastModified);
+    
+    static uint8_t index[TiledFrame::INDEX_SIZE];
+    HttpBodyInput body = { http.getStreamPtr(), (int)TiledFrame::INDEX_SIZE, &downloadStats };
+    bool received = readHttpBody(&body, index, sizeof(index)) == sizeof(index);
+    endRequest(received);
+    if (!received || !tiledFrame.parseIndex(index, sizeof(index))) {
+        Serial.printf("Tile index rejected: %s\n", received ? tiledFrame.getError() : "short read");
+        return false;
+    }
+    if (expectedFrameHash != 0 && tiledFrame.getFrameHash() != expectedFrameHash) {
+        Serial.printf("Tiled frame 0x%08X is not the published 0x%08X\n",
+                      tiledFrame.getFrameHash(), expectedFrameHash);
+        return false;
+    }
+    
+    freeBuffer();
+    size_t frameSize = (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2;
+    uint8_t* frame = (uint8_t*)ps_malloc(frameSize);
+    if (!frame) {
+        frame = (uint8_t*)malloc(frameSize);
+    }
+    if (!frame || !frameCache.load(frame, frameSize, entry.hash)) {
+        free(frame);
+        return false;
+    }
+    
+    // Any cached frame works as the base: only tiles that differ are fetched
+    TiledFrame::Range ranges[TILED_FRAME_MAX_RANGES];
+    int rangeCount = tiledFrame.planRanges(frame, ranges, TILED_FRAME_MAX_RANGES);
+    uint32_t totalBytes = TiledFrame::INDEX_SIZE;
+    unsigned long bodyStart = millis();
+    bool complete = true;
+    
+    for (int i = 0; i < rangeCount && complete; i++) {
+        uint32_t start = tiledFrame.rangeStart(ranges[i]);
+        uint32_t end = tiledFrame.rangeEnd(ranges[i]);
+        if (!beginRequest(tilesURL, 30000)) {
+            complete = false;
+            break;
+        }
+        http.addHeader("Accept", "application/octet-stream");
+        http.addHeader("Range", "bytes=" + String(start) + "-" + String(end - 1));
+        if (validator.length() > 0) {
+            http.addHeader("If-Range", validator);
+        }
+        
+        // A 200 instead of 206 means the file changed since the index
+        httpCode = sendRequest();
+        if (httpCode != HTTP_CODE_PARTIAL_CONTENT || http.getSize() != (int)(end - start)) {
+            Serial.printf("Tile range GET failed with code: %d\n", httpCode);
+            endRequest(false);
+            complete = false;
+            break;
+        }
+        
+        HttpBodyInput rangeBody = { http.getStreamPtr(), (int)(end - start), &downloadStats };
+        complete = tiledFrame.decodeRange(ranges[i], readHttpBody, &rangeBody, frame);
+        endRequest(complete && rangeBody.remaining == 0);
+        totalBytes += end - start;
+    }
+    tiledFrame.end();
+    
+    Serial.printf("Tiled frame: %d/%d tiles changed, %d range requests, %u bytes: %lu ms index, %lu ms tiles\n",
+                  tiledFrame.getChangedTiles(), TiledFrame::TILE_COUNT, rangeCount, totalBytes,
+                  bodyStart - requestStart, millis() - bodyStart);
+    
+    if (!complete) {
+        Serial.printf("Tiled frame failed: %s\n", tiledFrame.getError() ? tiledFrame.getError() : "range request");
+        free(frame);
+        return false;
+    }
+    
+    // Each tile was checked; the whole frame must still be the indexed one
+    if (Framebuffer::hash(frame, frameSize) != tiledFrame.getFrameHash()) {
+        Serial.println("Tiled frame hash mismatch");
+        free(frame);
+        return false;
+    }
+    if (!checkFrameDigest(frame, frameSize)) {
+        free(frame);
+        return false;
+    }
+    
+    imageBuffer = frame;
+    bufferSize = frameSize;
+    bufferAllocated = true;
+    portraitImage = false;
+    pendingBodyBytes = totalBytes;
+    stageFrameCache(tilesURL);
+    return true;
+}
+
+String GitHubImageFetcher::buildImageURL() {
+    if (!configManager || !configManager->isConfigured()) {
+        return "";
+    }
+    
+    // Convert PNG path to binary e-paper format path
+    String imagePath = configManager->getGitHubImagePath();
+    if (imagePath.endsWith(".png")) {
+        imagePath = imagePath.substring(0, imagePath.length() - 4) + ".bin";
+    } else if (!imagePath.endsWith(".bin")) {
+        imagePath += ".bin";
+    }
+    
+    return buildSourceURL(imagePath);
+}
+
+String GitHubImageFetcher::buildPngURL() {
+    if (!configManager || !configManager->isConfigured()) {
+        return "";
+    }
+    
+    // Server publishes the quantised frame as <name>_epd.png next to <name>.png
+    String imagePath = configManager->getGitHubImagePath();
+    if (imagePath.endsWith(".bin")) {
+        imagePath = imagePath.substring(0, imagePath.length() - 4) + ".png";
+    }
+    if (!imagePath.endsWith(".png")) {
+        return "";
+    }
+    if (!imagePath.endsWith("_epd.png")) {
+        imagePath = imagePath.substring(0, imagePath.length() - 4) + "_epd.png";
+    }
+    
+    return buildSourceURL(imagePath);
+}
+
+String GitHubImageFetcher::buildMapAssetURL(const char* suffix) {
+    if (!configManager || !configManager->isConfigured()) {
+        return "";
+    }
+    
+    // Map assets share the configured path without its extension
+    String imagePath = configManager->getGitHubImagePath();
+    int extension = imagePath.lastIndexOf('.');
+    if (extension > imagePath.lastIndexOf('/')) {
+        imagePath = imagePath.substring(0, extension);
+    }
+    
+    return buildSourceURL(imagePath + suffix);
+}
+
+String GitHubImageFetcher::buildSourceURL(const String& path) {
+    // The source is picked (and connected) when the first URL of the wake is built
+    if (source < 0) {
+        selectSource();
+    }
+    
+    String url = frameSources[source];
+    url.replace("{repo}", configManager->getGitHubRepo());
+    url.replace("{path}", path);
+    return url;
+}
+
+bool GitHubImageFetcher::downloadWidgetData(const String& url) {
+    if (!beginRequest(url, 10000)) {
+        return false;
+    }
+    addConditionalHeaders(http, url);
+    
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Widget data GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    int size = http.getSize();
+    if (size > MAX_WIDGET_JSON_SIZE) {
+        Serial.printf("Widget data too large: %d bytes\n", size);
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, url, size);
+    
+    String payload = http.getString();
+    endRequest(true);
+    
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, payload);
+    if (error) {
+        Serial.printf("Widget data parse error: %s\n", error.c_str());
+        return false;
+    }
+    
+    memset(&widgetData, 0, sizeof(widgetData));
+    strncpy(widgetData.city, doc["city"] | "", sizeof(widgetData.city) - 1);
+    strncpy(widgetData.country, doc["country"] | "", sizeof(widgetData.country) - 1);
+    widgetData.latitude = doc["lat"] | 0.0f;
+    widgetData.longitude = doc["lng"] | 0.0f;
+    strncpy(widgetData.date, doc["date"] | "", sizeof(widgetData.date) - 1);
+    strncpy(widgetData.time, doc["time"] | "", sizeof(widgetData.time) - 1);
+    widgetData.hasWeather = !doc["temperature"].isNull();
+    widgetData.temperature = doc["temperature"] | 0;
+    strncpy(widgetData.icon, doc["icon"] | "", sizeof(widgetData.icon) - 1);
+    widgetData.baseMapHash = doc["base_hash"] | (uint32_t)0;
+    expectedFrameHash = doc["frame_hash"] | (uint32_t)0;
+    
+    if (widgetData.baseMapHash == 0) {
+        Serial.println("Widget data has no base map hash");
+        return false;
+    }
+    
+    Serial.printf("Widget data: %d bytes, %s %s, %d C, icon %s, base 0x%08X\n",
+                  payload.length(), widgetData.date, widgetData.time,
+                  widgetData.temperature, widgetData.icon, widgetData.baseMapHash);
+    return true;
+}
+
+bool GitHubImageFetcher::fetchWidgetFrame() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch widgets: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch widgets: WiFi not connected");
+        return false;
+    }
+    
+    if (!manifestOffers(FrameManifest::ENCODING_WIDGETS, "_widgets.json")) {
+        return false;
+    }
+
+    if (!downloadWidgetData(buildMapAssetURL("_widgets.json"))) {
+        return false;
+    }
+    
+    freeBuffer();
+    
+    // Unchanged base map: no image transfer at all
+    size_t frameSize = (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2;
+    if (baseMapCache.getStoredHash() == widgetData.baseMapHash) {
+        uint8_t* frame = (uint8_t*)ps_malloc(frameSize);
+        if (!frame) {
+            frame = (uint8_t*)malloc(frameSize);
+        }
+        if (frame && baseMapCache.load(frame, frameSize, widgetData.baseMapHash)) {
+            imageBuffer = frame;
+            bufferSize = frameSize;
+            bufferAllocated = true;
+            portraitImage = true;
+            return true;
+        }
+        free(frame);
+    }
+    
+    // New base map version: download it once and keep it in flash
+    String baseURL = buildMapAssetURL("_base_epd.png");
+    Serial.printf("Fetching base map: %s\n", baseURL.c_str());
+    if (!downloadPngImage(baseURL, false)) {
+        return false;
+    }
+    
+    // The widget document and the base map may come from different server
+    // runs while the CDN catches up; never cache or show a mismatched pair
+    uint32_t baseHash = Framebuffer::hash(imageBuffer, bufferSize);
+    if (!portraitImage || baseHash != widgetData.baseMapHash) {
+        Serial.printf("Base map hash 0x%08X does not match widget data 0x%08X\n",
+                      baseHash, widgetData.baseMapHash);
+        freeBuffer();
+        return false;
+    }
+    
+    baseMapCache.store(imageBuffer, bufferSize, baseHash);
+    return true;
+}
+
+bool GitHubImageFetcher::streamLatestImage(FrameChunkSink sink, void* sinkContext) {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot stream image: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot stream image: WiFi not connected");
+        return false;
+    }
+    
+    // Portrait frames need the whole frame before the first panel row
+    if (publishedPortrait()) {
+        return false;
+    }
+#if RESUME_DOWNLOADS
+    // Streaming would start over and overwrite the prefix kept in flash
+    if (hasPartialFrame()) {
+        Serial.println("Partial frame download kept - resuming it instead of streaming");
+        return false;
+    }
+#endif
+    
+    String imageURL = buildImageURL();
+    Serial.printf("Streaming image from: %s\n", imageURL.c_str());
+    
+    if (!beginRequest(imageURL, 30000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/octet-stream");
+#if ACCEPT_GZIP_ENCODING
+    http.addHeader("Accept-Encoding", "gzip");
+#endif
+    addConditionalHeaders(http, imageURL);
+    
+    unsigned long requestStart = millis();
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("HTTP GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    // A gzip body is only checked against the frame size once inflated
+    size_t frameSize = (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2;
+    bool gzipped = http.header("Content-Encoding").equalsIgnoreCase("gzip");
+    int size = http.getSize();
+    if (gzipped ? (size <= 0 || size > MAX_IMAGE_SIZE) : size != (int)frameSize) {
+        Serial.printf("Unexpected frame size: %d bytes (expected %u)\n", size, (unsigned)frameSize);
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, imageURL, size);
+    beginFrameDigest(!gzipped);
+    
+    // Chunks go to the panel as they arrive; meanwhile the TCP receive
+    // window keeps filling, so network and SPI time overlap
+    static uint8_t chunk[STREAM_CHUNK_SIZE];
+    WiFiClient* stream = http.getStreamPtr();
+    HttpBodyInput body = { stream, size, &downloadStats };
+    if (gzipped && !bodyInflater.begin(InflateStream::FORMAT_GZIP, readHttpBody, &body)) {
+        Serial.println("Out of memory for gzip window");
+        abandonFrameDigest();
+        endRequest(false);
+        return false;
+    }
+#if CACHE_LAST_FRAME
+    // The frame also goes to flash as the base of the next patch or tile update
+    frameCache.beginWrite(imageURL.c_str(), FrameCache::FORMAT_LANDSCAPE);
+#endif
+    size_t totalRead = 0;
+    uint32_t frameHash = Framebuffer::HASH_SEED;
+    unsigned long bodyStart = millis();
+    bool aborted = false;
+    
+    while (totalRead < frameSize) {
+        size_t wanted = frameSize - totalRead;
+        if (wanted > sizeof(chunk)) wanted = sizeof(chunk);
+        
+        // gzip pulls compressed bytes as needed and is short only at the end
+        // or on error; a raw body returns whatever the next read brought
+        size_t bytesRead = gzipped ? bodyInflater.read(chunk, wanted) : receiveChunk(&body, chunk, wanted);
+        if (bytesRead == 0) break;
+        
+        frameHash = Framebuffer::hash(chunk, bytesRead, frameHash);
+        frameDigest.update(chunk, bytesRead);
+        if (!sink(sinkContext, chunk, bytesRead)) {
+            aborted = true;
+            break;
+        }
+#if CACHE_LAST_FRAME
+        frameCache.write(chunk, bytesRead);
+#endif
+        totalRead += bytesRead;
+    }
+    
+    // The gzip stream has to end with the frame and its trailer must match
+    bool gzipValid = true;
+    if (gzipped) {
+        uint8_t extra;
+        gzipValid = !aborted && totalRead == frameSize &&
+                    bodyInflater.read(&extra, 1) == 0 && bodyInflater.isFinished();
+        if (!gzipValid && !aborted) {
+            Serial.printf("gzip body invalid: %s\n",
+                          bodyInflater.hasError() ? bodyInflater.getError() : "size does not match the frame");
+        }
+        bodyInflater.end();
+    }
+    endRequest(totalRead == frameSize && gzipValid && (!gzipped || body.remaining == 0));
+    
+    Serial.printf("Streamed %u/%u bytes%s: %lu ms request, %lu ms body\n",
+                  (unsigned)totalRead, (unsigned)frameSize, gzipped ? " (gzip)" : "", bodyStart - requestStart, millis() - bodyStart);
+    
+    if (aborted || totalRead != frameSize || !gzipValid) {
+        Serial.printf("Stream incomplete: %u/%u bytes\n", (unsigned)totalRead, (unsigned)frameSize);
+        abandonFrameDigest();
+#if RESUME_DOWNLOADS
+        // The panel never shows a partial frame, but the bytes written to
+        // flash let the buffered download fetch only the rest
+        if (!aborted && !gzipped && totalRead >= RESUME_MIN_BYTES) {
+            frameCache.savePartial(rangeValidator(pendingEtag, pendingLastModified).c_str(), frameSize);
+        }
+#endif
+        return false;
+    }
+    
+    if (expectedFrameHash != 0 && frameHash != expectedFrameHash) {
+        Serial.printf("Frame hash 0x%08X does not match published 0x%08X\n", frameHash, expectedFrameHash);
+        abandonFrameDigest();
+        return false;
+    }
+    // Before the caller refreshes the panel
+    if (!checkFrameDigest()) {
+        return false;
+    }
+    
+    pendingFrameHash = frameHash;
+#if CACHE_LAST_FRAME
+    frameCache.finishWrite(frameHash);
+#endif
+    return true;
+}
+
+bool GitHubImageFetcher::streamCompressedImage(FrameChunkSink sink, void* sinkContext) {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot stream image: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot stream image: WiFi not connected");
+        return false;
+    }
+    
+    // Portrait frames need the whole frame before the first panel row
+    if (publishedPortrait()) {
+        return false;
+    }
+#if RESUME_DOWNLOADS
+    // Streaming would start over and overwrite the prefix kept in flash
+    if (hasPartialFrame()) {
+        Serial.println("Partial frame download kept - resuming it instead of streaming");
+        return false;
+    }
+#endif
+    
+    if (!manifestOffers(FrameManifest::ENCODING_BINZ, ".binz")) {
+        return false;
+    }
+    
+    String binzURL = buildMapAssetURL(".binz");
+    Serial.printf("Streaming compressed image from: %s\n", binzURL.c_str());
+    
+    if (!beginRequest(binzURL, 30000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/octet-stream");
+    addConditionalHeaders(http, binzURL);
+    
+    unsigned long requestStart = millis();
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Compressed frame GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    int size = http.getSize();
+    if (size <= CompressedFrame::HEADER_SIZE || size > MAX_IMAGE_SIZE) {
+        Serial.printf("Invalid compressed frame size: %d bytes\n", size);
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, binzURL, size);
+    
+    HttpBodyInput body = { http.getStreamPtr(), size, &downloadStats };
+    unsigned long bodyStart = millis();
+    if (!compressedFrame.begin(readHttpBody, &body)) {
+        Serial.printf("Compressed frame rejected: %s\n", compressedFrame.getError());
+        endRequest(false);
+        return false;
+    }
+    if (compressedFrame.getWidth() != DISPLAY_WIDTH) {
+        Serial.println("Compressed frame is not a landscape frame");
+        compressedFrame.end();
+        endRequest(false);
+        return false;
+    }
+    
+    // Inflated pieces go to the panel like a raw .bin stream; only the
+    // window (1 KB by default) is kept as history
+    static uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t totalOut = 0;
+    bool aborted = false;
+    size_t produced;
+#if CACHE_LAST_FRAME
+    frameCache.beginWrite(binzURL.c_str(), FrameCache::FORMAT_LANDSCAPE);
+#endif
+    beginFrameDigest(false);
+    while ((produced = compressedFrame.read(chunk, sizeof(chunk))) > 0) {
+        frameDigest.update(chunk, produced);
+        if (!sink(sinkContext, chunk, produced)) {
+            aborted = true;
+            break;
+        }
+#if CACHE_LAST_FRAME
+        frameCache.write(chunk, produced);
+#endif
+        totalOut += produced;
+    }
+    bool complete = !aborted && compressedFrame.finish();
+    compressedFrame.end();
+    endRequest(complete && body.remaining == 0);
+    
+    Serial.printf("Inflated %u -> %u bytes (%.2fx, %u byte window): %lu ms request, %lu ms body\n",
+                  compressedFrame.getCompressedSize(), (unsigned)totalOut,
+                  (float)totalOut / compressedFrame.getCompressedSize(), (unsigned)compressedFrame.getWindowSize(),
+                  bodyStart - requestStart, millis() - bodyStart);
+    
+    if (!complete) {
+        Serial.printf("Compressed stream failed: %s\n",
+                      aborted ? "panel rejected data" : compressedFrame.getError());
+        abandonFrameDigest();
+        return false;
+    }
+    
+    if (expectedFrameHash != 0 && compressedFrame.getFrameHash() != expectedFrameHash) {
+        Serial.printf("Frame hash 0x%08X does not match published 0x%08X\n",
+                      compressedFrame.getFrameHash(), expectedFrameHash);
+        abandonFrameDigest();
+        return false;
+    }
+    if (!checkFrameDigest()) {
+        return false;
+    }
+    
+    pendingFrameHash = compressedFrame.getFrameHash();
+#if CACHE_LAST_FRAME
+    frameCache.finishWrite(compressedFrame.getFrameHash());
+#endif
+    return true;
+}
+
+bool GitHubImageFetcher::streamCachedFrame(FrameChunkSink sink, void* sinkContext) {
+    FrameCache::Entry entry;
+    if (!frameCache.getStoredEntry(entry) || entry.format != FrameCache::FORMAT_LANDSCAPE) {
+        Serial.println("No cached landscape frame to show");
+        return false;
+    }
+    
+    Serial.printf("Showing cached frame 0x%08X from %s\n", entry.hash, entry.url);
+    return frameCache.stream(sink, sinkContext);
+}
+
+#if CACHE_LAST_FRAME && REFRESH_MIN_CHANGED_PIXELS > 0
+// Cached frame read into bitplanes piece by piece
+struct BitplaneSink {
+    BitplaneFrame* planes;
+    size_t offset;
+};
+
+static bool bitplaneSink(void* context, const uint8_t* data, size_t length) {
+    BitplaneSink* sink = (BitplaneSink*)context;
+    if (!sink->planes->fromPacked(data, sink->offset, length)) {
+        return false;
+    }
+    sink->offset += length;
+    return true;
+}
+#endif
+
+bool GitHubImageFetcher::isMinorChange() {
+#if CACHE_LAST_FRAME && REFRESH_MIN_CHANGED_PIXELS > 0
+    refreshSkipped = false;
+    if (!hasImage() || conditionalState.magic != CONDITIONAL_STATE_MAGIC || conditionalState.panelBehind) {
+        return false;
+    }
+    
+    // The cached frame is only a reference when it is what the panel shows
+    FrameCache::Entry entry;
+    FrameCache::Format format = portraitImage ? FrameCache::FORMAT_PORTRAIT : FrameCache::FORMAT_LANDSCAPE;
+    if (!frameCache.getStoredEntry(entry) || entry.hash != conditionalState.frameHash ||
+        entry.size != bufferSize || entry.format != format) {
+        return false;
+    }
+    
+    int width = portraitImage ? DISPLAY_HEIGHT : DISPLAY_WIDTH;
+    int height = portraitImage ? DISPLAY_WIDTH : DISPLAY_HEIGHT;
+    BitplaneFrame shown(width, height);
+    BitplaneFrame next(width, height);
+    if (!shown.isAllocated() || !next.isAllocated() || shown.getWordsPerPlane() * 16 != bufferSize) {
+        return false;
+    }
+    
+    unsigned long start = micros();
+    BitplaneSink sink = { &shown, 0 };
+    if (!frameCache.stream(bitplaneSink, &sink)) {
+        return false;
+    }
+    unsigned long readMicros = micros() - start;
+    
+    start = micros();
+    next.fromPacked(imageBuffer);
+    size_t changed = BitplaneFrame::countChangedPixels(shown, next);
+    int firstRow, lastRow;
+    BitplaneFrame::changedRows(shown, next, firstRow, lastRow);
+    Serial.printf("Frame changes %u pixels in rows %d-%d (compared in %lu us after %lu us flash read)\n",
+                  (unsigned)changed, firstRow, lastRow, micros() - start, readMicros);
+    
+    refreshSkipped = changed < REFRESH_MIN_CHANGED_PIXELS;
+    return refreshSkipped;
+#else
+    return false;
+#endif
+}
+
+bool GitHubImageFetcher::fetchFrameBundle() {
+    if (!configManager || !configManager->isConfigured()) {
+        Serial.println("Cannot fetch frame bundle: configuration not available");
+        return false;
+    }
+    
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot fetch frame bundle: WiFi not connected");
+        return false;
+    }
+    
+    // Bundles only hold landscape frames
+    if (publishedPortrait()) {
+        return false;
+    }
     
-    // Configure SSL client to skip certificate verification for GitHub
-    client.setInsecure();
+    if (!manifestOffers(FrameManifest::ENCODING_BUNDLE, ".bundle")) {
+        return false;
+    }
+    
+    String bundleURL = buildMapAssetURL(".bundle");
+    Serial.printf("Fetching frame bundle: %s\n", bundleURL.c_str());
+    
+    if (!beginRequest(bundleURL, 30000)) {
+        return false;
+    }
+    http.addHeader("Accept", "application/octet-stream");
+    addConditionalHeaders(http, bundleURL);
+    
+    int httpCode = sendRequest();
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("Frame bundle GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
+    
+    int size = http.getSize();
+    if (size <= FrameBundle::HEADER_SIZE || size > FRAME_BUNDLE_MAX_SIZE) {
+        Serial.printf("Invalid frame bundle size: %d bytes\n", size);
+        endRequest(false);
+        return false;
+    }
+    if (!frameBundle.beginWrite(size)) {
+        endRequest(false);
+        return false;
+    }
+    rememberValidators(http, bundleURL, size);
+    
+    // Straight to flash: the bundle is several frames and never fits RAM
+    HttpBodyInput body = { http.getStreamPtr(), size, &downloadStats };
+    static uint8_t chunk[STREAM_CHUNK_SIZE];
+    unsigned long bodyStart = millis();
+    bool written = true;
+    size_t received;
+    while (written && (received = readHttpBody(&body, chunk, sizeof(chunk))) > 0) {
+        written = frameBundle.write(chunk, received);
+    }
+    bool complete = written && body.remaining == 0;
+    endRequest(complete);
+    
+    Serial.printf("Frame bundle: %d bytes in %lu ms\n", size - body.remaining, millis() - bodyStart);
+    if (!complete) {
+        frameBundle.abort();
+        return false;
+    }
+    if (!frameBundle.finishWrite()) {
+        return false;
+    }
+    return dueBundleFrame() >= 0;
 }
 
-GitHubImageFetcher::~GitHubImageFetcher() {
-    freeBuffer();
+int GitHubImageFetcher::dueBundleFrame() {
+    if (!frameBundle.begin() || !frameBundle.isLoaded()) {
+        return -1;
+    }
+    
+    // The RTC keeps the time set over NTP through deep sleep, not a power cycle
+    time_t now = time(nullptr);
+    if (now < CLOCK_VALID_AFTER) {
+        Serial.println("Frame bundle: clock not set");
+        return -1;
+    }
+    if ((uint32_t)now >= frameBundle.getStaleAfter()) {
+        Serial.println("Frame bundle: stale");
+        return -1;
+    }
+    
+    int index = frameBundle.dueFrame(now);
+    if (index < 0) {
+        Serial.println("Frame bundle: no frame due yet");
+        return -1;
+    }
+    if (index == frameBundle.getCount() - 1 && isBundleFrameShown(index)) {
+        Serial.println("Frame bundle: exhausted");
+        return -1;
+    }
+    return index;
 }
 
-bool GitHubImageFetcher::fetchLatestImage() {
+bool GitHubImageFetcher::isBundleFrameShown(int index) {
+    return bundleState.magic == BUNDLE_STATE_MAGIC && bundleState.created == frameBundle.getCreated() &&
+           bundleState.shown == index;
+}
+
+bool GitHubImageFetcher::streamBundleFrame(int index, FrameChunkSink sink, void* sinkContext) {
+    if (!frameBundle.stream(index, sink, sinkContext)) {
+        return false;
+    }
+    
+    bundleState.magic = BUNDLE_STATE_MAGIC;
+    bundleState.created = frameBundle.getCreated();
+    bundleState.shown = index;
+    
+    // Wakes without WiFi never commit validators: record the frame directly
+    pendingFrameHash = frameBundle.getEntry(index).hash;
+    if (conditionalState.magic == CONDITIONAL_STATE_MAGIC) {
+        conditionalState.frameHash = pendingFrameHash;
+    }
+    return true;
+}
+
+uint32_t GitHubImageFetcher::secondsToNextBundleFrame() {
+    if (!frameBundle.isLoaded() || bundleState.magic != BUNDLE_STATE_MAGIC ||
+        bundleState.created != frameBundle.getCreated() || bundleState.shown + 1 >= frameBundle.getCount()) {
+        return 0;
+    }
+    
+    time_t now = time(nullptr);
+    uint32_t nextAt = frameBundle.getEntry(bundleState.shown + 1).displayAt;
+    if (now < CLOCK_VALID_AFTER) {
+        return 0;
+    }
+    uint32_t wait = (uint32_t)now < nextAt ? nextAt - (uint32_t)now : 0;
+    return wait + FRAME_BUNDLE_WAKE_DELAY_S;
+}
+
+bool GitHubImageFetcher::fetchVectorMap() {
     if (!configManager || !configManager->isConfigured()) {
-        Serial.println("Cannot fetch image: configuration not available");
+        Serial.println("Cannot fetch vector map: configuration not available");
         return false;
     }
     
     if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("Cannot fetch image: WiFi not connected");
+        Serial.println("Cannot fetch vector map: WiFi not connected");
         return false;
     }
     
-    String imageURL = buildImageURL();
-    if (imageURL.length() == 0) {
-        Serial.println("Cannot fetch image: invalid URL");
+    freeBuffer();
+    portraitImage = false;
+    
+    if (!manifestOffers(FrameManifest::ENCODING_VMAP, ".vmap")) {
         return false;
     }
     
-    Serial.printf("Fetching image from: %s\n", imageURL.c_str());
+    String vectorURL = buildMapAssetURL(".vmap");
+    Serial.printf("Fetching vector map: %s\n", vectorURL.c_str());
+    return downloadImage(vectorURL, imageBuffer, bufferSize);
+}
+
+void GitHubImageFetcher::addConditionalHeaders(HTTPClient& request, const String& url) {
+    notModified = false;
     
-    // Free previous buffer if exists
-    freeBuffer();
+    if (conditionalState.magic != CONDITIONAL_STATE_MAGIC || conditionalState.urlHash != urlHash(url)) {
+        return;
+    }
+    if (conditionalState.etag[0]) {
+        request.addHeader("If-None-Match", conditionalState.etag);
+    }
+    if (conditionalState.lastModified[0]) {
+        request.addHeader("If-Modified-Since", conditionalState.lastModified);
+    }
+}
+
+bool GitHubImageFetcher::checkNotModified(int httpCode) {
+    if (httpCode != HTTP_CODE_NOT_MODIFIED) {
+        return false;
+    }
+    Serial.println("304 Not Modified - frame on screen is current");
+    notModified = true;
+    return true;
+}
+
+void GitHubImageFetcher::rememberValidators(HTTPClient& request, const String& url, int bodyBytes) {
+    pendingUrlHash = urlHash(url);
+    pendingEtag = request.header("ETag");
+    pendingLastModified = request.header("Last-Modified");
+    pendingBodyBytes = bodyBytes > 0 ? bodyBytes : 0;
+    pendingFrameHash = 0;
+}
+
+void GitHubImageFetcher::commitValidators() {
+    if (conditionalState.magic != CONDITIONAL_STATE_MAGIC) {
+        memset(&conditionalState, 0, sizeof(conditionalState));
+        conditionalState.magic = CONDITIONAL_STATE_MAGIC;
+    }
+    
+    conditionalState.urlHash = pendingUrlHash;
+    strncpy(conditionalState.etag, pendingEtag.c_str(), sizeof(conditionalState.etag) - 1);
+    conditionalState.etag[sizeof(conditionalState.etag) - 1] = '\0';
+    strncpy(conditionalState.lastModified, pendingLastModified.c_str(), sizeof(conditionalState.lastModified) - 1);
+    conditionalState.lastModified[sizeof(conditionalState.lastModified) - 1] = '\0';
+    conditionalState.lastBodyBytes = pendingBodyBytes;
+    conditionalState.frameHash = pendingFrameHash;
+    conditionalState.panelBehind = refreshSkipped;
+    conditionalState.lastAwakeMs = millis();
+    conditionalState.wakes++;
+    
+    // An over-long validator would never match; better to send none
+    if (pendingEtag.length() >= sizeof(conditionalState.etag)) conditionalState.etag[0] = '\0';
+    if (pendingLastModified.length() >= sizeof(conditionalState.lastModified)) conditionalState.lastModified[0] = '\0';
     
-    return downloadImage(imageURL, imageBuffer, bufferSize);
+#if CACHE_LAST_FRAME
+    frameCache.commit();
+#endif
 }
 
-String GitHubImageFetcher::buildImageURL() {
-    if (!configManager || !configManager->isConfigured()) {
-        return "";
+void GitHubImageFetcher::stageFrameCache(const String& url) {
+    pendingFrameHash = Framebuffer::hash(imageBuffer, bufferSize);
+#if CACHE_LAST_FRAME
+    frameCache.store(imageBuffer, bufferSize, pendingFrameHash, url.c_str(),
+                     portraitImage ? FrameCache::FORMAT_PORTRAIT : FrameCache::FORMAT_LANDSCAPE);
+#endif
+}
+
+bool GitHubImageFetcher::cacheDownload(const String& url, const uint8_t* data, size_t offset, size_t received,
+                                       size_t size, bool resumed, FrameCache::Format format) {
+#if CACHE_LAST_FRAME
+    if (format == FrameCache::FORMAT_NONE) {
+        return true;
     }
     
-    // GitHub raw URL format: https://raw.githubusercontent.com/owner/repo/branch/path
-    String url = "https://raw.githubusercontent.com/";
-    url += configManager->getGitHubRepo();
-    url += "/main/";  // Assuming main branch
+    // A resumed frame is only as good as its prefix: check all of it
+    bool complete = received == size;
+    uint32_t hash = complete ? Framebuffer::hash(data, size) : 0;
+    if (complete && expectedFrameHash != 0 && hash != expectedFrameHash) {
+        Serial.printf("Frame hash 0x%08X does not match published 0x%08X\n", hash, expectedFrameHash);
+        frameCache.abort();
+        return false;
+    }
+    pendingFrameHash = hash;
+#if RESUME_DOWNLOADS
+    String validator = rangeValidator(pendingEtag, pendingLastModified);
+    if (!complete && (received < RESUME_MIN_BYTES || validator.length() == 0)) {
+        return true;
+    }
+#else
+    if (!complete) {
+        return true;
+    }
+#endif
     
-    // Convert PNG path to binary e-paper format path
-    String imagePath = configManager->getGitHubImagePath();
-    if (imagePath.endsWith(".png")) {
-        imagePath = imagePath.substring(0, imagePath.length() - 4) + ".bin";
-    } else if (!imagePath.endsWith(".bin")) {
-        imagePath += ".bin";
+    bool started = resumed ? frameCache.resumeWrite() : frameCache.beginWrite(url.c_str(), format);
+    if (!started || !frameCache.write(data + offset, received - offset)) {
+        frameCache.abort();
+        return true;
+    }
+    if (complete) {
+        frameCache.finishWrite(hash);
+    }
+#if RESUME_DOWNLOADS
+    else {
+        frameCache.savePartial(validator.c_str(), size);
+    }
+#endif
+#endif
+    return true;
+}
+
+bool GitHubImageFetcher::hasPartialFrame() {
+#if RESUME_DOWNLOADS
+    FrameCache::Partial partial;
+    return frameCache.findPartial(buildImageURL().c_str(), partial);
+#else
+    return false;
+#endif
+}
+
+void GitHubImageFetcher::recordNotModified() {
+    unsigned long awakeMs = millis();
+    conditionalState.wakes++;
+    conditionalState.notModified++;
+    conditionalState.bytesSaved += conditionalState.lastBodyBytes;
+    if (conditionalState.lastAwakeMs > awakeMs) {
+        conditionalState.awakeMsSaved += conditionalState.lastAwakeMs - awakeMs;
+    }
+    
+    Serial.printf("Conditional GET: %u/%u wakes not modified (%.0f%%), %u KB and %u s awake saved\n",
+                  conditionalState.notModified, conditionalState.wakes,
+                  100.0f * conditionalState.notModified / conditionalState.wakes,
+                  conditionalState.bytesSaved / 1024, conditionalState.awakeMsSaved / 1000);
+}
+
+bool GitHubImageFetcher::downloadPngImage(const String& url, bool conditional, bool rotateToPanel) {
+    if (!beginRequest(url, 30000)) {
+        return false;
+    }
+    if (conditional) {
+        addConditionalHeaders(http, url);
     }
     
-    url += imagePath;
+    int httpCode = sendRequest();
+    if (conditional && checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        Serial.printf("PNG GET failed with code: %d\n", httpCode);
+        endRequest(false);
+        return false;
+    }
     
-    return url;
+    int contentLength = http.getSize();
+    if (contentLength > MAX_IMAGE_SIZE) {
+        Serial.printf("PNG too large: %d bytes (max: %d)\n", contentLength, MAX_IMAGE_SIZE);
+        endRequest(false);
+        return false;
+    }
+    if (conditional) {
+        rememberValidators(http, url, contentLength);
+    }
+    
+    size_t frameSize = (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 2;
+    uint8_t* frame = (uint8_t*)ps_malloc(frameSize);
+    if (!frame) {
+        frame = (uint8_t*)malloc(frameSize);
+        if (!frame) {
+            Serial.printf("Failed to allocate %u bytes for decoded frame\n", (unsigned)frameSize);
+            endRequest(false);
+            return false;
+        }
+    }
+    
+    HttpBodyInput body = { http.getStreamPtr(), contentLength, &downloadStats };
+    FrameRowSink sink = { &pngDecoder, frame };
+    
+    // Rows are inflated, unfiltered and mapped to panel colors as they arrive
+    unsigned long decodeStart = millis();
+    bool decoded = pngDecoder.decode(readHttpBody, &body, storeFrameRow, &sink);
+    unsigned long decodeTime = millis() - decodeStart;
+    // The decoder stops at IEND; a chunked or trailing body closes the connection
+    endRequest(decoded && body.remaining == 0);
+    
+    if (!decoded) {
+        Serial.printf("PNG decode failed: %s\n", pngDecoder.getError());
+        free(frame);
+        return false;
+    }
+    
+    Serial.printf("PNG %dx%d decoded in %lu ms (%u bytes of image data for a %u byte frame)\n",
+                  pngDecoder.getWidth(), pngDecoder.getHeight(), decodeTime,
+                  pngDecoder.getCompressedSize(), (unsigned)frameSize);
+    
+    // Frames are checked against the hash and SHA-256 of a landscape .bin,
+    // so a portrait decode is rotated before that; base maps stay portrait
+    bool portrait = pngDecoder.getWidth() == PORTRAIT_WIDTH;
+    if (portrait && rotateToPanel) {
+        uint8_t* landscape = (uint8_t*)ps_malloc(frameSize);
+        if (!landscape) {
+            landscape = (uint8_t*)malloc(frameSize);
+            if (!landscape) {
+                Serial.printf("Failed to allocate %u bytes for the rotated frame\n", (unsigned)frameSize);
+                free(frame);
+                return false;
+            }
+        }
+        FrameTranspose::portraitToLandscape(frame, landscape);
+        free(frame);
+        frame = landscape;
+        portrait = false;
+    }
+    
+    imageBuffer = frame;
+    bufferSize = frameSize;
+    bufferAllocated = true;
+    portraitImage = portrait;
+    return true;
 }
 
-bool GitHubImageFetcher::downloadImage(const String& url, uint8_t*& buffer, size_t& size) {
-    HTTPClient http;
-    http.begin(client, url);
+bool GitHubImageFetcher::downloadImage(const String& url, uint8_t*& buffer, size_t& size,
+                                       FrameCache::Format cacheAs) {
+    bool resuming = false;
+#if RESUME_DOWNLOADS
+    FrameCache::Partial partial;
+    resuming = cacheAs != FrameCache::FORMAT_NONE && frameCache.findPartial(url.c_str(), partial);
+#endif
     
-    // Set timeout
-    http.setTimeout(30000); // 30 seconds
+    if (!beginRequest(url, 30000)) {
+        return false;
+    }
     
     // Add headers for binary content
-    http.addHeader("User-Agent", "ESP32-SmartDashboard/1.0");
     http.addHeader("Accept", "application/octet-stream");
+#if ACCEPT_GZIP_ENCODING
+    // An encoded body cannot be resumed at a byte offset of the frame
+    if (!resuming) {
+        http.addHeader("Accept-Encoding", "gzip");
+    }
+#endif
+#if RESUME_DOWNLOADS
+    if (resuming) {
+        // The rest if the frame is still the same version, else all of it
+        Serial.printf("Resuming download at %u/%u bytes\n", partial.received, partial.size);
+        http.addHeader("Range", "bytes=" + String(partial.received) + "-");
+        http.addHeader("If-Range", partial.validator);
+    }
+#endif
+    addConditionalHeaders(http, url);
     
     Serial.println("Starting HTTP GET request for binary e-paper data...");
-    int httpCode = http.GET();
+    int httpCode = sendRequest();
     
-    if (httpCode != HTTP_CODE_OK) {
+    if (checkNotModified(httpCode)) {
+        endRequest(true);
+        return false;
+    }
+    
+    bool resumed = resuming && httpCode == HTTP_CODE_PARTIAL_CONTENT;
+    if (httpCode != HTTP_CODE_OK && !resumed) {
         Serial.printf("HTTP GET failed with code: %d\n", httpCode);
         if (httpCode > 0) {
             String payload = http.getString();
             Serial.printf("Error response: %s\n", payload.c_str());
         }
-        http.end();
+        endRequest(httpCode > 0);
         return false;
     }
+    if (resuming && !resumed) {
+        Serial.println("Frame changed since the partial download - starting over");
+    }
     
-    size = http.getSize();
-    Serial.printf("Binary e-paper data size: %d bytes\n", size);
+    int bodySize = http.getSize();
+    size_t offset = 0;      // Frame position of the first body byte
+    size = bodySize;
+#if RESUME_DOWNLOADS
+    if (resumed) {
+        // Only the missing end of the same frame is accepted
+        unsigned int first = 0, last = 0, total = 0;
+        String contentRange = http.header("Content-Range");
+        if (sscanf(contentRange.c_str(), "bytes %u-%u/%u", &first, &last, &total) != 3 ||
+            first != partial.received || last + 1 != total || total != partial.size ||
+            bodySize != (int)(total - first)) {
+            Serial.printf("Unexpected Content-Range: %s\n", contentRange.c_str());
+            endRequest(false);
+            return false;
+        }
+        offset = first;
+        size = total;
+    }
+#endif
+    Serial.printf("Binary e-paper data size: %u bytes\n", (unsigned)size);
     
-    if (size <= 0 || size > MAX_IMAGE_SIZE) {
-        Serial.printf("Invalid binary data size: %d bytes (max: %d)\n", size, MAX_IMAGE_SIZE);
-        http.end();
+    if (bodySize <= 0 || size > MAX_IMAGE_SIZE) {
+        Serial.printf("Invalid binary data size: %u bytes (max: %d)\n", (unsigned)size, MAX_IMAGE_SIZE);
+        endRequest(false);
         return false;
     }
+    rememberValidators(http, url, bodySize);
+    
+    if (http.header("Content-Encoding").equalsIgnoreCase("gzip")) {
+        // The decompressed length is only known at the end of the stream,
+        // so the buffer is sized for the largest accepted image
+        buffer = (uint8_t*)ps_malloc(MAX_IMAGE_SIZE);
+        if (!buffer) buffer = (uint8_t*)malloc(MAX_IMAGE_SIZE);
+        if (!buffer) {
+            Serial.printf("Failed to allocate %d bytes for e-paper buffer\n", MAX_IMAGE_SIZE);
+            endRequest(false);
+            return false;
+        }
+        
+        bool inflated = inflateBody(buffer, MAX_IMAGE_SIZE, size, bodySize);
+        endRequest(inflated);
+        if (!inflated) {
+            free(buffer);
+            buffer = nullptr;
+            size = 0;
+            return false;
+        }
+        
+        bool verified = cacheAs == FrameCache::FORMAT_NONE || checkFrameDigest(buffer, size);
+        if (!verified || !cacheDownload(url, buffer, 0, size, size, false, cacheAs)) {
+            free(buffer);
+            buffer = nullptr;
+            size = 0;
+            return false;
+        }
+        bufferAllocated = true;
+        bufferSize = size;
+        return true;
+    }
     
     // Allocate buffer for binary e-paper data
     buffer = (uint8_t*)malloc(size);
     if (!buffer) {
-        Serial.printf("Failed to allocate %d bytes for e-paper buffer\n", size);
-        http.end();
+        Serial.printf("Failed to allocate %u bytes for e-paper buffer\n", (unsigned)size);
+        endRequest(false);
         return false;
     }
     
-    // Read binary e-paper data
-    WiFiClient* stream = http.getStreamPtr();
-    size_t bytesRead = 0;
-    size_t totalRead = 0;
-    unsigned long timeout = millis();
+#if RESUME_DOWNLOADS
+    // The prefix comes back from flash, checked against its recorded hash
+    if (resumed && !frameCache.readPartial(buffer, size)) {
+        endRequest(false);
+        free(buffer);
+        buffer = nullptr;
+        size = 0;
+        return false;
+    }
+#endif
+    
+    // Read binary e-paper data in STREAM_CHUNK_SIZE pieces straight into
+    // the frame buffer; each read blocks until data arrived or timed out
+    HttpBodyInput body = { http.getStreamPtr(), bodySize, &downloadStats };
+    size_t totalRead = offset;
+    size_t nextProgress = offset + DOWNLOAD_PROGRESS_BYTES;
+    if (cacheAs != FrameCache::FORMAT_NONE) {
+        beginFrameDigest(true);
+        frameDigest.update(buffer, offset);
+    }
     
     Serial.println("Downloading binary e-paper data...");
     
-    while (totalRead < size && (millis() - timeout) < 30000) {
-        if (stream->available()) {
-            bytesRead = stream->readBytes(buffer + totalRead, size - totalRead);
-            totalRead += bytesRead;
-            timeout = millis(); // Reset timeout on successful read
-            
-            if (totalRead % 10000 == 0 || totalRead == size) {
-                Serial.printf("Downloaded: %d/%d bytes (%.1f%%)\n", 
-                             totalRead, size, (float)totalRead * 100.0 / size);
-            }
+    while (totalRead < size) {
+        size_t wanted = size - totalRead;
+        if (wanted > STREAM_CHUNK_SIZE) wanted = STREAM_CHUNK_SIZE;
+        
+        size_t bytesRead = receiveChunk(&body, buffer + totalRead, wanted);
+        if (bytesRead == 0) break;
+        frameDigest.update(buffer + totalRead, bytesRead);
+        totalRead += bytesRead;
+        
+        if (totalRead >= nextProgress || totalRead == size) {
+            Serial.printf("Downloaded: %u/%u bytes (%.1f%%)\n",
+                         (unsigned)totalRead, (unsigned)size, (float)totalRead * 100.0 / size);
+            nextProgress += DOWNLOAD_PROGRESS_BYTES;
         }
-        delay(1);
     }
     
-    http.end();
+    endRequest(totalRead == size);
     
+    // Whatever arrived is kept: the whole frame, or the prefix to resume;
+    // a frame that does not match its digest is not cached at all. Other
+    // bodies (.vmap) have no published digest and are not checked
+    bool isFrame = cacheAs != FrameCache::FORMAT_NONE;
     if (totalRead != size) {
-        Serial.printf("Download incomplete: %d/%d bytes\n", totalRead, size);
+        abandonFrameDigest();
+    }
+    bool verified = (!isFrame || totalRead != size || checkFrameDigest()) &&
+                    cacheDownload(url, buffer, offset, totalRead, size, resumed, cacheAs);
+    
+    if (totalRead != size || !verified) {
+        if (totalRead != size) {
+            Serial.printf("Download incomplete: %u/%u bytes\n", (unsigned)totalRead, (unsigned)size);
+        }
         free(buffer);
         buffer = nullptr;
         size = 0;
@@ -137,11 +1828,39 @@ bool GitHubImageFetcher::downloadImage(const String& url, uint8_t*& buffer, size
     
     bufferAllocated = true;
     bufferSize = size;
-    Serial.println("Binary image downloaded successfully!");
+    Serial.println(resumed ? "Binary image download resumed successfully!" : "Binary image downloaded successfully!");
     
     return true;
 }
 
+bool GitHubImageFetcher::inflateBody(uint8_t* buffer, size_t capacity, size_t& length, int contentLength) {
+    HttpBodyInput body = { http.getStreamPtr(), contentLength, &downloadStats };
+    if (!bodyInflater.begin(InflateStream::FORMAT_GZIP, readHttpBody, &body)) {
+        Serial.println("Out of memory for gzip window");
+        return false;
+    }
+    
+    unsigned long start = millis();
+    length = bodyInflater.read(buffer, capacity);
+    
+    // Anything past capacity means the body is larger than any valid image
+    uint8_t extra;
+    bool tooLarge = length == capacity && bodyInflater.read(&extra, 1) != 0;
+    bool valid = !tooLarge && bodyInflater.isFinished() && body.remaining == 0;
+    
+    Serial.printf("gzip: %d -> %u bytes (%.2fx) in %lu ms\n", contentLength, (unsigned)length,
+                  contentLength > 0 ? (float)length / contentLength : 0.0f, millis() - start);
+    if (tooLarge) {
+        Serial.printf("Decompressed data exceeds %u bytes\n", (unsigned)capacity);
+    } else if (!valid) {
+        Serial.printf("gzip body invalid: %s\n",
+                      bodyInflater.hasError() ? bodyInflater.getError() : "data after the gzip stream");
+    }
+    
+    bodyInflater.end();
+    return valid;
+}
+
 void GitHubImageFetcher::freeBuffer() {
     if (bufferAllocated && imageBuffer) {
         free(imageBuffer);
@@ -151,26 +1870,272 @@ void GitHubImageFetcher::freeBuffer() {
     }
 }
 
-bool GitHubImageFetcher::testConnection() {
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("WiFi not connected");
+bool GitHubImageFetcher::beginRequest(const String& url, uint16_t timeoutMs) {
+    // Every URL of a wake lives on one source, so the connection of the
+    // previous request is reused as long as the server kept it open
+    String requestURL = url;
+    if (!connection().connected()) {
+        if (connectionStats.unreachable) {
+            return false;
+        }
+        
+        // The first real request doubles as the connectivity test
+        int failed = source;
+        bool connected = source < 0 ? selectSource() : connectSource(source);
+        if (!connected && failed >= 0) {
+            // The wake's source stopped accepting connections: move the rest
+            // of the wake, this request included, to the next best one
+            recordSourceResult(false, 0);
+            connected = selectSource(failed);
+            if (connected) requestURL = rebaseURL(url, failed);
+        }
+        if (!connected) {
+            recordSourceResult(false, 0);
+            connectionStats.unreachable = true;
+            return false;
+        }
+    }
+    
+    static const char* responseHeaders[] = { "ETag", "Last-Modified", "Content-Encoding", "Content-Range",
+                                             "Date", "Expires", "Cache-Control", "Age", "Digest" };
+    http.begin(connection(), requestURL);
+    http.setReuse(true);
+    http.setTimeout(timeoutMs);
+    http.addHeader("User-Agent", "ESP32-SmartDashboard/1.0");
+    http.collectHeaders(responseHeaders, 9);
+    return true;
+}
+
+int GitHubImageFetcher::sendRequest() {
+    unsigned long requestStart = millis();
+    int httpCode = http.GET();
+    unsigned long requestMs = millis() - requestStart;
+    
+    connectionStats.requests++;
+    connectionStats.requestMs += requestMs;
+    if (requestMs > connectionStats.maxRequestMs) {
+        connectionStats.maxRequestMs = requestMs;
+    }
+    
+    // Time to the first response of the wake, connect included, rates the
+    // source; an error status (a mirror without the file, a captive portal)
+    // counts as a failure like a refused connection
+    bool served = (httpCode >= 200 && httpCode < 300) || httpCode == HTTP_CODE_NOT_MODIFIED;
+    recordSourceResult(served, sourceConnectMs + requestMs);
+    
+    if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_PARTIAL_CONTENT || httpCode == HTTP_CODE_NOT_MODIFIED) {
+        recordFreshness();
+    }
+    return httpCode;
+}
+
+WiFiClient& GitHubImageFetcher::connection() {
+#if TLS_SESSION_RESUMPTION
+    return client;  // Plaintext mode for http:// sources
+#else
+    if (!sourceSecure) return plainClient;
+    return client;
+#endif
+}
+
+bool GitHubImageFetcher::selectSource(int skip) {
+    if (sourceState.magic != SOURCE_STATE_MAGIC || sourceState.listHash != sourceListHash()) {
+        memset(&sourceState, 0, sizeof(sourceState));
+        sourceState.magic = SOURCE_STATE_MAGIC;
+        sourceState.listHash = sourceListHash();
+    }
+    
+    int order[MAX_FRAME_SOURCES];
+    for (int i = 0; i < FRAME_SOURCE_COUNT; i++) {
+        int j = i;
+        while (j > 0 && sourceRank(order[j - 1]) > sourceRank(i)) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    
+    for (int i = 0; i < FRAME_SOURCE_COUNT; i++) {
+        if (order[i] == skip) continue;
+        sourceRecorded = false;
+        if (connectSource(order[i])) {
+            Serial.printf("Frame source %d: %s\n", source, frameSources[source]);
+            return true;
+        }
+        recordSourceResult(false, 0);
+    }
+    
+    // URLs still need a source; no request is attempted this wake
+    source = order[0];
+    connectionStats.unreachable = true;
+    return false;
+}
+
+String GitHubImageFetcher::rebaseURL(const String& url, int from) {
+    String prefix = frameSources[from];
+    int pathAt = prefix.indexOf("{path}");
+    if (pathAt < 0) {
+        return url;
+    }
+    String suffix = prefix.substring(pathAt + 6);
+    prefix = prefix.substring(0, pathAt);
+    prefix.replace("{repo}", configManager->getGitHubRepo());
+    suffix.replace("{repo}", configManager->getGitHubRepo());
+    if (!url.startsWith(prefix) || !url.endsWith(suffix)) {
+        return url;
+    }
+    
+    String rebased = buildSourceURL(url.substring(prefix.length(), url.length() - suffix.length()));
+    Serial.printf("Request moved to source %d: %s\n", source, rebased.c_str());
+    return rebased;
+}
+
+bool GitHubImageFetcher::connectSource(int index) {
+    source = index;
+    
+    bool secure;
+    String host;
+    uint16_t port;
+    if (!parseSourceOrigin(frameSources[index], secure, host, port)) {
+        Serial.printf("Frame source %d: invalid URL %s\n", index, frameSources[index]);
         return false;
     }
+    sourceSecure = secure;
+#if TLS_SESSION_RESUMPTION
+    client.setPlaintext(!secure);
+#endif
     
-    HTTPClient http;
-    http.begin(client, "https://api.github.com");
-    http.setTimeout(10000);
+    unsigned long connectStart = millis();
+    if (!connection().connect(host.c_str(), port)) {
+        Serial.printf("Cannot connect to %s:%u after %lu ms\n", host.c_str(), port, millis() - connectStart);
+        return false;
+    }
+    sourceConnectMs = millis() - connectStart;
+    connectionStats.connections++;
+    connectionStats.handshakeMs += sourceConnectMs;
+    return true;
+}
+
+void GitHubImageFetcher::recordSourceResult(bool ok, unsigned long latencyMs) {
+    if (source < 0 || sourceRecorded) {
+        return;
+    }
+    sourceRecorded = true;
     
-    int httpCode = http.GET();
-    http.end();
+    SourceStats& stats = sourceState.sources[source];
+    if (stats.attempts >= SOURCE_STATS_WINDOW) {
+        stats.attempts /= 2;
+        stats.successes /= 2;
+    }
+    stats.attempts++;
+    stats.lastOk = ok;
+    if (ok) {
+        stats.successes++;
+        if (latencyMs > 0xFFFF) latencyMs = 0xFFFF;
+        stats.latencyMs = stats.latencyMs > 0 ? (stats.latencyMs * 3 + latencyMs) / 4 : latencyMs;
+    }
+}
+
+void GitHubImageFetcher::recordFreshness() {
+    freshness.receivedMs = millis();
+    freshness.date = parseHttpDate(http.header("Date"));
+    freshness.expires = parseHttpDate(http.header("Expires"));
+    freshness.maxAge = -1;
     
-    if (httpCode == HTTP_CODE_OK) {
-        Serial.println("GitHub connection test successful");
-        return true;
+    // A CDN copy has already been cached for Age seconds
+    String cacheControl = http.header("Cache-Control");
+    int maxAgeAt = cacheControl.indexOf("max-age=");
+    if (maxAgeAt >= 0) {
+        freshness.maxAge = cacheControl.substring(maxAgeAt + 8).toInt() - http.header("Age").toInt();
+        if (freshness.maxAge < 0) freshness.maxAge = 0;
+    }
+}
+
+bool GitHubImageFetcher::secondsToNextUpdate(uint32_t& seconds, uint32_t scheduleS) {
+    uint32_t elapsed = (millis() - freshness.receivedMs) / 1000;
+    
+    // Server time: its last Date plus the time since, else the NTP clock
+    uint32_t now = 0;
+    if (freshness.date > 0) {
+        now = freshness.date + elapsed;
+    } else if (time(nullptr) >= CLOCK_VALID_AFTER) {
+        now = (uint32_t)time(nullptr);
+    }
+    
+    // The manifest names the next run; max-age overrides Expires as in HTTP caching
+    int64_t remaining;
+    const char* origin;
+    bool cacheLifetime = true;
+    if (manifest.loaded && manifest.nextUpdate > 0 && now > 0) {
+        remaining = (int64_t)manifest.nextUpdate - now;
+        origin = "manifest next_update";
+        cacheLifetime = false;
+    } else if (freshness.maxAge >= 0) {
+        remaining = (int64_t)freshness.maxAge - elapsed;
+        origin = "Cache-Control max-age";
+    } else if (freshness.expires > 0 && now > 0) {
+        remaining = (int64_t)freshness.expires - now;
+        origin = "Expires";
     } else {
-        Serial.printf("GitHub connection test failed with code: %d\n", httpCode);
         return false;
     }
+    
+    // Cache lifetimes describe the CDN (raw.githubusercontent.com sends
+    // max-age=300), not the publisher: they may only lengthen the schedule
+    if (cacheLifetime && remaining <= (int64_t)scheduleS) {
+        Serial.printf("%s ends in %d s, before the fixed schedule - ignored\n", origin, (int)remaining);
+        return false;
+    }
+    
+    seconds = remaining > 0 ? (uint32_t)remaining : 0;
+    Serial.printf("Next update in %u s (%s)\n", seconds, origin);
+    return true;
+}
+
+void GitHubImageFetcher::endRequest(bool bodyConsumed) {
+    http.end();
+    
+    // Unread body bytes would be taken for the next response
+    if (!bodyConsumed) {
+        connection().stop();
+        return;
+    }
+    
+#if TLS_SESSION_RESUMPTION
+    // The session worked for a whole response: offer it on the next wake
+    client.saveSession();
+#endif
+}
+
+void GitHubImageFetcher::resetConnection() {
+    connection().stop();
+    connectionStats.unreachable = false;
+    source = -1;
+}
+
+void GitHubImageFetcher::logConnectionStats() const {
+    if (connectionStats.requests == 0) {
+        return;
+    }
+    
+    Serial.printf("HTTP: %u request(s) over %u connection(s), handshake %lu ms, request avg %lu ms, max %lu ms\n",
+                  connectionStats.requests, connectionStats.connections, connectionStats.handshakeMs,
+                  connectionStats.requestMs / connectionStats.requests, connectionStats.maxRequestMs);
+    
+    // Throughput over the time bodies were actually arriving
+    if (downloadStats.chunks > 0) {
+        Serial.printf("Download: %u bytes in %lu ms (%.1f KB/s), %u reads of %u-%u bytes, %lu ms waiting, %u stall(s)\n",
+                      downloadStats.bytes, downloadStats.wallMs,
+                      downloadStats.wallMs > 0 ? downloadStats.bytes / 1.024f / downloadStats.wallMs : 0.0f,
+                      downloadStats.chunks, downloadStats.minChunk, downloadStats.maxChunk,
+                      downloadStats.waitMs, downloadStats.stalls);
+    }
+    
+    for (int i = 0; i < FRAME_SOURCE_COUNT; i++) {
+        const SourceStats& stats = sourceState.sources[i];
+        Serial.printf("Source %d%s %s: %u/%u ok, avg %u ms%s\n", i, i == source ? "*" : " ", frameSources[i],
+                      stats.successes, stats.attempts, stats.latencyMs, stats.lastOk ? "" : ", last failed");
+    }
 }
 
 String GitHubImageFetcher::getLastError() const {
@@ -0,0 +1,528 @@
+#include "inflate_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Base values and extra bits for length symbols 257..285 and distance symbols
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Transmission order of the code length code lengths
+static const uint8_t CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// CRC-32 (reflected 0xEDB88320) four bits at a time from a 16-entry table
+static const uint32_t CRC32_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static uint32_t updateAdler32(uint32_t adler, const uint8_t* data, size_t length) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (length > 0) {
+        // 5552 is the largest run that cannot overflow b before the modulo
+        size_t run = length < 5552 ? length : 5552;
+        length -= run;
+        while (run--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+InflateStream::InflateStream() :
+    format(FORMAT_RAW), state(STATE_IDLE), error(nullptr),
+    input(nullptr), inputContext(nullptr), inputPos(0), inputLength(0), totalIn(0),
+    bitBuffer(0), bitCount(0), paddingBits(0),
+    window(nullptr), windowSize(0), totalOut(0), adler(1), crc(0),
+    lastBlock(false), fixedTablesLoaded(false),
+    storedRemaining(0), copyLength(0), copyDistance(0) {
+}
+
+InflateStream::~InflateStream() {
+    free(window);
+}
+
+bool InflateStream::begin(Format streamFormat, StreamInput source, void* context, size_t size) {
+    if (size < MIN_WINDOW_SIZE || size > WINDOW_SIZE || (size & (size - 1)) != 0) {
+        state = STATE_ERROR;
+        error = "unsupported window size";
+        return false;
+    }
+    if (window && windowSize != size) {
+        free(window);
+        window = nullptr;
+    }
+    if (!window) {
+        window = (uint8_t*)malloc(size);
+        windowSize = size;
+        if (!window) {
+            state = STATE_ERROR;
+            error = "out of memory for window";
+            return false;
+        }
+    }
+
+    format = streamFormat;
+    state = STATE_HEADER;
+    error = nullptr;
+    input = source;
+    inputContext = context;
+    inputPos = 0;
+    inputLength = 0;
+    totalIn = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    paddingBits = 0;
+    totalOut = 0;
+    adler = 1;
+    crc = 0;
+    lastBlock = false;
+    fixedTablesLoaded = false;
+    storedRemaining = 0;
+    copyLength = 0;
+    copyDistance = 0;
+    return true;
+}
+
+void InflateStream::end() {
+    free(window);
+    window = nullptr;
+    state = STATE_IDLE;
+}
+
+void InflateStream::fail(const char* message) {
+    if (state != STATE_ERROR) {
+        state = STATE_ERROR;
+        error = message;
+    }
+}
+
+bool InflateStream::fillBits(int count) {
+    while (bitCount < count) {
+        if (inputPos == inputLength && input) {
+            inputLength = input(inputContext, inputBuffer, sizeof(inputBuffer));
+            inputPos = 0;
+            totalIn += inputLength;
+            if (inputLength == 0) {
+                input = nullptr;  // Exhausted: never pull again
+            }
+        }
+
+        if (inputPos < inputLength) {
+            bitBuffer |= (uint32_t)inputBuffer[inputPos++] << bitCount;
+        } else {
+            // Zero padding lets table lookups run near the end of the data;
+            // consuming any of it means the stream was truncated
+            paddingBits += 8;
+        }
+        bitCount += 8;
+    }
+    return true;
+}
+
+void InflateStream::dropBits(int count) {
+    bitBuffer >>= count;
+    bitCount -= count;
+    if (bitCount < paddingBits) {
+        fail("unexpected end of compressed data");
+        paddingBits = bitCount;
+    }
+}
+
+uint32_t InflateStream::getBits(int count) {
+    if (count == 0) return 0;
+
+    fillBits(count);
+    uint32_t value = bitBuffer & ((1u << count) - 1);
+    dropBits(count);
+    return value;
+}
+
+int InflateStream::decodeSymbol(const Huffman& code) {
+    fillBits(MAX_BITS);
+
+    uint16_t entry = code.fast[bitBuffer & ((1u << FAST_BITS) - 1)];
+    if (entry) {
+        dropBits(entry >> 9);
+        return entry & 0x1FF;
+    }
+
+    // Longer codes: walk the canonical code one bit at a time
+    int value = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        value |= (bitBuffer >> (length - 1)) & 1;
+        int count = code.count[length];
+        if (value - first < count) {
+            dropBits(length);
+            return code.symbol[index + value - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        value <<= 1;
+    }
+
+    fail("invalid Huffman code");
+    return -1;
+}
+
+bool InflateStream::buildHuffman(Huffman& code, const uint8_t* lengths, int symbols) {
+    memset(code.count, 0, sizeof(code.count));
+    for (int i = 0; i < symbols; i++) {
+        code.count[lengths[i]]++;
+    }
+    code.count[0] = 0;
+
+    // Reject over-subscribed codes; incomplete ones fail when a gap is hit
+    int left = 1;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        left = (left << 1) - code.count[length];
+        if (left < 0) return false;
+    }
+
+    uint16_t offsets[MAX_BITS + 2];
+    uint16_t nextCode[MAX_BITS + 1];
+    offsets[1] = 0;
+    nextCode[0] = 0;
+    int value = 0;
+    for (int length = 1; length <= MAX_BITS; length++) {
+        offsets[length + 1] = offsets[length] + code.count[length];
+        value = (value + code.count[length - 1]) << 1;
+        nextCode[length] = value;
+    }
+
+    memset(code.fast, 0, sizeof(code.fast));
+    for (int sym = 0; sym < symbols; sym++) {
+        int length = lengths[sym];
+        if (length == 0) continue;
+
+        code.symbol[offsets[length]++] = sym;
+
+        int codeValue = nextCode[length]++;
+        if (length > FAST_BITS) continue;
+
+        // DEFLATE sends codes MSB first; the bit buffer is LSB first
+        int reversed = 0;
+        for (int bit = 0; bit < length; bit++) {
+            reversed = (reversed << 1) | ((codeValue >> bit) & 1);
+        }
+        for (int slot = reversed; slot < (1 << FAST_BITS); slot += 1 << length) {
+            code.fast[slot] = (length << 9) | sym;
+        }
+    }
+    return true;
+}
+
+bool InflateStream::readHeader() {
+    if (format == FORMAT_GZIP) {
+        uint32_t id1 = getBits(8);
+        uint32_t id2 = getBits(8);
+        uint32_t method = getBits(8);
+        uint32_t flags = getBits(8);
+        if (id1 != 0x1F || id2 != 0x8B || method != 8 || (flags & 0xE0)) {
+            fail("invalid gzip header");
+            return false;
+        }
+        // MTIME, XFL and OS are not needed
+        for (int i = 0; i < 6; i++) getBits(8);
+
+        if (flags & 0x04) {
+            // FEXTRA
+            uint32_t extraLength = getBits(16);
+            while (extraLength-- > 0 && state != STATE_ERROR) getBits(8);
+        }
+        // FNAME and FCOMMENT are zero terminated
+        for (uint32_t field = 0x08; field <= 0x10; field <<= 1) {
+            if (flags & field) {
+                while (getBits(8) != 0 && state != STATE_ERROR) {}
+            }
+        }
+        if (flags & 0x02) {
+            // FHCRC is optional and not checked
+            getBits(16);
+        }
+    } else if (format == FORMAT_ZLIB) {
+        uint32_t cmf = getBits(8);
+        uint32_t flg = getBits(8);
+        if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0) {
+            fail("invalid zlib header");
+            return false;
+        }
+        if (flg & 0x20) {
+            fail("preset dictionary not supported");
+            return false;
+        }
+    }
+    return state != STATE_ERROR;
+}
+
+bool InflateStream::readBlockHeader() {
+    lastBlock = getBits(1);
+    uint32_t type = getBits(2);
+
+    if (type == 0) {
+        // Stored block: byte aligned LEN and its complement
+        dropBits(bitCount % 8);
+        uint32_t length = getBits(16);
+        uint32_t complement = getBits(16);
+        if (length != (~complement & 0xFFFF)) {
+            fail("stored block length mismatch");
+            return false;
+        }
+        storedRemaining = length;
+        state = STATE_STORED;
+    } else if (type == 1) {
+        if (!fixedTablesLoaded) {
+            uint8_t lengths[288];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            buildHuffman(literalCode, lengths, 288);
+            memset(lengths, 5, 30);
+            buildHuffman(distanceCode, lengths, 30);
+            fixedTablesLoaded = true;
+        }
+        state = STATE_CODES;
+    } else if (type == 2) {
+        if (!readDynamicTables()) return false;
+        state = STATE_CODES;
+    } else {
+        fail("invalid block type");
+        return false;
+    }
+    return state != STATE_ERROR;
+}
+
+bool InflateStream::readDynamicTables() {
+    fixedTablesLoaded = false;
+
+    int literals = getBits(5) + 257;
+    int distances = getBits(5) + 1;
+    int codeLengths = getBits(4) + 4;
+    if (literals > 286 || distances > 30) {
+        fail("too many length or distance codes");
+        return false;
+    }
+
+    uint8_t lengths[286 + 30];
+    memset(lengths, 0, 19);
+    for (int i = 0; i < codeLengths; i++) {
+        lengths[CODE_LENGTH_ORDER[i]] = getBits(3);
+    }
+
+    // The code length code is built in the distance table, replaced below
+    if (!buildHuffman(distanceCode, lengths, 19)) {
+        fail("invalid code length code");
+        return false;
+    }
+
+    int index = 0;
+    while (index < literals + distances && state != STATE_ERROR) {
+        int sym = decodeSymbol(distanceCode);
+        if (sym < 0) return false;
+
+        if (sym < 16) {
+            lengths[index++] = sym;
+            continue;
+        }
+
+        uint8_t repeatLength = 0;
+        int repeat;
+        if (sym == 16) {
+            if (index == 0) {
+                fail("repeat with no previous length");
+                return false;
+            }
+            repeatLength = lengths[index - 1];
+            repeat = 3 + getBits(2);
+        } else if (sym == 17) {
+            repeat = 3 + getBits(3);
+        } else {
+            repeat = 11 + getBits(7);
+        }
+
+        if (index + repeat > literals + distances) {
+            fail("too many code lengths");
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = repeatLength;
+        }
+    }
+
+    if (state == STATE_ERROR) return false;
+    if (lengths[256] == 0) {
+        fail("missing end-of-block code");
+        return false;
+    }
+
+    if (!buildHuffman(literalCode, lengths, literals) ||
+        !buildHuffman(distanceCode, lengths + literals, distances)) {
+        fail("invalid literal/length or distance code");
+        return false;
+    }
+    return true;
+}
+
+bool InflateStream::readTrailer() {
+    if (format == FORMAT_ZLIB) {
+        dropBits(bitCount % 8);
+        uint32_t expected = 0;
+        for (int i = 0; i < 4; i++) {
+            expected = (expected << 8) | getBits(8);
+        }
+        if (state != STATE_ERROR && expected != adler) {
+            fail("Adler-32 mismatch");
+            return false;
+        }
+    } else if (format == FORMAT_GZIP) {
+        dropBits(bitCount % 8);
+        uint32_t expectedCrc = getBits(16);
+        expectedCrc |= getBits(16) << 16;
+        uint32_t expectedSize = getBits(16);
+        expectedSize |= getBits(16) << 16;
+        if (state != STATE_ERROR && expectedCrc != crc) {
+            fail("CRC-32 mismatch");
+            return false;
+        }
+        // ISIZE is the length modulo 2^32
+        if (state != STATE_ERROR && expectedSize != totalOut) {
+            fail("gzip size mismatch");
+            return false;
+        }
+    }
+    return state != STATE_ERROR;
+}
+
+void InflateStream::updateCheck(const uint8_t* data, size_t length) {
+    if (format == FORMAT_ZLIB) {
+        adler = updateAdler32(adler, data, length);
+    } else if (format == FORMAT_GZIP) {
+        crc = updateCrc32(crc, data, length);
+    }
+}
+
+size_t InflateStream::read(uint8_t* out, size_t length) {
+    const uint32_t windowMask = windowSize - 1;
+    size_t produced = 0;
+    size_t checked = 0;
+
+    while (produced < length && state != STATE_DONE && state != STATE_ERROR && state != STATE_IDLE) {
+        switch (state) {
+            case STATE_HEADER:
+                if (readHeader()) state = STATE_BLOCK;
+                break;
+
+            case STATE_BLOCK:
+                if (lastBlock) {
+                    state = STATE_TRAILER;
+                } else {
+                    readBlockHeader();
+                }
+                break;
+
+            case STATE_STORED:
+                while (storedRemaining > 0 && produced < length) {
+                    uint8_t value = getBits(8);
+                    if (state == STATE_ERROR) break;
+                    out[produced++] = value;
+                    window[totalOut++ & windowMask] = value;
+                    storedRemaining--;
+                }
+                if (storedRemaining == 0 && state == STATE_STORED) state = STATE_BLOCK;
+                break;
+
+            case STATE_CODES: {
+                int sym = decodeSymbol(literalCode);
+                if (sym < 0 || state == STATE_ERROR) break;
+
+                if (sym < 256) {
+                    out[produced++] = sym;
+                    window[totalOut++ & windowMask] = sym;
+                } else if (sym == 256) {
+                    state = STATE_BLOCK;
+                } else {
+                    sym -= 257;
+                    if (sym >= 29) {
+                        fail("invalid length symbol");
+                        break;
+                    }
+                    copyLength = LENGTH_BASE[sym] + getBits(LENGTH_EXTRA[sym]);
+
+                    int distanceSym = decodeSymbol(distanceCode);
+                    if (distanceSym < 0 || state == STATE_ERROR) break;
+                    if (distanceSym >= 30) {
+                        fail("invalid distance symbol");
+                        break;
+                    }
+                    copyDistance = DISTANCE_BASE[distanceSym] + getBits(DISTANCE_EXTRA[distanceSym]);
+                    if (copyDistance > totalOut) {
+                        fail("distance too far back");
+                        break;
+                    }
+                    if (copyDistance > windowSize) {
+                        fail("distance beyond window");
+                        break;
+                    }
+                    state = STATE_COPY;
+                }
+                break;
+            }
+
+            case STATE_COPY:
+                while (copyLength > 0 && produced < length) {
+                    uint8_t value = window[(totalOut - copyDistance) & windowMask];
+                    out[produced++] = value;
+                    window[totalOut++ & windowMask] = value;
+                    copyLength--;
+                }
+                if (copyLength == 0) state = STATE_CODES;
+                break;
+
+            case STATE_TRAILER:
+                // The checksum has to cover everything produced so far
+                updateCheck(out + checked, produced - checked);
+                checked = produced;
+                if (readTrailer()) state = STATE_DONE;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    updateCheck(out + checked, produced - checked);
+    return produced;
+}
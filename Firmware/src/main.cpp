@@ -11,6 +11,7 @@
 #include "github_fetcher.h"
 #include "utils.h"
 #include "battery_monitor.h"
+#include "retry_policy.h"
 
 // Global objects
 ConfigManager configManager;
@@ -18,11 +19,14 @@ DisplayHandler display;
 WebConfigServer webServer(&configManager);
 GitHubImageFetcher imageFetcher(&configManager);
 BatteryMonitor batteryMonitor;
+RetryPolicy retryPolicy;
 
 // State variables
 bool isConfigMode = false;
 unsigned long lastUpdateTime = 0;
 unsigned long lastWiFiCheck = 0;
+unsigned long retryDelayMs = 0;
+unsigned long wifiStartMs = 0;
 bool firstRun = true;
 
 // Function declarations
@@ -32,9 +36,14 @@ bool connectToWiFi();
 void enterConfigMode();
 void exitConfigMode();
 void updateDashboard();
+void showFetchedFrame();
+void completeUpdate();
+void sleepIfUnchanged();
+bool showBundleFrame();
 void checkWiFiConnection();
 void printSystemInfo();
 void enterDeepSleep();
+unsigned long radioOnMs();
 bool isActiveHours();
 void setupTimeSync();
 
@@ -77,6 +86,11 @@ void setup() {
         Serial.println("Battery monitor initialized successfully!");
     }
     
+#if FRAME_DIGEST_BENCHMARK
+    // SHA-256 engine against software over 1 MB
+    FrameDigest::benchmark(1024 * 1024);
+#endif
+    
     // Check if device is configured
     if (!configManager.isConfigured()) {
         Serial.println("No saved configuration found");
@@ -99,7 +113,16 @@ void setup() {
         configManager.printConfig();
     }
     
+#if FETCH_FRAME_BUNDLE
+    // A frame of the bundle in flash is due: show it and go back to sleep
+    // without starting WiFi
+    if (showBundleFrame()) {
+        enterDeepSleep();
+    }
+#endif
+    
     // At this point we have configuration (either saved or default)
+    retryPolicy.logState();
     Serial.println("Configuration available - attempting to connect to WiFi");
     
     if (connectToWiFi()) {
@@ -110,6 +133,12 @@ void setup() {
         
         // Don't display anything - wait for image fetch
         lastUpdateTime = 0; // Force immediate update
+    } else if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER) {
+        // The network worked before this sleep: back off like for a server
+        // outage instead of keeping the access point up
+        Serial.println("Failed to connect to WiFi - backing off");
+        retryPolicy.recordFailure(radioOnMs());
+        enterDeepSleep();
     } else {
         Serial.println("Failed to connect to WiFi - entering configuration mode");
         // Only show display for configuration mode
@@ -132,12 +161,20 @@ void loop() {
         
         // Check if it's time to update the dashboard
         unsigned long currentTime = millis();
-        if (firstRun || (currentTime - lastUpdateTime >= UPDATE_INTERVAL_MS)) {
+        if (firstRun || (currentTime - lastUpdateTime >= retryDelayMs)) {
             updateDashboard();
-            // updateDashboard() will call enterDeepSleep(), so we shouldn't reach this point
-            // If we do reach here, something went wrong - wait and try again
-            lastUpdateTime = currentTime;
+            // updateDashboard() enters deep sleep after an update or when the
+            // frame on screen is current, so reaching this point means it failed
+            lastUpdateTime = millis();
             firstRun = false;
+            
+            retryDelayMs = retryPolicy.nextRetryDelayMs();
+            if (retryDelayMs == 0) {
+                // Out of retries for this wake: wait in deep sleep, not with WiFi up
+                retryPolicy.recordFailure(radioOnMs());
+                enterDeepSleep();
+            }
+            imageFetcher.resetConnection();
         }
         
         // Update battery monitor
@@ -159,6 +196,9 @@ bool connectToWiFi() {
     
     Serial.printf("Connecting to WiFi: %s\n", ssid);
     
+    if (wifiStartMs == 0) {
+        wifiStartMs = millis();
+    }
     WiFi.mode(WIFI_STA);
     WiFi.begin(ssid, password);
     
@@ -215,39 +255,181 @@ void updateDashboard() {
     Serial.println("Starting dashboard update...");
     
     // Don't display anything during fetch - keep display blank
-    
-    // Test GitHub connection first
-    if (!imageFetcher.testConnection()) {
-        Serial.println("GitHub connection test failed");
-        // Don't display error - just log it
-        return;
+    // No separate connection test: the first request opens the keep-alive
+    // connection that the following ones reuse, and a failed connect ends
+    // the attempts of this wake
+    
+#if FETCH_MANIFEST
+    // A few hundred bytes say whether the published frame is the one on
+    // screen and which encodings exist, before any frame request
+    imageFetcher.fetchManifest();
+    sleepIfUnchanged();
+#endif
+    
+#if FETCH_VECTOR_MAP
+    if (imageFetcher.fetchVectorMap() &&
+        display.displayVectorMap(imageFetcher.getImageBuffer(), imageFetcher.getImageSize())) {
+        completeUpdate();
+    }
+    sleepIfUnchanged();
+    Serial.println("Vector map not available - fetching raster frame");
+#endif
+    
+#if FETCH_FRAME_BUNDLE
+    // Frames of the next hours in one download; until the last one is due
+    // the following wakes show them from flash
+    if (imageFetcher.fetchFrameBundle() && showBundleFrame()) {
+        completeUpdate();
+    }
+    sleepIfUnchanged();
+    Serial.println("Frame bundle not available - fetching single frame");
+#endif
+    
+#if LOCAL_WIDGETS
+    // Usual case: only the small widget document changed since the last wake
+    if (imageFetcher.fetchWidgetFrame()) {
+        display.displayWidgetFrame(imageFetcher.getImageBuffer(), imageFetcher.getImageSize(),
+                                   imageFetcher.getWidgetData());
+        completeUpdate();
+    }
+    sleepIfUnchanged();
+    Serial.println("Widget update not available - fetching full frame");
+#endif
+    
+#if FETCH_FRAME_PATCH
+    // Only the runs that changed since the last server run, applied to the
+    // frame kept in flash; any other base means the full frame
+    if (imageFetcher.fetchPatchedFrame()) {
+        showFetchedFrame();
+        completeUpdate();
+    }
+    sleepIfUnchanged();
+    Serial.println("Frame patch not applicable - fetching full frame");
+#endif
+    
+#if FETCH_TILED_FRAME
+    // Changed tiles only, on top of whatever frame the cache holds
+    if (imageFetcher.fetchTiledFrame()) {
+        showFetchedFrame();
+        completeUpdate();
     }
+    sleepIfUnchanged();
+    Serial.println("Tiled frame not available - fetching full frame");
+#endif
+    
+#if STREAM_FRAME_TO_PANEL
+#if FETCH_COMPRESSED_FRAME
+    // Smallest download: the .binz is inflated on its way to the panel
+    display.beginFrameStream();
+    if (imageFetcher.streamCompressedImage(DisplayHandler::frameStreamSink, &display)) {
+        display.finishFrameStream();
+        completeUpdate();
+    }
+    display.abortFrameStream();
+    sleepIfUnchanged();
+    Serial.println("Compressed frame not available - streaming raw frame");
+#endif
+    
+    // Landscape frames need no buffer: the body goes to the panel as it
+    // arrives and is only shown once its length and hash check out
+    display.beginFrameStream();
+    if (imageFetcher.streamLatestImage(DisplayHandler::frameStreamSink, &display)) {
+        display.finishFrameStream();
+        completeUpdate();
+    }
+    display.abortFrameStream();
+    sleepIfUnchanged();
+    Serial.println("Streaming not available - fetching buffered frame");
+#endif
     
     // Fetch the latest image
     if (imageFetcher.fetchLatestImage()) {
         Serial.println("Image fetched successfully");
         
-        uint8_t* imageData = imageFetcher.getImageBuffer();
-        size_t imageSize = imageFetcher.getImageSize();
-        
-        Serial.printf("Displaying image (%d bytes)\n", imageSize);
         // Display the fetched image with battery overlay
-        // display.displayImageWithBatteryOverlay(imageData, imageSize, &batteryMonitor);
-        display.displayImage(imageData, imageSize);
-
-        Serial.println("Dashboard update completed successfully");
-        
-        // After successful display update, enter deep sleep
-        delay(1000);  // Allow display to complete
-        enterDeepSleep();
+        // display.displayImageWithBatteryOverlay(imageFetcher.getImageBuffer(), imageFetcher.getImageSize(), &batteryMonitor);
+        showFetchedFrame();
+        completeUpdate();
     } else {
+        sleepIfUnchanged();
+        imageFetcher.logConnectionStats();
         Serial.println("Failed to fetch image from GitHub");
+#if CACHE_LAST_FRAME
+        // After a power cycle the panel may still show the setup screen:
+        // put the last downloaded frame back from flash instead
+        if (firstRun && esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) {
+            display.beginFrameStream();
+            if (imageFetcher.streamCachedFrame(DisplayHandler::frameStreamSink, &display)) {
+                display.finishFrameStream();
+            } else {
+                display.abortFrameStream();
+            }
+        }
+#endif
         // Don't display error - just log it and keep display blank
     }
     
     Serial.println(repeat("-", 40));
 }
 
+void showFetchedFrame() {
+    // A refresh takes ~30 s of panel power and flashes the whole screen;
+    // a handful of changed pixels is not worth it
+    if (imageFetcher.isMinorChange()) {
+        Serial.println("Frame barely differs from the one on screen - refresh skipped");
+        return;
+    }
+    
+    Serial.printf("Displaying image (%u bytes)\n", (unsigned)imageFetcher.getImageSize());
+    display.displayImage(imageFetcher.getImageBuffer(), imageFetcher.getImageSize(),
+                         imageFetcher.isPortraitImage());
+}
+
+void completeUpdate() {
+    Serial.println("Dashboard update completed successfully");
+    imageFetcher.logConnectionStats();
+    
+    // The frame is on screen: send its validators with the next wake's request
+    imageFetcher.commitValidators();
+    retryPolicy.recordSuccess(radioOnMs());
+    
+    // After successful display update, enter deep sleep
+    delay(1000);  // Allow display to complete
+    enterDeepSleep();
+}
+
+void sleepIfUnchanged() {
+    if (!imageFetcher.wasNotModified()) {
+        return;
+    }
+    
+    // Nothing changed since the frame on screen: no download, no refresh
+    imageFetcher.recordNotModified();
+    retryPolicy.recordSuccess(radioOnMs());
+    imageFetcher.logConnectionStats();
+    enterDeepSleep();
+}
+
+bool showBundleFrame() {
+    int frame = imageFetcher.dueBundleFrame();
+    if (frame < 0) {
+        return false;
+    }
+    if (imageFetcher.isBundleFrameShown(frame)) {
+        // Woke before the next frame was due: nothing to refresh
+        Serial.println("Bundle frame already on screen");
+        return true;
+    }
+    
+    display.beginFrameStream();
+    if (imageFetcher.streamBundleFrame(frame, DisplayHandler::frameStreamSink, &display)) {
+        display.finishFrameStream();
+        return true;
+    }
+    display.abortFrameStream();
+    return false;
+}
+
 void checkWiFiConnection() {
     unsigned long currentTime = millis();
     
@@ -360,23 +542,54 @@ bool isActiveHours() {
     return (hour >= 7 && hour < 22);
 }
 
+unsigned long radioOnMs() {
+    return wifiStartMs > 0 ? millis() - wifiStartMs : 0;
+}
+
 void enterDeepSleep() {
     Serial.println("\n" + repeat("=", 50));
     Serial.println("PREPARING FOR DEEP SLEEP");
     
-    // Check current time and determine sleep duration
+    uint64_t sleepTimeUs = 0;
+    
+    if (retryPolicy.isBackingOff()) {
+        // The last update failed: the backoff replaces the schedule
+        sleepTimeUs = retryPolicy.getBackoffSeconds() * 1000000ULL;
+        Serial.printf("Backing off after failed update - sleeping for %u seconds\n",
+                      retryPolicy.getBackoffSeconds());
+    }
+    
+    // Fixed intervals by time of day, used when the server gives no schedule
     bool activeHours = isActiveHours();
-    unsigned long sleepTimeMs;
+    uint32_t scheduleS = activeHours ? ACTIVE_HOURS_SLEEP_MIN * 60 : INACTIVE_HOURS_SLEEP_H * 3600;
+    
+#if SERVER_DRIVEN_SLEEP
+    // Wake just after the server publishes the next frame
+    uint32_t nextUpdateS;
+    if (sleepTimeUs == 0 && imageFetcher.secondsToNextUpdate(nextUpdateS, scheduleS)) {
+        uint32_t sleepS = constrain(nextUpdateS + SERVER_UPDATE_MARGIN_S, (uint32_t)MIN_SLEEP_S, (uint32_t)MAX_SLEEP_S);
+        sleepTimeUs = sleepS * 1000000ULL;
+        Serial.printf("Server update due in %u seconds - sleeping for %u seconds\n", nextUpdateS, sleepS);
+    }
+#endif
     
-    if (activeHours) {
-        // Active hours (7:00-22:00): sleep for 30 minutes
-        sleepTimeMs = 30UL * 60UL * 1000UL * 1000UL; // 30 minutes in microseconds
-        Serial.println("Active hours detected - sleeping for 30 minutes");
-    } else {
-        // Inactive hours (22:00-7:00): sleep for 9 hours
-        sleepTimeMs = 9UL * 60UL * 60UL * 1000UL * 1000UL; // 9 hours in microseconds
-        Serial.println("Inactive hours detected - sleeping for 9 hours");
+    if (sleepTimeUs == 0) {
+        sleepTimeUs = scheduleS * 1000000ULL;
+        if (activeHours) {
+            Serial.printf("Active hours detected - sleeping for %d minutes\n", ACTIVE_HOURS_SLEEP_MIN);
+        } else {
+            Serial.printf("Inactive hours detected - sleeping for %d hours\n", INACTIVE_HOURS_SLEEP_H);
+        }
+    }
+    
+#if FETCH_FRAME_BUNDLE
+    // Wake for the next frame of the bundle if it is due sooner
+    uint32_t nextFrameS = imageFetcher.secondsToNextBundleFrame();
+    if (nextFrameS > 0 && nextFrameS * 1000000ULL < sleepTimeUs) {
+        sleepTimeUs = nextFrameS * 1000000ULL;
+        Serial.printf("Next bundle frame due - sleeping for %u seconds\n", nextFrameS);
     }
+#endif
     
     // Put display to sleep
     display.sleep();
@@ -388,7 +601,7 @@ void enterDeepSleep() {
     Serial.println("WiFi disconnected");
     
     // Print sleep information
-    Serial.printf("Sleep duration: %lu seconds\n", sleepTimeMs / 1000000);
+    Serial.printf("Sleep duration: %lu seconds\n", (unsigned long)(sleepTimeUs / 1000000));
     
     // Battery status before sleep
     if (batteryMonitor.isConnected()) {
@@ -402,7 +615,7 @@ void enterDeepSleep() {
     Serial.flush();
     
     // Configure ESP32-S2 for deep sleep with timer wakeup
-    esp_sleep_enable_timer_wakeup(sleepTimeMs);
+    esp_sleep_enable_timer_wakeup(sleepTimeUs);
     
     // Enter deep sleep
     esp_deep_sleep_start();
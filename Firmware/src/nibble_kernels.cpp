@@ -0,0 +1,186 @@
+#include "nibble_kernels.h"
+#include <string.h>
+
+// Word loads/stores on 4-byte aligned addresses. Going through memcpy keeps
+// the accesses alias-safe; with the alignment hint GCC emits single l32i/s32i.
+static inline uint32_t loadWord(const uint8_t* p) {
+    uint32_t word;
+    memcpy(&word, __builtin_assume_aligned(p, 4), sizeof(word));
+    return word;
+}
+
+static inline void storeWord(uint8_t* p, uint32_t word) {
+    memcpy(__builtin_assume_aligned(p, 4), &word, sizeof(word));
+}
+
+static inline bool isWordAligned(const void* p) {
+    return ((uintptr_t)p & 3) == 0;
+}
+
+// Single-byte variant of opaqueMask for unaligned heads and tails
+static inline uint8_t opaqueMaskByte(uint8_t value, uint8_t keyByte) {
+    uint8_t diff = value ^ keyByte;
+    diff |= diff >> 2;
+    diff |= diff >> 1;
+    return (diff & 0x11) * 0xF;
+}
+
+uint32_t NibbleKernels::pixelMask(uint8_t pixels) {
+    static uint32_t maskTable[256];
+    static bool tableReady = false;
+
+    if (!tableReady) {
+        for (int bits = 0; bits < 256; bits++) {
+            uint32_t mask = 0;
+            for (int pixel = 0; pixel < 8; pixel++) {
+                if (bits & (1 << pixel)) {
+                    // Even pixels sit in the upper nibble of their byte
+                    int shift = (pixel / 2) * 8 + ((pixel % 2 == 0) ? 4 : 0);
+                    mask |= 0xFu << shift;
+                }
+            }
+            maskTable[bits] = mask;
+        }
+        tableReady = true;
+    }
+
+    return maskTable[pixels];
+}
+
+void NibbleKernels::fillSpan(uint8_t* row, int x0, int x1, uint8_t color) {
+    if (x0 >= x1) return;
+
+    color &= 0x0F;
+
+    // Odd leading pixel lives in the lower nibble of its byte
+    if (x0 & 1) {
+        row[x0 / 2] = (row[x0 / 2] & 0xF0) | color;
+        x0++;
+    }
+
+    // Even trailing pixel lives in the upper nibble of its byte
+    if (x1 & 1) {
+        row[x1 / 2] = (row[x1 / 2] & 0x0F) | (color << 4);
+        x1--;
+    }
+
+    uint8_t* p = row + x0 / 2;
+    uint8_t* end = row + x1 / 2;
+    uint8_t packed = (color << 4) | color;
+
+    while (p < end && !isWordAligned(p)) {
+        *p++ = packed;
+    }
+
+    uint32_t word = replicate(color);
+    while (end - p >= 4) {
+        storeWord(p, word);
+        p += 4;
+    }
+
+    while (p < end) {
+        *p++ = packed;
+    }
+}
+
+void NibbleKernels::copySpan(uint8_t* dst, const uint8_t* src, int x0, int x1) {
+    if (x0 >= x1) return;
+
+    if (x0 & 1) {
+        dst[x0 / 2] = (dst[x0 / 2] & 0xF0) | (src[x0 / 2] & 0x0F);
+        x0++;
+    }
+
+    if (x1 & 1) {
+        dst[x1 / 2] = (dst[x1 / 2] & 0x0F) | (src[x1 / 2] & 0xF0);
+        x1--;
+    }
+
+    uint8_t* d = dst + x0 / 2;
+    const uint8_t* s = src + x0 / 2;
+    size_t bytes = (x1 - x0) / 2;
+
+    if (((uintptr_t)d ^ (uintptr_t)s) & 3) {
+        // Different word phase: let memcpy pick its own strategy
+        memcpy(d, s, bytes);
+        return;
+    }
+
+    while (bytes > 0 && !isWordAligned(d)) {
+        *d++ = *s++;
+        bytes--;
+    }
+
+    while (bytes >= 4) {
+        storeWord(d, loadWord(s));
+        d += 4;
+        s += 4;
+        bytes -= 4;
+    }
+
+    while (bytes > 0) {
+        *d++ = *s++;
+        bytes--;
+    }
+}
+
+void NibbleKernels::blendWords(uint32_t* dst, const uint32_t* src, const uint8_t* pixelMasks, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        uint8_t pixels = pixelMasks[i];
+        if (pixels == 0) continue;
+
+        dst[i] = (pixels == 0xFF) ? src[i] : blend(dst[i], src[i], pixelMask(pixels));
+    }
+}
+
+void NibbleKernels::compositeKeyed(uint8_t* dst, const uint8_t* src, size_t bytes, uint8_t keyColor) {
+    uint8_t keyByte = (keyColor << 4) | (keyColor & 0x0F);
+    size_t i = 0;
+
+    // Word path only when both pointers share the same alignment phase
+    if (!(((uintptr_t)dst ^ (uintptr_t)src) & 3)) {
+        while (i < bytes && !isWordAligned(dst + i)) {
+            uint8_t mask = opaqueMaskByte(src[i], keyByte);
+            dst[i] = (dst[i] & ~mask) | (src[i] & mask);
+            i++;
+        }
+
+        uint32_t keyWord = replicate(keyColor);
+        for (; i + 4 <= bytes; i += 4) {
+            uint32_t word = loadWord(src + i);
+            uint32_t mask = opaqueMask(word, keyWord);
+
+            if (mask == 0) continue;  // Fully transparent: 8 pixels skipped at once
+            storeWord(dst + i, (mask == 0xFFFFFFFFu) ? word : blend(loadWord(dst + i), word, mask));
+        }
+    }
+
+    for (; i < bytes; i++) {
+        uint8_t mask = opaqueMaskByte(src[i], keyByte);
+        dst[i] = (dst[i] & ~mask) | (src[i] & mask);
+    }
+}
+
+void NibbleKernels::compositeSpan(uint8_t* dst, const uint8_t* src, int x0, int x1, uint8_t keyColor) {
+    if (x0 >= x1) return;
+
+    keyColor &= 0x0F;
+
+    // Odd leading pixel: lower nibble only
+    if (x0 & 1) {
+        uint8_t pixel = src[x0 / 2] & 0x0F;
+        if (pixel != keyColor) dst[x0 / 2] = (dst[x0 / 2] & 0xF0) | pixel;
+        x0++;
+    }
+
+    // Even trailing pixel: upper nibble only
+    if (x1 & 1) {
+        uint8_t pixel = src[x1 / 2] >> 4;
+        if (pixel != keyColor) dst[x1 / 2] = (dst[x1 / 2] & 0x0F) | (pixel << 4);
+        x1--;
+    }
+
+    if (x0 < x1) {
+        compositeKeyed(dst + x0 / 2, src + x0 / 2, (x1 - x0) / 2, keyColor);
+    }
+}
@@ -0,0 +1,361 @@
+#include "png_decoder.h"
+#include "epd_colors.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+#define PNG_CHUNK(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+static const uint32_t CHUNK_IHDR = PNG_CHUNK('I', 'H', 'D', 'R');
+static const uint32_t CHUNK_PLTE = PNG_CHUNK('P', 'L', 'T', 'E');
+static const uint32_t CHUNK_IDAT = PNG_CHUNK('I', 'D', 'A', 'T');
+static const uint32_t CHUNK_IEND = PNG_CHUNK('I', 'E', 'N', 'D');
+
+static const int PNG_MAX_WIDTH = 2048;
+
+// Panel palette, must match PALETTE in Server/utils/png_to_epaper_converter.py
+static const uint8_t PANEL_PALETTE[8][3] = {
+    {   0,   0,   0 },   // Black
+    { 255, 255, 255 },   // White
+    {  67, 138,  28 },   // Green
+    { 100,  64, 255 },   // Blue
+    { 191,   0,   0 },   // Red
+    { 255, 243,  56 },   // Yellow
+    { 232, 126,   0 },   // Orange
+    { 194, 164, 244 }    // Afterimage
+};
+
+// CRC-32 (PNG/zlib polynomial), 4 bits at a time to keep the table small
+static const uint32_t CRC_TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t length) {
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+static inline uint32_t readBigEndian(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint8_t nearestPanelColor(uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t best = EPD_7IN3F_BLACK;
+    int bestDistance = 0x7FFFFFFF;
+
+    for (int i = 0; i < 8; i++) {
+        int dr = r - PANEL_PALETTE[i][0];
+        int dg = g - PANEL_PALETTE[i][1];
+        int db = b - PANEL_PALETTE[i][2];
+        int distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+static inline uint8_t paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+// Undo the PNG filter of one row in place; previous is the unfiltered row above
+static bool unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* previous, size_t length, size_t bpp) {
+    switch (filter) {
+        case 0:  // None
+            break;
+        case 1:  // Sub
+            for (size_t i = bpp; i < length; i++) row[i] += row[i - bpp];
+            break;
+        case 2:  // Up
+            for (size_t i = 0; i < length; i++) row[i] += previous[i];
+            break;
+        case 3:  // Average
+            for (size_t i = 0; i < bpp; i++) row[i] += previous[i] >> 1;
+            for (size_t i = bpp; i < length; i++) row[i] += (row[i - bpp] + previous[i]) >> 1;
+            break;
+        case 4:  // Paeth
+            for (size_t i = 0; i < bpp; i++) row[i] += previous[i];
+            for (size_t i = bpp; i < length; i++) {
+                row[i] += paethPredictor(row[i - bpp], previous[i], previous[i - bpp]);
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+PngStreamDecoder::PngStreamDecoder() :
+    input(nullptr), inputContext(nullptr), width(0), height(0), bitDepth(0), colorType(0),
+    identityPalette(false), error(nullptr),
+    chunkRemaining(0), chunkCrc(0), chunkType(0), chunkError(false) {
+    memset(paletteMap, EPD_7IN3F_BLACK, sizeof(paletteMap));
+}
+
+PngStreamDecoder::~PngStreamDecoder() {
+}
+
+bool PngStreamDecoder::fail(const char* message) {
+    if (!error) error = message;
+    return false;
+}
+
+bool PngStreamDecoder::readExact(uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        size_t received = input(inputContext, buffer, length);
+        if (received == 0) return fail("unexpected end of PNG file");
+        buffer += received;
+        length -= received;
+    }
+    return true;
+}
+
+bool PngStreamDecoder::readChunkHeader(uint32_t& length, uint32_t& type) {
+    uint8_t header[8];
+    if (!readExact(header, sizeof(header))) return false;
+
+    length = readBigEndian(header);
+    type = readBigEndian(header + 4);
+    chunkType = type;
+    chunkCrc = updateCrc(0xFFFFFFFF, header + 4, 4);
+
+    if (length > 0x7FFFFFFF) return fail("invalid chunk length");
+    return true;
+}
+
+bool PngStreamDecoder::readChunkData(uint8_t* buffer, uint32_t length) {
+    if (!readExact(buffer, length)) return false;
+    chunkCrc = updateCrc(chunkCrc, buffer, length);
+    return true;
+}
+
+bool PngStreamDecoder::finishChunk() {
+    uint8_t crc[4];
+    if (!readExact(crc, sizeof(crc))) return false;
+    if (readBigEndian(crc) != (chunkCrc ^ 0xFFFFFFFF)) return fail("chunk CRC mismatch");
+    return true;
+}
+
+bool PngStreamDecoder::skipChunk(uint32_t length) {
+    uint8_t scratch[64];
+    while (length > 0) {
+        uint32_t piece = length < sizeof(scratch) ? length : sizeof(scratch);
+        if (!readChunkData(scratch, piece)) return false;
+        length -= piece;
+    }
+    return finishChunk();
+}
+
+bool PngStreamDecoder::readHeader(uint32_t length) {
+    uint8_t header[13];
+    if (length != sizeof(header)) return fail("invalid IHDR length");
+    if (!readChunkData(header, sizeof(header)) || !finishChunk()) return false;
+
+    width = readBigEndian(header);
+    height = readBigEndian(header + 4);
+    bitDepth = header[8];
+    colorType = header[9];
+
+    if (width <= 0 || height <= 0 || width > PNG_MAX_WIDTH) return fail("unsupported image size");
+    if (header[10] != 0 || header[11] != 0) return fail("unknown compression or filter method");
+    if (header[12] != 0) return fail("interlaced images not supported");
+
+    bool indexed = colorType == 3 && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8);
+    bool truecolor = (colorType == 2 || colorType == 6) && bitDepth == 8;
+    if (!indexed && !truecolor) return fail("unsupported color type or bit depth");
+
+    return true;
+}
+
+bool PngStreamDecoder::readPalette(uint32_t length) {
+    if (length % 3 != 0 || length > 256 * 3) return fail("invalid PLTE length");
+
+    int entries = length / 3;
+    identityPalette = bitDepth == 4;
+    for (int i = 0; i < entries; i++) {
+        uint8_t rgb[3];
+        if (!readChunkData(rgb, sizeof(rgb))) return false;
+        paletteMap[i] = nearestPanelColor(rgb[0], rgb[1], rgb[2]);
+        if (paletteMap[i] != i) identityPalette = false;
+    }
+    return finishChunk();
+}
+
+void PngStreamDecoder::packRow(const uint8_t* raw, uint8_t* packed) const {
+    size_t packedBytes = (width + 1) / 2;
+
+    if (colorType == 3) {
+        if (identityPalette) {
+            // 4-bit indices in panel order are already the panel format
+            memcpy(packed, raw, packedBytes);
+            return;
+        }
+
+        int pixelsPerByte = 8 / bitDepth;
+        uint8_t mask = (1 << bitDepth) - 1;
+        for (int x = 0; x < width; x++) {
+            int shift = 8 - bitDepth * (x % pixelsPerByte + 1);
+            uint8_t color = paletteMap[(raw[x / pixelsPerByte] >> shift) & mask];
+            if (x & 1) {
+                packed[x / 2] |= color;
+            } else {
+                packed[x / 2] = color << 4;
+            }
+        }
+        return;
+    }
+
+    // Truecolor: images are flat areas of palette colors, so remember the
+    // last match and only search the palette when the color changes
+    int channels = (colorType == 6) ? 4 : 3;
+    uint32_t lastRgb = 0xFFFFFFFF;
+    uint8_t lastColor = EPD_7IN3F_BLACK;
+    for (int x = 0; x < width; x++) {
+        const uint8_t* pixel = raw + x * channels;
+        uint32_t rgb = ((uint32_t)pixel[0] << 16) | ((uint32_t)pixel[1] << 8) | pixel[2];
+        if (rgb != lastRgb) {
+            lastRgb = rgb;
+            lastColor = nearestPanelColor(pixel[0], pixel[1], pixel[2]);
+        }
+        if (x & 1) {
+            packed[x / 2] |= lastColor;
+        } else {
+            packed[x / 2] = lastColor << 4;
+        }
+    }
+}
+
+size_t PngStreamDecoder::readImageData(void* context, uint8_t* buffer, size_t length) {
+    PngStreamDecoder* decoder = (PngStreamDecoder*)context;
+
+    while (decoder->chunkRemaining == 0) {
+        if (decoder->chunkType != CHUNK_IDAT || decoder->chunkError) return 0;
+
+        // Current IDAT is done: check it and move on if the next one follows
+        uint32_t length, type;
+        if (!decoder->finishChunk() || !decoder->readChunkHeader(length, type)) {
+            decoder->chunkError = true;
+            return 0;
+        }
+        decoder->chunkRemaining = length;
+    }
+
+    size_t piece = length < decoder->chunkRemaining ? length : decoder->chunkRemaining;
+    if (!decoder->readChunkData(buffer, piece)) {
+        decoder->chunkError = true;
+        return 0;
+    }
+    decoder->chunkRemaining -= piece;
+    return piece;
+}
+
+bool PngStreamDecoder::decodeRows(PngRowSink sink, void* sinkContext) {
+    int channels = (colorType == 3) ? 1 : (colorType == 6) ? 4 : 3;
+    size_t rowBytes = ((size_t)width * channels * bitDepth + 7) / 8;
+    size_t bpp = (channels * bitDepth + 7) / 8;
+    size_t packedBytes = (width + 1) / 2;
+
+    // Filter byte + current row, previous row, packed output row
+    uint8_t* buffers = (uint8_t*)malloc(1 + rowBytes * 2 + packedBytes);
+    if (!buffers) return fail("out of memory for rows");
+
+    uint8_t* current = buffers;
+    uint8_t* previous = buffers + 1 + rowBytes;
+    uint8_t* packed = previous + rowBytes;
+    memset(previous, 0, rowBytes);
+
+    if (!inflater.begin(InflateStream::FORMAT_ZLIB, readImageData, this)) {
+        free(buffers);
+        return fail("out of memory for inflate window");
+    }
+
+    bool ok = true;
+    for (int row = 0; row < height && ok; row++) {
+        size_t filled = 0;
+        while (filled < rowBytes + 1) {
+            size_t produced = inflater.read(current + filled, rowBytes + 1 - filled);
+            if (produced == 0) break;
+            filled += produced;
+        }
+
+        if (filled < rowBytes + 1) {
+            ok = fail(inflater.hasError() ? inflater.getError() : "image data ended early");
+        } else if (!unfilterRow(current[0], current + 1, previous, rowBytes, bpp)) {
+            ok = fail("invalid filter type");
+        } else {
+            packRow(current + 1, packed);
+            if (!sink(sinkContext, row, packed, packedBytes)) {
+                ok = fail("aborted by row sink");
+            }
+            // The unfiltered row becomes the previous row of the next one
+            memcpy(previous, current + 1, rowBytes);
+        }
+    }
+
+    if (ok) {
+        // Drive the inflater to the end so the Adler-32 trailer is checked
+        uint8_t extra;
+        if (inflater.read(&extra, 1) != 0) {
+            ok = fail("extra image data after last row");
+        } else if (!inflater.isFinished()) {
+            ok = fail(inflater.hasError() ? inflater.getError() : "image data ended early");
+        }
+    }
+
+    inflater.end();
+    free(buffers);
+    return ok;
+}
+
+bool PngStreamDecoder::decode(StreamInput source, void* context, PngRowSink sink, void* sinkContext) {
+    input = source;
+    inputContext = context;
+    width = 0;
+    height = 0;
+    identityPalette = false;
+    error = nullptr;
+    chunkRemaining = 0;
+    chunkType = 0;
+    chunkError = false;
+    memset(paletteMap, EPD_7IN3F_BLACK, sizeof(paletteMap));
+
+    uint8_t signature[8];
+    if (!readExact(signature, sizeof(signature))) return false;
+    if (memcmp(signature, PNG_SIGNATURE, sizeof(signature)) != 0) return fail("not a PNG file");
+
+    uint32_t length, type;
+    if (!readChunkHeader(length, type)) return false;
+    if (type != CHUNK_IHDR) return fail("missing IHDR");
+    if (!readHeader(length)) return false;
+
+    bool havePalette = false;
+    while (true) {
+        if (!readChunkHeader(length, type)) return false;
+
+        if (type == CHUNK_IDAT) {
+            if (colorType == 3 && !havePalette) return fail("missing PLTE");
+            chunkRemaining = length;
+            return decodeRows(sink, sinkContext);
+        } else if (type == CHUNK_PLTE) {
+            if (!readPalette(length)) return false;
+            havePalette = true;
+        } else if (type == CHUNK_IEND) {
+            return fail("no image data");
+        } else if (!skipChunk(length)) {
+            return false;
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include "qr_code.h"
+#include "framebuffer.h"
+#include <stdio.h>
 #include <string.h>
 
 QRCode::QRCode() {
@@ -109,49 +111,31 @@ void QRCode::addQuietZone(uint8_t* data, int size) {
 
 void QRCode::convertToEPaperFormat(const uint8_t* qrData, int qrSize, 
                                   uint8_t* epaperData, int centerX, int centerY, int scale) {
+    Framebuffer fb(epaperData);
+    int originX = centerX - (qrSize * scale) / 2;
+    int originY = centerY - (qrSize * scale) / 2;
+    
     // Clear the e-paper data area first
-    for (int y = centerY - (qrSize * scale) / 2; y < centerY + (qrSize * scale) / 2; y++) {
-        for (int x = centerX - (qrSize * scale) / 2; x < centerX + (qrSize * scale) / 2; x++) {
-            if (x >= 0 && x < 800 && y >= 0 && y < 480) {
-                // Calculate position in e-paper buffer (2 pixels per byte)
-                int bufferIndex = (y * 400) + (x / 2);  // 800 pixels / 2 = 400 bytes per row
-                
-                if (x % 2 == 0) {
-                    // Left pixel (upper 4 bits)
-                    epaperData[bufferIndex] = (epaperData[bufferIndex] & 0x0F) | (0x10);  // White
-                } else {
-                    // Right pixel (lower 4 bits)
-                    epaperData[bufferIndex] = (epaperData[bufferIndex] & 0xF0) | 0x01;   // White
-                }
-            }
-        }
-    }
+    fb.fillRect(originX, originY, (qrSize * scale) / 2 * 2, (qrSize * scale) / 2 * 2, EPD_7IN3F_WHITE);
     
-    // Draw the QR code
+    // Draw the QR code, one scaled block per horizontal run of black modules
     for (int qrY = 0; qrY < qrSize; qrY++) {
-        for (int qrX = 0; qrX < qrSize; qrX++) {
-            if (qrData[qrY * qrSize + qrX] == 1) {  // Black module
-                // Scale up the QR code
-                for (int sy = 0; sy < scale; sy++) {
-                    for (int sx = 0; sx < scale; sx++) {
-                        int displayX = centerX - (qrSize * scale) / 2 + qrX * scale + sx;
-                        int displayY = centerY - (qrSize * scale) / 2 + qrY * scale + sy;
-                        
-                        if (displayX >= 0 && displayX < 800 && displayY >= 0 && displayY < 480) {
-                            // Calculate position in e-paper buffer
-                            int bufferIndex = (displayY * 400) + (displayX / 2);
-                            
-                            if (displayX % 2 == 0) {
-                                // Left pixel (upper 4 bits)
-                                epaperData[bufferIndex] = (epaperData[bufferIndex] & 0x0F) | (0x00);  // Black
-                            } else {
-                                // Right pixel (lower 4 bits)
-                                epaperData[bufferIndex] = (epaperData[bufferIndex] & 0xF0) | 0x00;   // Black
-                            }
-                        }
-                    }
-                }
+        const uint8_t* qrRow = qrData + qrY * qrSize;
+        int qrX = 0;
+        
+        while (qrX < qrSize) {
+            if (qrRow[qrX] != 1) {  // White module
+                qrX++;
+                continue;
             }
+            
+            int runStart = qrX;
+            while (qrX < qrSize && qrRow[qrX] == 1) {
+                qrX++;
+            }
+            
+            fb.fillRect(originX + runStart * scale, originY + qrY * scale,
+                        (qrX - runStart) * scale, scale, EPD_7IN3F_BLACK);
         }
     }
 }
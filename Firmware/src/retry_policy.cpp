@@ -0,0 +1,92 @@
+#include "retry_policy.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <esp_system.h>
+
+#define RETRY_STATE_MAGIC 0x59525452   // "RTRY"
+
+// Failure episode in progress. RTC slow memory survives deep sleep; a power
+// cycle starts without backoff.
+struct RetryState {
+    uint32_t magic;
+    uint16_t failedWakes;       // Consecutive wakes without an update
+    uint16_t failedAttempts;    // Attempts over those wakes, retries included
+    uint32_t radioMs;           // WiFi-on time of the episode
+    uint32_t backoffS;          // Sleep after the last failed wake, 0 when none
+};
+
+RTC_DATA_ATTR static RetryState retryState;
+static_assert(sizeof(RetryState) <= RTC_RETRY_STATE_BYTES, "RetryState exceeds RTC_RETRY_STATE_BYTES");
+
+static void ensureState() {
+    if (retryState.magic != RETRY_STATE_MAGIC) {
+        memset(&retryState, 0, sizeof(retryState));
+        retryState.magic = RETRY_STATE_MAGIC;
+    }
+}
+
+// value scaled by a random factor in [1 - spread, 1 + spread), spread in percent
+static uint32_t jitter(uint32_t value, uint32_t spread) {
+    uint32_t range = value * spread / 100;
+    if (range == 0) return value;
+    return value - range + esp_random() % (2 * range);
+}
+
+RetryPolicy::RetryPolicy() : attempts(0) {
+}
+
+uint32_t RetryPolicy::nextRetryDelayMs() {
+    ensureState();
+    retryState.failedAttempts++;
+    if (attempts >= RETRY_IN_WAKE) {
+        return 0;
+    }
+
+    // Spread out so devices behind the same outage do not retry in step
+    uint32_t delayMs = jitter((uint32_t)RETRY_DELAY_MS << attempts, 50);
+    attempts++;
+    Serial.printf("Update failed - retry %d/%d in %u ms\n", attempts, RETRY_IN_WAKE, delayMs);
+    return delayMs;
+}
+
+void RetryPolicy::recordFailure(unsigned long radioMs) {
+    ensureState();
+    retryState.failedWakes++;
+    retryState.radioMs += radioMs;
+
+    uint32_t backoffS = RETRY_BACKOFF_MAX_S;
+    if (retryState.failedWakes <= 16) {
+        uint32_t doubled = (uint32_t)RETRY_BACKOFF_MIN_S << (retryState.failedWakes - 1);
+        if (doubled < backoffS) backoffS = doubled;
+    }
+    retryState.backoffS = jitter(backoffS, 10);
+    logState();
+}
+
+void RetryPolicy::recordSuccess(unsigned long radioMs) {
+    ensureState();
+    if (retryState.failedWakes > 0) {
+        Serial.printf("Retry: update after %u failed wake(s), %u attempts, %.1f s radio-on in the episode\n",
+                      retryState.failedWakes, retryState.failedAttempts,
+                      (retryState.radioMs + radioMs) / 1000.0f);
+    }
+    memset(&retryState, 0, sizeof(retryState));
+    retryState.magic = RETRY_STATE_MAGIC;
+}
+
+bool RetryPolicy::isBackingOff() const {
+    return retryState.magic == RETRY_STATE_MAGIC && retryState.backoffS > 0;
+}
+
+uint32_t RetryPolicy::getBackoffSeconds() const {
+    return isBackingOff() ? retryState.backoffS : 0;
+}
+
+void RetryPolicy::logState() const {
+    if (!isBackingOff()) {
+        Serial.println("Retry: no failure episode");
+        return;
+    }
+    Serial.printf("Retry: %u failed wake(s), %u attempts, %.1f s radio-on, backoff %u s (cap %u s)\n",
+                  retryState.failedWakes, retryState.failedAttempts, retryState.radioMs / 1000.0f,
+                  retryState.backoffS, (uint32_t)RETRY_BACKOFF_MAX_S);
+}
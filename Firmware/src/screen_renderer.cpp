@@ -0,0 +1,311 @@
+#include "screen_renderer.h"
+#include "qr_code.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Overlays and icons are drawn into small sprites cleared to this color and
+// composited onto the frame; no screen draws with it, so it is transparent
+#define SPRITE_KEY_COLOR EPD_7IN3F_CLEAN
+
+// Battery badge sprite: the badge plus the percentage text, which is wider
+#define BATTERY_SPRITE_WIDTH  64
+#define BATTERY_SPRITE_HEIGHT 90
+// Weather icon sprite: 48 pixel icon, 8 pixel margin, 8 pixel alignment slack
+#define ICON_SPRITE_WIDTH     72
+#define ICON_SPRITE_HEIGHT    64
+#define ICON_SPRITE_MARGIN    8
+
+// Battery outline, 10x18 (terminal on top), bit i of a byte is pixel i
+static const uint8_t batteryOutline[18][2] = {
+    {0x78, 0x00}, {0x78, 0x00}, {0x78, 0x00},
+    {0xFF, 0x03},
+    {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02},
+    {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02}, {0x01, 0x02},
+    {0xFF, 0x03},
+};
+
+void ScreenRenderer::renderConfigurationQR(Framebuffer& fb) {
+    // Clear buffer with white background
+    fb.clear(EPD_7IN3F_WHITE);
+    
+    // Generate QR code for WiFi connection
+    const int qrSize = 41;  // 41x41 QR code
+    uint8_t* qrData = (uint8_t*)malloc(qrSize * qrSize);
+    
+    if (qrData) {
+        // Generate WiFi QR code
+        QRCode::generateWiFiQR(AP_SSID, AP_PASSWORD, qrData, qrSize);
+        
+        // Convert and draw QR code on display (centered, scaled 8x)
+        QRCode::convertToEPaperFormat(qrData, qrSize, fb.getBuffer(), 
+                                     DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 50, 8);
+        
+        free(qrData);
+    }
+    
+    // Add text instructions around the QR code
+    fb.drawText("Smart Dashboard Setup", 200, 50, 2);
+    fb.drawText("1. Scan QR code to connect to WiFi", 150, 380, 1);
+    fb.drawText("2. Open browser to 192.168.4.1", 180, 410, 1);
+    fb.drawText("3. Configure your settings", 220, 440, 1);
+}
+
+void ScreenRenderer::renderSimpleMessage(Framebuffer& fb, const char* message) {
+    // Clear buffer with white background
+    fb.clear(EPD_7IN3F_WHITE);
+    
+    // Calculate text position to center it
+    int textWidth = Framebuffer::textWidth(message, 2);  // scale 2
+    int x = (fb.getWidth() - textWidth) / 2;
+    int y = fb.getHeight() / 2 - 7;  // 7 pixels high text
+    
+    // Draw the message
+    fb.drawText(message, x, y, 2);
+}
+
+void ScreenRenderer::renderColorTest(Framebuffer& fb) {
+    // Same eight horizontal bands EPD7in3f::showColorBlocks() streams to the panel
+    static const uint8_t bands[8] = {
+        EPD_7IN3F_BLACK, EPD_7IN3F_WHITE, EPD_7IN3F_GREEN, EPD_7IN3F_BLUE,
+        EPD_7IN3F_RED, EPD_7IN3F_YELLOW, EPD_7IN3F_ORANGE, EPD_7IN3F_CLEAN
+    };
+    
+    int bandHeight = fb.getHeight() / 8;
+    for (int y = 0; y < fb.getHeight(); y++) {
+        int band = y / bandHeight;
+        if (band > 7) band = 7;
+        memset(fb.getBuffer() + (size_t)y * fb.getStride(), (bands[band] << 4) | bands[band], fb.getStride());
+    }
+}
+
+void ScreenRenderer::renderBatteryOverlay(Framebuffer& fb, int percentage) {
+    // Battery overlay specifications (accounting for 90° rotation to the other side):
+    // - 75x25px white-filled rounded rectangle with black border
+    // - 10px from what appears as "top" edge when rotated, horizontally centered
+    // - Contains battery percentage text and battery icon
+    // 
+    // Since display is rotated 90° the other way, what appears as "top" is actually the right side
+    // Display coordinates: 800x480, but rotated means:
+    // - Visual "width" = 480 pixels (DISPLAY_HEIGHT)  
+    // - Visual "height" = 800 pixels (DISPLAY_WIDTH)
+    // - Visual "top" = right side of actual display buffer
+    
+    // Cap percentage to 100%
+    if (percentage > 100) percentage = 100;
+    if (percentage < 0) percentage = 0;
+    
+    const int overlayWidth = 90;   // Increased size for bigger elements
+    const int overlayHeight = 30;  // Increased height
+    
+    // Position for rotated display - 10px from visual top (right side), centered horizontally
+    int overlayX = DISPLAY_WIDTH - overlayHeight - 10;  // 10px from right edge (visual top)
+    int overlayY = (DISPLAY_HEIGHT - overlayWidth) / 2;  // Centered in visual width (height dimension)
+    
+    // The badge is drawn into a sprite whose left edge is 8-pixel aligned on
+    // the frame, with room for text wider than the badge, then composited
+    alignas(4) static uint8_t spritePixels[BATTERY_SPRITE_WIDTH / 2 * BATTERY_SPRITE_HEIGHT];
+    Framebuffer sprite(spritePixels, BATTERY_SPRITE_WIDTH, BATTERY_SPRITE_HEIGHT);
+    sprite.clear(SPRITE_KEY_COLOR);
+    int spriteX = (overlayX - 16) & ~7;
+    int badgeX = overlayX - spriteX;
+    
+    // Since we're rotating, swap width/height for the actual rectangle
+    sprite.drawRoundedRect(badgeX, 0, overlayHeight, overlayWidth, 8, EPD_7IN3F_WHITE, EPD_7IN3F_BLACK);
+    
+    // Draw battery percentage text (positioned for rotation, centered in the rectangle)
+    char percentText[5];
+    snprintf(percentText, sizeof(percentText), "%d%%", percentage);
+    
+    // Calculate text positioning to center it in the rectangle
+    int textWidth = Framebuffer::textWidth(percentText, 2);  // Scale 2 for bigger text
+    int textX = badgeX + (overlayHeight - textWidth) / 2;  // Center in rectangle width (which is overlayHeight)
+    sprite.drawText(percentText, textX, 8, 2);  // Small margin from top
+    
+    // Draw battery icon (positioned for rotation, bigger size)
+    int iconX = badgeX + (overlayHeight - 10) / 2;  // Center the icon horizontally
+    drawBatteryIcon(sprite, iconX, overlayWidth - 25, percentage);  // Near bottom of overlay
+    
+    fb.composite(sprite, spriteX, overlayY, SPRITE_KEY_COLOR);
+}
+
+void ScreenRenderer::drawBatteryIcon(Framebuffer& fb, int x, int y, int percentage) {
+    // Battery icon oriented for 90° rotated display
+    // Bigger vertical battery icon: 10x18 pixels (scaled up from 6x12)
+    // Battery body: 10x15 pixels + terminal: 4x3 pixels at top
+    
+    // Ensure percentage is within bounds
+    if (percentage > 100) percentage = 100;
+    if (percentage < 0) percentage = 0;
+    
+    uint8_t batteryColor = EPD_7IN3F_BLACK;
+    uint8_t fillColor = EPD_7IN3F_GREEN;
+    
+    if (percentage < 20) {
+        fillColor = EPD_7IN3F_RED;
+    } else if (percentage < 50) {
+        fillColor = EPD_7IN3F_ORANGE;
+    }
+    
+    // Terminal (4x3, positive end at top) and 10x15 body outline below it
+    fb.drawMask(x, y, 10, 18, &batteryOutline[0][0], batteryColor);
+    
+    // Draw battery fill level (from bottom up) - bigger fill area
+    int fillHeight = ((percentage * 13) / 100);  // 13 pixels max fill height (15 - 2 for borders)
+    if (fillHeight > 13) fillHeight = 13;
+    fb.fillRect(x + 1, y + 17 - fillHeight, 8, fillHeight, fillColor);  // Fill from bottom up
+}
+
+void ScreenRenderer::renderWeatherWidget(Framebuffer& fb, const WidgetData& data) {
+    // Same box as the server overlay: 320x160, centered, 30px above the bottom
+    const int boxWidth = 320;
+    const int boxHeight = 160;
+    int boxX = (fb.getWidth() - boxWidth) / 2;
+    int boxY = fb.getHeight() - boxHeight - 30;
+
+    fb.drawRoundedRect(boxX, boxY, boxWidth + 1, boxHeight + 1, 15, EPD_7IN3F_WHITE, EPD_7IN3F_BLACK);
+
+    // Everything else is laid out in box coordinates and clipped to the box
+    if (!fb.pushViewport(boxX, boxY, boxWidth, boxHeight)) return;
+
+    char line[72];
+    snprintf(line, sizeof(line), "%s, %s", data.city, data.country);
+    int titleScale = Framebuffer::textWidth(line, 2) <= boxWidth - 20 ? 2 : 1;
+    fb.drawText(line, (boxWidth - Framebuffer::textWidth(line, titleScale)) / 2, 25, titleScale);
+
+    snprintf(line, sizeof(line), "%.4f%c   %.4f%c",
+             data.latitude < 0 ? -data.latitude : data.latitude, data.latitude < 0 ? 'S' : 'N',
+             data.longitude < 0 ? -data.longitude : data.longitude, data.longitude < 0 ? 'W' : 'E');
+    fb.drawText(line, (boxWidth - Framebuffer::textWidth(line, 1)) / 2, 60, 1);
+
+    // Bottom row: date/time group, weather icon, temperature
+    const int groupSpacing = 15;
+    const int iconSize = 48;
+    int dateWidth = Framebuffer::textWidth(data.date, 1);
+    int timeWidth = Framebuffer::textWidth(data.time, 2);
+    int datetimeWidth = dateWidth > timeWidth ? dateWidth : timeWidth;
+
+    char temperature[8];
+    snprintf(temperature, sizeof(temperature), "%d", data.temperature);
+    // Digits, a drawn degree ring and "C"
+    int temperatureWidth = Framebuffer::textWidth(temperature, 3) + 8 + Framebuffer::textWidth("C", 3);
+
+    int totalWidth = datetimeWidth;
+    if (data.hasWeather) {
+        totalWidth += groupSpacing + iconSize + groupSpacing + temperatureWidth;
+    }
+
+    int rowY = 85;
+    int startX = (boxWidth - totalWidth) / 2;
+    fb.drawText(data.date, startX + (datetimeWidth - dateWidth) / 2, rowY + 8, 1);
+    fb.drawText(data.time, startX + (datetimeWidth - timeWidth) / 2, rowY + 24, 2);
+
+    if (data.hasWeather) {
+        int iconX = startX + datetimeWidth + groupSpacing;
+        
+        // Icon drawn into a sprite 8-pixel aligned on the frame, then
+        // composited over the box so only the icon's own pixels are written
+        alignas(4) static uint8_t spritePixels[ICON_SPRITE_WIDTH / 2 * ICON_SPRITE_HEIGHT];
+        Framebuffer sprite(spritePixels, ICON_SPRITE_WIDTH, ICON_SPRITE_HEIGHT);
+        sprite.clear(SPRITE_KEY_COLOR);
+        int spriteX = ((boxX + iconX - ICON_SPRITE_MARGIN) & ~7) - boxX;
+        int spriteY = rowY - ICON_SPRITE_MARGIN;
+        drawWeatherIcon(sprite, iconX - spriteX, ICON_SPRITE_MARGIN, iconSize, data.icon);
+        fb.composite(sprite, spriteX, spriteY, SPRITE_KEY_COLOR);
+
+        int temperatureX = iconX + iconSize + groupSpacing;
+        int temperatureY = rowY + (iconSize - 21) / 2;
+        fb.drawText(temperature, temperatureX, temperatureY, 3);
+
+        int degreeX = temperatureX + Framebuffer::textWidth(temperature, 3) + 2;
+        fb.fillCircle(degreeX + 2, temperatureY + 3, 3, EPD_7IN3F_BLACK);
+        fb.fillCircle(degreeX + 2, temperatureY + 3, 1, EPD_7IN3F_WHITE);
+        fb.drawText("C", degreeX + 8, temperatureY, 3);
+    }
+
+    fb.popViewport();
+}
+
+void ScreenRenderer::drawCloud(Framebuffer& fb, int x, int y, int size) {
+    // Outlined cloud: black shapes, then the same shapes shrunk in white
+    int r = size / 5;
+    for (int pass = 0; pass < 2; pass++) {
+        uint8_t color = pass == 0 ? EPD_7IN3F_BLACK : EPD_7IN3F_WHITE;
+        int inset = pass * 2;
+        fb.fillCircle(x + size * 3 / 10, y + size / 2, r - inset, color);
+        fb.fillCircle(x + size / 2, y + size * 2 / 5, r + size / 10 - inset, color);
+        fb.fillCircle(x + size * 7 / 10, y + size / 2, r - inset, color);
+        fb.fillRect(x + size * 3 / 10, y + size / 2 + inset, size * 2 / 5, r - 2 * inset + 1, color);
+    }
+}
+
+void ScreenRenderer::drawWeatherIcon(Framebuffer& fb, int x, int y, int size, const char* icon) {
+    // OpenWeatherMap codes: 01 clear, 02 few clouds, 03/04 clouds, 09/10 rain,
+    // 11 thunderstorm, 13 snow, 50 mist; trailing 'n' is the night variant
+    int code = atoi(icon);
+    bool night = strchr(icon, 'n') != nullptr;
+    int cx = x + size / 2;
+    int cy = y + size / 2;
+
+    if (code == 1 || code == 2) {
+        // Sun or moon, upper left when a cloud is in front of it
+        int sunX = code == 1 ? cx : x + size * 2 / 5;
+        int sunY = code == 1 ? cy : y + size * 2 / 5;
+        int radius = size / 5;
+
+        if (night) {
+            fb.fillCircle(sunX, sunY, radius + 2, EPD_7IN3F_YELLOW);
+            fb.fillCircle(sunX + radius / 2 + 2, sunY - radius / 2, radius, EPD_7IN3F_WHITE);
+        } else {
+            // Eight rays around the disc, directions in tenths
+            static const int8_t rays[8][2] = {
+                { 10, 0 }, { -10, 0 }, { 0, 10 }, { 0, -10 }, { 7, 7 }, { -7, -7 }, { 7, -7 }, { -7, 7 }
+            };
+            int inner = radius + 4;
+            int outer = radius + 9;
+            for (int i = 0; i < 8; i++) {
+                fb.drawLine(sunX + rays[i][0] * inner / 10, sunY + rays[i][1] * inner / 10,
+                            sunX + rays[i][0] * outer / 10, sunY + rays[i][1] * outer / 10, 2, EPD_7IN3F_ORANGE);
+            }
+            fb.fillCircle(sunX, sunY, radius, EPD_7IN3F_YELLOW);
+        }
+
+        if (code == 2) {
+            drawCloud(fb, x + size / 6, y + size / 4, size * 5 / 6);
+        }
+        return;
+    }
+
+    if (code == 50) {
+        // Mist: three staggered horizontal bars
+        for (int i = 0; i < 3; i++) {
+            int inset = (i % 2) * size / 8;
+            fb.fillRect(x + size / 8 + inset, y + size / 3 + i * size / 6, size * 3 / 4 - inset, 3, EPD_7IN3F_BLACK);
+        }
+        return;
+    }
+
+    // Everything else is a cloud with something falling out of it
+    drawCloud(fb, x, y - size / 8, size);
+    int baseY = y + size * 5 / 8;
+
+    if (code == 9 || code == 10) {
+        for (int i = 0; i < 3; i++) {
+            int dropX = x + size * 3 / 10 + i * size / 5;
+            fb.drawLine(dropX, baseY, dropX - 4, baseY + size / 4, 2, EPD_7IN3F_BLUE);
+        }
+    } else if (code == 11) {
+        fb.drawLine(cx + 2, baseY, cx - 5, baseY + size / 6, 3, EPD_7IN3F_ORANGE);
+        fb.drawLine(cx - 5, baseY + size / 6, cx + 3, baseY + size / 6, 3, EPD_7IN3F_ORANGE);
+        fb.drawLine(cx + 3, baseY + size / 6, cx - 4, baseY + size / 3, 3, EPD_7IN3F_ORANGE);
+    } else if (code == 13) {
+        for (int i = 0; i < 3; i++) {
+            int flakeX = x + size * 3 / 10 + i * size / 5;
+            int flakeY = baseY + size / 8 + (i % 2) * size / 8;
+            fb.drawLine(flakeX - 3, flakeY, flakeX + 3, flakeY, 1, EPD_7IN3F_BLUE);
+            fb.drawLine(flakeX, flakeY - 3, flakeX, flakeY + 3, 1, EPD_7IN3F_BLUE);
+            fb.drawLine(flakeX - 2, flakeY - 2, flakeX + 2, flakeY + 2, 1, EPD_7IN3F_BLUE);
+            fb.drawLine(flakeX - 2, flakeY + 2, flakeX + 2, flakeY - 2, 1, EPD_7IN3F_BLUE);
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include "tiled_frame.h"
+#include "framebuffer.h"
+
+static inline uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Hands the inflater the bytes of one tile only; it reads ahead in blocks
+// and must not take the start of the next tile
+struct TileInput {
+    StreamInput input;
+    void* context;
+    uint32_t remaining;
+};
+
+static size_t readTile(void* context, uint8_t* buffer, size_t length) {
+    TileInput* tile = (TileInput*)context;
+    if (length > tile->remaining) length = tile->remaining;
+    if (length == 0) return 0;
+
+    size_t received = tile->input(tile->context, buffer, length);
+    tile->remaining -= received;
+    return received;
+}
+
+TiledFrame::TiledFrame() : frameHash(0), windowSize(0), changedTiles(0), error(nullptr) {
+}
+
+bool TiledFrame::fail(const char* message) {
+    if (!error) error = message;
+    return false;
+}
+
+bool TiledFrame::parseIndex(const uint8_t* data, size_t length) {
+    error = nullptr;
+    if (length < INDEX_SIZE) return fail("truncated index");
+    if (readLE32(data) != MAGIC) return fail("not a tiled frame");
+    if (data[4] != VERSION) return fail("unsupported version");
+
+    int windowBits = data[5];
+    if (windowBits < 9 || windowBits > 15) return fail("unsupported window size");
+    if (readLE16(data + 6) != DISPLAY_WIDTH || readLE16(data + 8) != DISPLAY_HEIGHT ||
+        readLE16(data + 10) != TILE_WIDTH || readLE16(data + 12) != TILE_HEIGHT ||
+        readLE16(data + 14) != TILE_COUNT) {
+        return fail("unexpected frame or tile dimensions");
+    }
+    frameHash = readLE32(data + 16);
+    windowSize = (size_t)1 << windowBits;
+
+    const uint8_t* entry = data + HEADER_SIZE;
+    for (int tile = 0; tile < TILE_COUNT; tile++, entry += ENTRY_SIZE) {
+        tileHash[tile] = readLE32(entry);
+        tileEnd[tile] = readLE32(entry + 4);
+        if (tileEnd[tile] <= tileStart(tile)) return fail("invalid tile offsets");
+    }
+    return true;
+}
+
+uint32_t TiledFrame::hashTile(const uint8_t* frame, int tile) {
+    const int stride = DISPLAY_WIDTH / 2;
+    const uint8_t* row = frame + (tile / COLUMNS) * TILE_HEIGHT * stride + (tile % COLUMNS) * TILE_STRIDE;
+    uint32_t hash = Framebuffer::HASH_SEED;
+    for (int y = 0; y < TILE_HEIGHT; y++, row += stride) {
+        hash = Framebuffer::hash(row, TILE_STRIDE, hash);
+    }
+    return hash;
+}
+
+int TiledFrame::planRanges(const uint8_t* frame, Range* ranges, int maxRanges) {
+    Range runs[TILE_COUNT];
+    int count = 0;
+    changedTiles = 0;
+
+    for (int tile = 0; tile < TILE_COUNT; tile++) {
+        if (hashTile(frame, tile) == tileHash[tile]) continue;
+        changedTiles++;
+        if (count > 0 && runs[count - 1].end == tile) {
+            runs[count - 1].end = tile + 1;
+        } else {
+            runs[count].first = tile;
+            runs[count].end = tile + 1;
+            count++;
+        }
+    }
+
+    // Each range costs a request: fetch the smallest unchanged gaps instead
+    while (count > maxRanges) {
+        int merge = 0;
+        uint32_t smallest = UINT32_MAX;
+        for (int i = 0; i + 1 < count; i++) {
+            uint32_t gap = tileStart(runs[i + 1].first) - tileStart(runs[i].end);
+            if (gap < smallest) {
+                smallest = gap;
+                merge = i;
+            }
+        }
+        runs[merge].end = runs[merge + 1].end;
+        for (int i = merge + 1; i + 1 < count; i++) {
+            runs[i] = runs[i + 1];
+        }
+        count--;
+    }
+
+    for (int i = 0; i < count; i++) {
+        ranges[i] = runs[i];
+    }
+    return count;
+}
+
+uint32_t TiledFrame::rangeStart(const Range& range) const {
+    return INDEX_SIZE + tileStart(range.first);
+}
+
+uint32_t TiledFrame::rangeEnd(const Range& range) const {
+    return INDEX_SIZE + tileEnd[range.end - 1];
+}
+
+bool TiledFrame::decodeRange(const Range& range, StreamInput input, void* context, uint8_t* frame) {
+    const int stride = DISPLAY_WIDTH / 2;
+
+    for (int tile = range.first; tile < range.end; tile++) {
+        TileInput tileInput = { input, context, tileEnd[tile] - tileStart(tile) };
+        if (!inflater.begin(InflateStream::FORMAT_RAW, readTile, &tileInput, windowSize)) {
+            return fail(inflater.getError());
+        }
+
+        uint8_t* row = frame + (tile / COLUMNS) * TILE_HEIGHT * stride + (tile % COLUMNS) * TILE_STRIDE;
+        for (int y = 0; y < TILE_HEIGHT; y++, row += stride) {
+            if (inflater.read(row, TILE_STRIDE) != TILE_STRIDE) {
+                return fail(inflater.hasError() ? inflater.getError() : "tile data ended early");
+            }
+        }
+
+        uint8_t extra;
+        if (inflater.read(&extra, 1) != 0 || !inflater.isFinished() || tileInput.remaining != 0) {
+            return fail("tile size does not match the index");
+        }
+        if (hashTile(frame, tile) != tileHash[tile]) return fail("tile hash mismatch");
+    }
+    return true;
+}
+
+void TiledFrame::end() {
+    inflater.end();
+}
@@ -0,0 +1,442 @@
+#include "tls_session_client.h"
+#include "serial_config.h"  // Must be included before Arduino.h
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include "framebuffer.h"
+
+#define TLS_SESSION_MAGIC 0x544C5353  // "TLSS"
+
+// TLS 1.2 record content and handshake message types (RFC 5246)
+#define TLS_RECORD_CHANGE_CIPHER_SPEC 20
+#define TLS_RECORD_HANDSHAKE 22
+#define TLS_HANDSHAKE_CERTIFICATE 11
+
+// Last session negotiated with the frame host and handshake counters. RTC
+// slow memory survives deep sleep; a power cycle starts with a full handshake.
+struct TlsSessionCache {
+    uint32_t magic;
+    uint32_t hostHash;
+    uint32_t length;                    // Serialised session, 0 if none
+    uint8_t session[TLS_SESSION_CACHE_SIZE];
+    uint32_t fullHandshakes;
+    uint32_t fullMs;
+    uint32_t resumedHandshakes;
+    uint32_t resumedMs;
+};
+
+RTC_DATA_ATTR static TlsSessionCache sessionCache;
+static_assert(sizeof(TlsSessionCache) <= RTC_TLS_SESSION_BYTES, "TlsSessionCache exceeds RTC_TLS_SESSION_BYTES");
+
+static uint32_t hashHost(const char* host, uint16_t port) {
+    uint32_t hash = Framebuffer::hash((const uint8_t*)host, strlen(host));
+    return Framebuffer::hash((const uint8_t*)&port, sizeof(port), hash);
+}
+
+ResumableTlsClient::ResumableTlsClient() :
+    rngReady(false), sslReady(false), established(false), resumed(false),
+    sessionSaved(false), plaintext(false), handshakeMs(0), peeked(-1), hostHash(0) {
+    memset(&scan, 0, sizeof(scan));
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+}
+
+ResumableTlsClient::~ResumableTlsClient() {
+    stop();
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+int ResumableTlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port, 0);
+}
+
+int ResumableTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, 0);
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    resumed = false;
+    sessionSaved = false;
+    if (timeout <= 0) {
+        timeout = TLS_HANDSHAKE_TIMEOUT_MS;
+    }
+
+    unsigned long start = millis();
+    if (!tcp.connect(host, port, timeout)) {
+        Serial.printf("TCP connect to %s:%u failed\n", host, port);
+        return 0;
+    }
+    hostHash = hashHost(host, port);
+    if (plaintext) {
+        handshakeMs = millis() - start;
+        established = true;
+        return 1;
+    }
+
+    if (!handshake(host, timeout)) {
+        stop();
+        return 0;
+    }
+    handshakeMs = millis() - start;
+    established = true;
+
+    if (sessionCache.magic != TLS_SESSION_MAGIC) {
+        memset(&sessionCache, 0, sizeof(sessionCache));
+        sessionCache.magic = TLS_SESSION_MAGIC;
+    }
+    if (resumed) {
+        sessionCache.resumedHandshakes++;
+        sessionCache.resumedMs += handshakeMs;
+    } else {
+        sessionCache.fullHandshakes++;
+        sessionCache.fullMs += handshakeMs;
+    }
+
+    Serial.printf("TLS %s handshake in %lu ms (full avg %lu ms over %u, resumed avg %lu ms over %u)\n",
+                  resumed ? "resumed" : "full", handshakeMs,
+                  sessionCache.fullHandshakes ? sessionCache.fullMs / sessionCache.fullHandshakes : 0UL,
+                  sessionCache.fullHandshakes,
+                  sessionCache.resumedHandshakes ? sessionCache.resumedMs / sessionCache.resumedHandshakes : 0UL,
+                  sessionCache.resumedHandshakes);
+    return 1;
+}
+
+bool ResumableTlsClient::handshake(const char* host, int32_t timeout) {
+    if (!rngReady) {
+        static const char personalisation[] = "smart-dashboard";
+        if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                  (const unsigned char*)personalisation, sizeof(personalisation) - 1) != 0) {
+            Serial.println("TLS: RNG seed failed");
+            return false;
+        }
+        rngReady = true;
+    }
+
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    sslReady = true;
+
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        Serial.println("TLS: config defaults failed");
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+
+    int ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&ssl, host);
+    if (ret != 0) {
+        Serial.printf("TLS: setup failed (-0x%04X)\n", -ret);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl, this, sendCallback, receiveCallback, nullptr);
+
+    bool offered = offerSavedSession();
+
+    memset(&scan, 0, sizeof(scan));
+    scan.active = true;
+    unsigned long start = millis();
+    while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
+        unsigned long waited = millis() - start;
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            Serial.printf("TLS: handshake failed (-0x%04X)\n", -ret);
+            // A stale session must not break the next attempt
+            if (offered) sessionCache.length = 0;
+            return false;
+        }
+        bool ready = waited < (unsigned long)timeout &&
+                     (ret == MBEDTLS_ERR_SSL_WANT_READ ? waitReadable(timeout - waited)
+                                                      : waitWritable(timeout - waited));
+        if (!ready) {
+            Serial.println("TLS: handshake timed out");
+            return false;
+        }
+    }
+    scan.active = false;
+
+    // Only a full handshake has the server send its certificate
+    resumed = offered && !scan.certificateSeen;
+    return true;
+}
+
+void ResumableTlsClient::scanHandshake(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && scan.active; i++) {
+        if (scan.recordLeft == 0) {
+            scan.header[scan.headerLength++] = data[i];
+            if (scan.headerLength == sizeof(scan.header)) {
+                scan.recordType = scan.header[0];
+                scan.recordLeft = ((uint16_t)scan.header[3] << 8) | scan.header[4];
+                scan.headerLength = 0;
+                // Everything after the server's CCS is encrypted
+                if (scan.recordType == TLS_RECORD_CHANGE_CIPHER_SPEC) scan.active = false;
+            }
+            continue;
+        }
+
+        scan.recordLeft--;
+        if (scan.recordType != TLS_RECORD_HANDSHAKE) continue;
+
+        // Handshake messages (type, 24-bit length) may span records
+        if (scan.messageHeaderLength > 0) {
+            scan.messageLeft = (scan.messageLeft << 8) | data[i];
+            if (++scan.messageHeaderLength == 4) scan.messageHeaderLength = 0;
+        } else if (scan.messageLeft > 0) {
+            scan.messageLeft--;
+        } else {
+            if (data[i] == TLS_HANDSHAKE_CERTIFICATE) scan.certificateSeen = true;
+            scan.messageHeaderLength = 1;
+        }
+    }
+}
+
+bool ResumableTlsClient::offerSavedSession() {
+    if (sessionCache.magic != TLS_SESSION_MAGIC || sessionCache.length == 0 ||
+        sessionCache.hostHash != hostHash) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_session_load(&session, sessionCache.session, sessionCache.length);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_session(&ssl, &session);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret != 0) {
+        Serial.printf("TLS: saved session rejected (-0x%04X)\n", -ret);
+        sessionCache.length = 0;
+        return false;
+    }
+    return true;
+}
+
+bool ResumableTlsClient::saveSession() {
+    if (!established || plaintext || sessionSaved) {
+        return sessionSaved;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = 0;
+    int ret = mbedtls_ssl_get_session(&ssl, &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, sessionCache.session, sizeof(sessionCache.session), &length);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret != 0) {
+        // Too small when the session carries the whole peer certificate
+        Serial.printf("TLS: session not saved (-0x%04X, %u bytes needed)\n", -ret, (unsigned)length);
+        sessionCache.length = 0;
+        return false;
+    }
+
+    sessionCache.hostHash = hostHash;
+    sessionCache.length = length;
+    sessionSaved = true;
+    Serial.printf("TLS: session saved (%u bytes)\n", (unsigned)length);
+    return true;
+}
+
+int ResumableTlsClient::sendCallback(void* context, const unsigned char* buffer, size_t length) {
+    WiFiClient& tcp = ((ResumableTlsClient*)context)->tcp;
+    if (!tcp.connected()) {
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    size_t sent = tcp.write(buffer, length);
+    return sent > 0 ? (int)sent : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int ResumableTlsClient::receiveCallback(void* context, unsigned char* buffer, size_t length) {
+    ResumableTlsClient* client = (ResumableTlsClient*)context;
+    WiFiClient& tcp = client->tcp;
+    if (tcp.available() <= 0) {
+        return tcp.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    int received = tcp.read(buffer, length);
+    if (received <= 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    client->scanHandshake(buffer, received);
+    return received;
+}
+
+size_t ResumableTlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t ResumableTlsClient::write(const uint8_t* buffer, size_t size) {
+    if (!established) {
+        return 0;
+    }
+    if (plaintext) {
+        return tcp.write(buffer, size);
+    }
+
+    size_t written = 0;
+    unsigned long start = millis();
+    while (written < size) {
+        int ret = mbedtls_ssl_write(&ssl, buffer + written, size - written);
+        if (ret > 0) {
+            written += ret;
+            continue;
+        }
+
+        // Wait in select() for the socket mbedtls is blocked on
+        unsigned long waited = millis() - start;
+        unsigned long timeout = getTimeout();
+        bool ready = waited < timeout &&
+                     ((ret == MBEDTLS_ERR_SSL_WANT_WRITE && waitWritable(timeout - waited)) ||
+                      (ret == MBEDTLS_ERR_SSL_WANT_READ && waitReadable(timeout - waited)));
+        if (!ready) {
+            stop();
+            break;
+        }
+    }
+    return written;
+}
+
+int ResumableTlsClient::available() {
+    if (!established) {
+        return 0;
+    }
+    if (plaintext) {
+        return tcp.available() + (peeked >= 0 ? 1 : 0);
+    }
+
+    // Process a pending record so its plaintext becomes available
+    size_t pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (pending == 0 && tcp.available() > 0) {
+        int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            stop();
+            return peeked >= 0 ? 1 : 0;
+        }
+        pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    }
+    return pending + (peeked >= 0 ? 1 : 0);
+}
+
+int ResumableTlsClient::read() {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int ResumableTlsClient::read(uint8_t* buffer, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    int copied = 0;
+    if (peeked >= 0) {
+        buffer[copied++] = (uint8_t)peeked;
+        peeked = -1;
+        if (--size == 0) return copied;
+    }
+
+    if (available() <= 0) {
+        return copied > 0 ? copied : -1;
+    }
+    if (plaintext) {
+        int received = tcp.read(buffer + copied, size);
+        return received > 0 ? copied + received : (copied > 0 ? copied : -1);
+    }
+
+    int ret = mbedtls_ssl_read(&ssl, buffer + copied, size);
+    if (ret > 0) {
+        return copied + ret;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        stop();
+    }
+    return copied > 0 ? copied : -1;
+}
+
+int ResumableTlsClient::receive(uint8_t* buffer, size_t size, uint32_t timeoutMs) {
+    unsigned long start = millis();
+    while (true) {
+        int received = read(buffer, size);
+        if (received > 0) {
+            return received;
+        }
+        if (!connected()) {
+            return -1;
+        }
+
+        // Nothing decrypted yet and the TCP buffer is drained (or holds
+        // only part of a record): sleep until the socket has more
+        unsigned long waited = millis() - start;
+        if (waited >= timeoutMs || !waitReadable(timeoutMs - waited)) {
+            return 0;
+        }
+    }
+}
+
+static bool waitSocket(int socket, bool forWrite, uint32_t timeoutMs) {
+    if (socket < 0) {
+        return false;
+    }
+
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET(socket, &ready);
+    struct timeval timeout = { (time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000) };
+    return select(socket + 1, forWrite ? nullptr : &ready, forWrite ? &ready : nullptr, nullptr, &timeout) > 0;
+}
+
+bool ResumableTlsClient::waitReadable(uint32_t timeoutMs) {
+    return waitSocket(tcp.fd(), false, timeoutMs);
+}
+
+bool ResumableTlsClient::waitWritable(uint32_t timeoutMs) {
+    return waitSocket(tcp.fd(), true, timeoutMs);
+}
+
+int ResumableTlsClient::peek() {
+    if (peeked < 0) {
+        uint8_t data;
+        if (read(&data, 1) == 1) {
+            peeked = data;
+        }
+    }
+    return peeked;
+}
+
+void ResumableTlsClient::flush() {
+    tcp.flush();
+}
+
+void ResumableTlsClient::stop() {
+    if (established && sslReady) {
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    established = false;
+    peeked = -1;
+    tcp.stop();
+    freeSsl();
+}
+
+uint8_t ResumableTlsClient::connected() {
+    if (!established) {
+        return 0;
+    }
+    return tcp.connected() || available() > 0;
+}
+
+void ResumableTlsClient::freeSsl() {
+    if (sslReady) {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_config_free(&conf);
+        sslReady = false;
+    }
+}
@@ -0,0 +1,358 @@
+#include "vector_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Largest coordinate magnitude accepted, keeps all products within int64
+static const int32_t COORDINATE_LIMIT = 1 << 20;
+
+static inline uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline int32_t zigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) bit >>= 2;
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+int VectorMap::compareEdges(const void* a, const void* b) {
+    int32_t ya = ((const Edge*)a)->y0;
+    int32_t yb = ((const Edge*)b)->y0;
+    return (ya > yb) - (ya < yb);
+}
+
+VectorMap::VectorMap() :
+    data(nullptr), length(0), precision(0), width(0), height(0), background(EPD_7IN3F_WHITE),
+    layerCount(0), featureCount(0), pointCount(0), maxFeaturePoints(0), error(nullptr),
+    points(nullptr), edges(nullptr), crossings(nullptr), active(nullptr) {
+}
+
+VectorMap::~VectorMap() {
+    freeScratch();
+}
+
+void VectorMap::freeScratch() {
+    free(points);
+    free(edges);
+    free(crossings);
+    free(active);
+    points = nullptr;
+    edges = nullptr;
+    crossings = nullptr;
+    active = nullptr;
+}
+
+bool VectorMap::fail(const char* message) {
+    error = message;
+    data = nullptr;
+    freeScratch();
+    return false;
+}
+
+bool VectorMap::load(const uint8_t* mapData, size_t mapLength) {
+    freeScratch();
+    error = nullptr;
+    featureCount = 0;
+    pointCount = 0;
+    maxFeaturePoints = 0;
+
+    if (mapLength < HEADER_SIZE) return fail("truncated header");
+    if (readLE32(mapData) != MAGIC) return fail("bad magic");
+    if (mapData[4] != VERSION) return fail("unsupported version");
+
+    precision = mapData[5];
+    background = mapData[6];
+    layerCount = mapData[7];
+    width = readLE16(mapData + 8);
+    height = readLE16(mapData + 10);
+    if (precision > MAX_PRECISION) return fail("bad precision");
+    if (background > EPD_7IN3F_CLEAN) return fail("bad background color");
+
+    if (Framebuffer::hash(mapData + HEADER_SIZE, mapLength - HEADER_SIZE) != readLE32(mapData + 12)) {
+        return fail("hash mismatch");
+    }
+
+    // Walk every coordinate once so rendering can skip all checks
+    const uint8_t* p = mapData + HEADER_SIZE;
+    const uint8_t* end = mapData + mapLength;
+    for (int layer = 0; layer < layerCount; layer++) {
+        if (end - p < 3) return fail("truncated layer");
+        uint8_t kind = p[0];
+        uint8_t color = p[1];
+        uint8_t lineWidth = p[2];
+        p += 3;
+        if (kind > LAYER_LINE) return fail("bad layer kind");
+        if (color > EPD_7IN3F_CLEAN) return fail("bad layer color");
+        if (kind == LAYER_LINE && (lineWidth < 1 || lineWidth > 32)) return fail("bad line width");
+
+        uint32_t features;
+        if (!readVarint(p, end, features)) return fail("truncated layer");
+        int32_t x = 0, y = 0;
+
+        for (uint32_t f = 0; f < features; f++) {
+            uint32_t parts;
+            if (!readVarint(p, end, parts)) return fail("truncated feature");
+            size_t featurePoints = 0;
+
+            for (uint32_t part = 0; part < parts; part++) {
+                uint32_t count;
+                if (!readVarint(p, end, count)) return fail("truncated part");
+                if (count > MAX_FEATURE_POINTS) return fail("feature too large");
+
+                for (uint32_t i = 0; i < count; i++) {
+                    uint32_t dx, dy;
+                    if (!readVarint(p, end, dx) || !readVarint(p, end, dy)) return fail("truncated point");
+                    x += zigzag(dx);
+                    y += zigzag(dy);
+                    if (x < -COORDINATE_LIMIT || x > COORDINATE_LIMIT ||
+                        y < -COORDINATE_LIMIT || y > COORDINATE_LIMIT) {
+                        return fail("coordinate out of range");
+                    }
+                }
+
+                // Lines only need one part at a time, fills all rings at once
+                featurePoints = kind == LAYER_FILL ? featurePoints + count : count;
+                if (featurePoints > MAX_FEATURE_POINTS) return fail("feature too large");
+                if (featurePoints > maxFeaturePoints) maxFeaturePoints = featurePoints;
+                pointCount += count;
+            }
+            featureCount++;
+        }
+    }
+    if (p != end) return fail("trailing data");
+
+    size_t scratch = maxFeaturePoints > 4 ? maxFeaturePoints : 4;
+    points = (int32_t*)malloc(scratch * 2 * sizeof(int32_t));
+    edges = (Edge*)malloc(scratch * sizeof(Edge));
+    crossings = (int32_t*)malloc(scratch * sizeof(int32_t));
+    active = (uint16_t*)malloc(scratch * sizeof(uint16_t));
+    if (!points || !edges || !crossings || !active) return fail("out of memory");
+
+    data = mapData;
+    length = mapLength;
+    return true;
+}
+
+void VectorMap::fillEdges(Framebuffer& band, int top, Edge* edgeList, size_t count,
+                          int32_t* xs, uint16_t* activeList, uint8_t color) const {
+    if (count < 2) return;
+
+    // Internal units carry one extra fractional bit so pixel centers are exact
+    const int shift = precision + 1;
+    const int32_t one = 1 << shift;
+    const int32_t half = one >> 1;
+
+    qsort(edgeList, count, sizeof(Edge), compareEdges);
+
+    int32_t maxY = edgeList[0].y1;
+    for (size_t i = 1; i < count; i++) {
+        if (edgeList[i].y1 > maxY) maxY = edgeList[i].y1;
+    }
+
+    int rowStart = edgeList[0].y0 >> shift;
+    int rowEnd = (maxY >> shift) + 1;
+    if (rowStart < top) rowStart = top;
+    if (rowEnd > top + band.getHeight()) rowEnd = top + band.getHeight();
+
+    // Active edge list: edges enter in y0 order and leave once passed
+    size_t next = 0;
+    size_t activeCount = 0;
+    for (int row = rowStart; row < rowEnd; row++) {
+        int32_t sampleY = ((int32_t)row << shift) + half;
+        while (next < count && edgeList[next].y0 <= sampleY) {
+            activeList[activeCount++] = (uint16_t)next++;
+        }
+
+        size_t crossingCount = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < activeCount; i++) {
+            const Edge& e = edgeList[activeList[i]];
+            if (e.y1 <= sampleY) continue;
+            activeList[kept++] = activeList[i];
+            xs[crossingCount++] = e.x0 + (int32_t)((int64_t)(sampleY - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0));
+        }
+        activeCount = kept;
+
+        // Few crossings per row: insertion sort
+        for (size_t i = 1; i < crossingCount; i++) {
+            int32_t value = xs[i];
+            size_t j = i;
+            while (j > 0 && xs[j - 1] > value) {
+                xs[j] = xs[j - 1];
+                j--;
+            }
+            xs[j] = value;
+        }
+
+        // Pixels whose centers lie in [xs[k], xs[k + 1])
+        for (size_t k = 0; k + 1 < crossingCount; k += 2) {
+            int x0 = (xs[k] - half + one - 1) >> shift;
+            int x1 = (xs[k + 1] - half + one - 1) >> shift;
+            if (x1 > x0) {
+                band.fillRect(x0, row - top, x1 - x0, 1, color);
+            }
+        }
+    }
+}
+
+void VectorMap::drawPolyline(Framebuffer& band, int top, const int32_t* pts,
+                             size_t count, int lineWidth, uint8_t color) const {
+    const int shift = precision + 1;
+    const int rowEnd = top + band.getHeight();
+    const int margin = lineWidth;
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        int32_t ax = pts[2 * i], ay = pts[2 * i + 1];
+        int32_t bx = pts[2 * i + 2], by = pts[2 * i + 3];
+
+        int minRow = (ay < by ? ay : by) >> shift;
+        int maxRow = (ay > by ? ay : by) >> shift;
+        if (maxRow + margin < top || minRow - margin >= rowEnd) continue;
+
+        if (lineWidth == 1) {
+            band.drawLine(ax >> shift, (ay >> shift) - top, bx >> shift, (by >> shift) - top, 1, color);
+            continue;
+        }
+
+        // Segment as a quad offset by half the width along the normal
+        int32_t dx = bx - ax, dy = by - ay;
+        uint32_t segmentLength = isqrt64((uint64_t)((int64_t)dx * dx + (int64_t)dy * dy));
+        if (segmentLength == 0) continue;
+
+        int32_t halfWidth = ((int32_t)lineWidth << shift) / 2;
+        int32_t nx = (int32_t)(-(int64_t)dy * halfWidth / segmentLength);
+        int32_t ny = (int32_t)((int64_t)dx * halfWidth / segmentLength);
+        int32_t corners[4][2] = {
+            { ax + nx, ay + ny }, { bx + nx, by + ny },
+            { bx - nx, by - ny }, { ax - nx, ay - ny }
+        };
+
+        Edge quad[4];
+        size_t edgeCount = 0;
+        for (int c = 0; c < 4; c++) {
+            const int32_t* from = corners[c];
+            const int32_t* to = corners[(c + 1) & 3];
+            if (from[1] == to[1]) continue;
+            Edge& e = quad[edgeCount++];
+            if (from[1] < to[1]) {
+                e.x0 = from[0]; e.y0 = from[1]; e.x1 = to[0]; e.y1 = to[1];
+            } else {
+                e.x0 = to[0]; e.y0 = to[1]; e.x1 = from[0]; e.y1 = from[1];
+            }
+        }
+
+        int32_t xs[4];
+        uint16_t activeList[4];
+        fillEdges(band, top, quad, edgeCount, xs, activeList, color);
+    }
+
+    // Round joins and caps
+    int radius = lineWidth / 2;
+    for (size_t i = 0; i < count; i++) {
+        int row = pts[2 * i + 1] >> shift;
+        if (row + radius < top || row - radius >= rowEnd) continue;
+        band.fillCircle(pts[2 * i] >> shift, row - top, radius, color);
+    }
+}
+
+void VectorMap::renderBand(Framebuffer& band, int top) const {
+    band.clear(background);
+    if (!data) return;
+
+    const int shift = precision + 1;
+    const int rowEnd = top + band.getHeight();
+    const uint8_t* p = data + HEADER_SIZE;
+    const uint8_t* end = data + length;
+
+    for (int layer = 0; layer < layerCount; layer++) {
+        uint8_t kind = p[0];
+        uint8_t color = p[1];
+        int lineWidth = p[2];
+        p += 3;
+
+        uint32_t features;
+        readVarint(p, end, features);
+        int32_t x = 0, y = 0;
+        int margin = kind == LAYER_LINE ? lineWidth : 0;
+
+        for (uint32_t f = 0; f < features; f++) {
+            uint32_t parts;
+            readVarint(p, end, parts);
+            size_t edgeCount = 0;
+
+            for (uint32_t part = 0; part < parts; part++) {
+                uint32_t count;
+                readVarint(p, end, count);
+
+                int32_t partMinY = COORDINATE_LIMIT << 1, partMaxY = -(COORDINATE_LIMIT << 1);
+                for (uint32_t i = 0; i < count; i++) {
+                    uint32_t dx, dy;
+                    readVarint(p, end, dx);
+                    readVarint(p, end, dy);
+                    x += zigzag(dx);
+                    y += zigzag(dy);
+                    points[2 * i] = x * 2;
+                    points[2 * i + 1] = y * 2;
+                    if (points[2 * i + 1] < partMinY) partMinY = points[2 * i + 1];
+                    if (points[2 * i + 1] > partMaxY) partMaxY = points[2 * i + 1];
+                }
+
+                // Parts entirely outside the band only advance the cursor
+                bool visible = count > 0 &&
+                               (partMaxY >> shift) + margin >= top &&
+                               (partMinY >> shift) - margin < rowEnd;
+                if (!visible) continue;
+
+                if (kind == LAYER_LINE) {
+                    drawPolyline(band, top, points, count, lineWidth, color);
+                    continue;
+                }
+
+                // Closed ring: one edge per point, horizontal edges dropped
+                for (uint32_t i = 0; i < count; i++) {
+                    const int32_t* from = points + 2 * i;
+                    const int32_t* to = points + 2 * ((i + 1) % count);
+                    if (from[1] == to[1]) continue;
+                    Edge& e = edges[edgeCount++];
+                    if (from[1] < to[1]) {
+                        e.x0 = from[0]; e.y0 = from[1]; e.x1 = to[0]; e.y1 = to[1];
+                    } else {
+                        e.x0 = to[0]; e.y0 = to[1]; e.x1 = from[0]; e.y1 = from[1];
+                    }
+                }
+            }
+
+            if (kind == LAYER_FILL && edgeCount > 0) {
+                fillEdges(band, top, edges, edgeCount, crossings, active, color);
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+// BitplaneFrame against straightforward per-nibble loops: packed -> planes ->
+// packed round trips (whole frame and piece by piece, as read from the frame
+// cache), changed-pixel counts, color counts and masked copies, on the
+// checked-in maps and on random frames.
+
+#include "host_test.h"
+#include "bitplane_frame.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_RUNS 20
+
+static uint8_t nibble(const std::vector<uint8_t>& frame, size_t pixel) {
+    uint8_t packed = frame[pixel / 2];
+    return (pixel % 2 == 0) ? (packed >> 4) : (packed & 0x0F);
+}
+
+static std::vector<uint8_t> randomFrame(size_t size, unsigned seed) {
+    std::vector<uint8_t> frame(size);
+    srand(seed);
+    for (uint8_t& byte : frame) {
+        byte = ((rand() % 7) << 4) | (rand() % 7);
+    }
+    return frame;
+}
+
+static void checkRoundTrip(const char* name, const std::vector<uint8_t>& frame, int width, int height) {
+    BitplaneFrame planes(width, height);
+    CHECK(planes.isAllocated());
+
+    double toPlanes = medianMicros(BENCH_RUNS, [&]() { planes.fromPacked(frame.data()); });
+    std::vector<uint8_t> back(frame.size());
+    double toPacked = medianMicros(BENCH_RUNS, [&]() { planes.toPacked(back.data()); });
+    CHECK(back == frame);
+    printf("%-16s packed->planes %7.1f us, planes->packed %7.1f us\n", name, toPlanes, toPacked);
+
+    // Same planes when the frame arrives in cache-sized pieces
+    BitplaneFrame pieces(width, height);
+    for (size_t offset = 0; offset < frame.size(); offset += STREAM_CHUNK_SIZE) {
+        size_t length = frame.size() - offset < STREAM_CHUNK_SIZE ? frame.size() - offset : STREAM_CHUNK_SIZE;
+        CHECK(pieces.fromPacked(frame.data() + offset, offset, length));
+    }
+    CHECK(BitplaneFrame::countChangedPixels(planes, pieces) == 0);
+    CHECK(planes.hash() == pieces.hash());
+
+    // Misaligned pieces and overruns are refused
+    CHECK(!pieces.fromPacked(frame.data(), 8, 16));
+    CHECK(!pieces.fromPacked(frame.data(), 0, 24));
+    CHECK(!pieces.fromPacked(frame.data(), frame.size() - 16, 32));
+
+    for (uint8_t color = 0; color < 8; color++) {
+        size_t expected = 0;
+        for (size_t pixel = 0; pixel < frame.size() * 2; pixel++) {
+            expected += nibble(frame, pixel) == color;
+        }
+        CHECK(planes.countColor(color) == expected);
+    }
+}
+
+static void checkDiff(const char* name, const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                      int width, int height) {
+    BitplaneFrame planesA(width, height), planesB(width, height);
+    planesA.fromPacked(a.data());
+    planesB.fromPacked(b.data());
+
+    size_t expected = 0;
+    int expectedFirst = -1, expectedLast = -1;
+    double loop = medianMicros(BENCH_RUNS, [&]() {
+        expected = 0;
+        for (size_t pixel = 0; pixel < a.size() * 2; pixel++) {
+            if (nibble(a, pixel) != nibble(b, pixel)) {
+                expected++;
+                int row = pixel / width;
+                if (expectedFirst < 0) expectedFirst = row;
+                expectedLast = row;
+            }
+        }
+    });
+
+    size_t changed = 0;
+    double words = medianMicros(BENCH_RUNS, [&]() {
+        changed = BitplaneFrame::countChangedPixels(planesA, planesB);
+    });
+    printf("%-16s %7u changed pixels: per-nibble %7.1f us, XOR+popcount %6.1f us\n", name,
+           (unsigned)changed, loop, words);
+    CHECK(changed == expected);
+
+    int first, last;
+    CHECK(BitplaneFrame::changedRows(planesA, planesB, first, last) == (expected > 0));
+    CHECK(first == expectedFirst && last == expectedLast);
+
+    // Copying the changed pixels of b into a gives b
+    std::vector<uint32_t> mask(planesA.getWordsPerPlane());
+    BitplaneFrame::diffMask(planesA, planesB, mask.data());
+    planesA.maskedCopy(planesB, mask.data());
+    CHECK(BitplaneFrame::countChangedPixels(planesA, planesB) == 0);
+}
+
+int main() {
+    std::vector<uint8_t> vienna, shenzhen;
+    CHECK(readFile(mapPath("Vienna_Austria", ".bin"), vienna));
+    CHECK(readFile(mapPath("Shenzhen_China", ".bin"), shenzhen));
+    size_t frameSize = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+    if (vienna.size() != frameSize || shenzhen.size() != frameSize) {
+        fprintf(stderr, "Unexpected map sizes\n");
+        return 1;
+    }
+
+    checkRoundTrip("Vienna", vienna, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    checkRoundTrip("Shenzhen", shenzhen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    checkRoundTrip("random portrait", randomFrame(frameSize, 7), DISPLAY_HEIGHT, DISPLAY_WIDTH);
+
+    checkDiff("Vienna/Shenzhen", vienna, shenzhen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    checkDiff("identical", vienna, vienna, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+
+    // A few pixels changed, as a refresh-skip decision sees them
+    std::vector<uint8_t> touched = vienna;
+    touched[1000] ^= 0x10;
+    touched[frameSize / 2] ^= 0x03;
+    touched[frameSize - 1] ^= 0x44;
+    checkDiff("4 pixels", vienna, touched, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+
+    return hostTestResult("bitplane_frame_test");
+}
@@ -0,0 +1,95 @@
+// CompressedFrame on the checked-in .binz maps: inflated in the piece sizes
+// the panel stream uses, with network input from 1 byte to the whole file,
+// the frame must equal the matching .bin. Prints the compression ratio, the
+// window the decoder needed and the inflate throughput.
+
+#include "host_test.h"
+#include "config.h"
+#include "compressed_frame.h"
+#include <string.h>
+
+#define BENCH_RUNS 20
+
+static const size_t FRAME_SIZE = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+
+struct ChunkedInput {
+    const std::vector<uint8_t>* data;
+    size_t position;
+    size_t chunkSize;
+};
+
+static size_t readChunked(void* context, uint8_t* buffer, size_t length) {
+    ChunkedInput* input = static_cast<ChunkedInput*>(context);
+    size_t available = input->data->size() - input->position;
+    if (length > input->chunkSize) length = input->chunkSize;
+    if (length > available) length = available;
+    memcpy(buffer, input->data->data() + input->position, length);
+    input->position += length;
+    return length;
+}
+
+// Inflate the whole frame in pieces of pieceSize; false unless finish() agrees
+static bool inflate(const std::vector<uint8_t>& binz, size_t chunkSize, size_t pieceSize,
+                    std::vector<uint8_t>& frame, CompressedFrame& decoder) {
+    ChunkedInput input = {&binz, 0, chunkSize};
+    frame.clear();
+    if (!decoder.begin(readChunked, &input)) return false;
+
+    std::vector<uint8_t> piece(pieceSize);
+    size_t produced;
+    while ((produced = decoder.read(piece.data(), piece.size())) > 0) {
+        frame.insert(frame.end(), piece.begin(), piece.begin() + produced);
+    }
+    bool ok = decoder.finish();
+    decoder.end();
+    return ok;
+}
+
+static void checkMap(const char* name) {
+    std::vector<uint8_t> binz, expected;
+    CHECK(readFile(mapPath(name, ".binz"), binz));
+    CHECK(readFile(mapPath(name, ".bin"), expected));
+    if (binz.empty() || expected.size() != FRAME_SIZE) return;
+
+    CompressedFrame decoder;
+    std::vector<uint8_t> frame;
+    for (size_t chunkSize : {(size_t)1, (size_t)1460, binz.size()}) {
+        for (size_t pieceSize : {(size_t)STREAM_CHUNK_SIZE, (size_t)333, FRAME_SIZE}) {
+            if (!inflate(binz, chunkSize, pieceSize, frame, decoder)) {
+                fprintf(stderr, "%s: inflate failed (%u byte input, %u byte pieces): %s\n", name,
+                        (unsigned)chunkSize, (unsigned)pieceSize, decoder.getError());
+                hostTestFailures++;
+                continue;
+            }
+            CHECK(frame == expected);
+        }
+    }
+    CHECK(decoder.getWidth() == DISPLAY_WIDTH && decoder.getHeight() == DISPLAY_HEIGHT);
+    CHECK(decoder.getCompressedSize() == binz.size());
+
+    double micros = medianMicros(BENCH_RUNS, [&]() {
+        inflate(binz, 1460, STREAM_CHUNK_SIZE, frame, decoder);
+    });
+    printf("%-16s %6u -> %6u bytes (%4.1f%%), %4u byte window: %7.1f us, %6.1f MB/s out\n", name,
+           (unsigned)binz.size(), (unsigned)FRAME_SIZE, 100.0 * binz.size() / FRAME_SIZE,
+           (unsigned)decoder.getWindowSize(), micros, megabytesPerSecond(FRAME_SIZE, micros));
+
+    // A changed frame hash in the header, a cut-off stream and a damaged
+    // header are all refused
+    std::vector<uint8_t> damaged = binz;
+    damaged[CompressedFrame::HEADER_SIZE - 1] ^= 0x01;
+    CHECK(!inflate(damaged, 1460, STREAM_CHUNK_SIZE, frame, decoder));
+
+    std::vector<uint8_t> truncated(binz.begin(), binz.begin() + binz.size() / 2);
+    CHECK(!inflate(truncated, 1460, STREAM_CHUNK_SIZE, frame, decoder));
+
+    damaged = binz;
+    damaged[0] ^= 0xFF;
+    CHECK(!inflate(damaged, 1460, STREAM_CHUNK_SIZE, frame, decoder));
+}
+
+int main() {
+    checkMap("Vienna_Austria");
+    checkMap("Shenzhen_China");
+    return hostTestResult("compressed_frame_test");
+}
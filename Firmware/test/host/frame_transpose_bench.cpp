@@ -0,0 +1,99 @@
+// FrameTranspose against a per-pixel rotation with the server's mapping,
+// landscape (x, y) = portrait (y, PORTRAIT_HEIGHT - 1 - x): byte-exact on
+// random frames and the checked-in maps, with MB/s of each.
+
+#include "host_test.h"
+#include "frame_transpose.h"
+#include <algorithm>
+#include <stdlib.h>
+
+#define BENCH_RUNS 50
+
+static const size_t FRAME_SIZE = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+
+static uint8_t getNibble(const uint8_t* frame, int stride, int x, int y) {
+    uint8_t packed = frame[y * stride + x / 2];
+    return (x % 2 == 0) ? (packed >> 4) : (packed & 0x0F);
+}
+
+static void setNibble(uint8_t* frame, int stride, int x, int y, uint8_t value) {
+    uint8_t& packed = frame[y * stride + x / 2];
+    packed = (x % 2 == 0) ? ((packed & 0x0F) | (value << 4)) : ((packed & 0xF0) | value);
+}
+
+static void rotatePerPixel(const uint8_t* portrait, uint8_t* landscape) {
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            setNibble(landscape, DISPLAY_WIDTH / 2, x, y,
+                      getNibble(portrait, PORTRAIT_WIDTH / 2, y, PORTRAIT_HEIGHT - 1 - x));
+        }
+    }
+}
+
+// Inverse mapping: the portrait frame a landscape .bin was rotated from
+static std::vector<uint8_t> toPortrait(const std::vector<uint8_t>& landscape) {
+    std::vector<uint8_t> portrait(FRAME_SIZE);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            setNibble(portrait.data(), PORTRAIT_WIDTH / 2, y, PORTRAIT_HEIGHT - 1 - x,
+                      getNibble(landscape.data(), DISPLAY_WIDTH / 2, x, y));
+        }
+    }
+    return portrait;
+}
+
+static void check(const char* name, const std::vector<uint8_t>& portrait, const std::vector<uint8_t>* expected) {
+    std::vector<uint8_t> reference(FRAME_SIZE), tiled(FRAME_SIZE), banded(FRAME_SIZE);
+
+    double perPixel = medianMicros(BENCH_RUNS, [&]() { rotatePerPixel(portrait.data(), reference.data()); });
+    double tiles = medianMicros(BENCH_RUNS, [&]() {
+        FrameTranspose::portraitToLandscape(portrait.data(), tiled.data());
+    });
+
+    // Band by band through one band buffer, as EPD7in3f::displayPortrait does
+    uint8_t band[FrameTranspose::BAND_SIZE];
+    double bands = medianMicros(BENCH_RUNS, [&]() {
+        for (int b = 0; b < FrameTranspose::BAND_COUNT; b++) {
+            FrameTranspose::portraitBand(portrait.data(), b, band);
+            std::copy(band, band + sizeof(band), banded.begin() + (size_t)b * sizeof(band));
+        }
+    });
+
+    CHECK(tiled == reference);
+    CHECK(banded == reference);
+    if (expected) CHECK(reference == *expected);
+
+    printf("%-14s per-pixel %7.1f MB/s (%6.1f us)   tiles %7.1f MB/s (%6.1f us)   bands %7.1f MB/s\n", name,
+           megabytesPerSecond(FRAME_SIZE, perPixel), perPixel, megabytesPerSecond(FRAME_SIZE, tiles), tiles,
+           megabytesPerSecond(FRAME_SIZE, bands));
+}
+
+int main() {
+    // Every nibble value in every position of a tile
+    std::vector<uint8_t> random(FRAME_SIZE);
+    srand(3);
+    for (uint8_t& byte : random) byte = rand() & 0xFF;
+    check("random", random, nullptr);
+
+    // Single tile: transposeTile must be its own inverse
+    uint32_t tile[FrameTranspose::TILE], original[FrameTranspose::TILE];
+    for (int r = 0; r < FrameTranspose::TILE; r++) original[r] = tile[r] = rand() * 2654435761u;
+    FrameTranspose::transposeTile(tile);
+    for (int r = 0; r < FrameTranspose::TILE; r++) {
+        for (int c = 0; c < FrameTranspose::TILE; c++) {
+            CHECK(((tile[r] >> (28 - 4 * c)) & 0xF) == ((original[c] >> (28 - 4 * r)) & 0xF));
+        }
+    }
+    FrameTranspose::transposeTile(tile);
+    CHECK(std::equal(tile, tile + FrameTranspose::TILE, original));
+
+    // The checked-in landscape maps come back from their portrait source
+    for (const char* name : {"Vienna_Austria", "Shenzhen_China"}) {
+        std::vector<uint8_t> landscape;
+        CHECK(readFile(mapPath(name, ".bin"), landscape));
+        if (landscape.size() != FRAME_SIZE) return hostTestResult("frame_transpose_bench");
+        check(name, toPortrait(landscape), &landscape);
+    }
+
+    return hostTestResult("frame_transpose_bench");
+}
@@ -0,0 +1,118 @@
+#include "host_test.h"
+#include <string.h>
+
+int hostTestFailures = 0;
+
+int hostTestResult(const char* name) {
+    if (hostTestFailures == 0) {
+        printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    printf("%s: %d check(s) failed\n", name, hostTestFailures);
+    return 1;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    data.clear();
+    uint8_t block[65536];
+    size_t got;
+    while ((got = fread(block, 1, sizeof(block), file)) > 0) {
+        data.insert(data.end(), block, block + got);
+    }
+    fclose(file);
+    return true;
+}
+
+bool writeFile(const std::string& path, const uint8_t* data, size_t length) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+    bool ok = fwrite(data, 1, length, file) == length;
+    fclose(file);
+    return ok;
+}
+
+std::string mapPath(const char* name, const char* extension) {
+    return std::string(HOST_TEST_MAPS_DIR) + "/" + name + extension;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void putBE32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    putBE32(out, data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putBE32(out, crc32(&out[start], out.size() - start));
+}
+
+bool writeFramePng(const std::string& path, const uint8_t* frame, int width, int height) {
+    static const uint8_t palette[8][3] = {
+        {0, 0, 0}, {255, 255, 255}, {67, 138, 28}, {100, 64, 255},
+        {191, 0, 0}, {255, 243, 56}, {232, 126, 0}, {194, 164, 244}
+    };
+
+    // Filter byte 0 per row, then the packed row as is: the panel layout is
+    // already a 4-bit indexed PNG row
+    int stride = (width + 1) / 2;
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)(stride + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), frame + (size_t)y * stride, frame + (size_t)(y + 1) * stride);
+    }
+
+    // zlib stream of stored blocks, good enough for inspection files
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    size_t offset = 0;
+    do {
+        size_t length = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+        zlib.push_back(offset + length == raw.size() ? 1 : 0);   // BFINAL on the last block
+        zlib.push_back(length & 0xFF);
+        zlib.push_back(length >> 8);
+        zlib.push_back(~length & 0xFF);
+        zlib.push_back((~length >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    } while (offset < raw.size());
+    putBE32(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    putBE32(header, width);
+    putBE32(header, height);
+    header.insert(header.end(), {4, 3, 0, 0, 0});   // 4-bit, indexed
+    putChunk(png, "IHDR", header);
+    putChunk(png, "PLTE", std::vector<uint8_t>(&palette[0][0], &palette[0][0] + sizeof(palette)));
+    putChunk(png, "IDAT", zlib);
+    putChunk(png, "IEND", std::vector<uint8_t>());
+    return writeFile(path, png.data(), png.size());
+}
@@ -0,0 +1,67 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Small helpers shared by the host test programs: checks that count
+// failures instead of aborting, wall-clock timing, file IO and a PNG writer
+// for inspecting packed 4bpp frames.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+extern int hostTestFailures;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+// Exit status for main(): prints a summary line
+int hostTestResult(const char* name);
+
+// Directory holding the checked-in maps (Server/Maps), set by CMake
+#ifndef HOST_TEST_MAPS_DIR
+#define HOST_TEST_MAPS_DIR "../../../Server/Maps"
+#endif
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data);
+bool writeFile(const std::string& path, const uint8_t* data, size_t length);
+
+// Path of a checked-in map file, e.g. mapPath("Vienna_Austria", ".bin")
+std::string mapPath(const char* name, const char* extension);
+
+// Packed 4bpp frame (left pixel in the upper nibble) as a 4-bit indexed PNG
+// with the panel palette of Server/utils/png_to_epaper_converter.py
+bool writeFramePng(const std::string& path, const uint8_t* frame, int width, int height);
+
+// Median microseconds of runs calls of fn
+template <typename Fn>
+double medianMicros(int runs, Fn fn) {
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    for (size_t i = 1; i < times.size(); i++) {
+        for (size_t j = i; j > 0 && times[j - 1] > times[j]; j--) {
+            double t = times[j];
+            times[j] = times[j - 1];
+            times[j - 1] = t;
+        }
+    }
+    return times[times.size() / 2];
+}
+
+// Throughput in MB/s for bytes processed in micros
+inline double megabytesPerSecond(size_t bytes, double micros) {
+    return micros > 0 ? bytes / micros * 1e6 / (1024.0 * 1024.0) : 0.0;
+}
+
+#endif // HOST_TEST_H
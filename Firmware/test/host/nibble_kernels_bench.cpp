@@ -0,0 +1,268 @@
+// NibbleKernels against per-pixel loops: span fills (via Framebuffer::fillRect),
+// span copies, keyed compositing of sprites and masked blends of 1bpp masks.
+// Spans start and end on odd and even nibbles and rows in every word phase;
+// the outputs must be byte-identical, the times are printed for comparison.
+
+#include "host_test.h"
+#include "framebuffer.h"
+#include "nibble_kernels.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_RUNS 20
+#define RANDOM_RECTS 2000
+
+struct Rect {
+    int x, y, w, h;
+    uint8_t color;
+};
+
+static void fillPerPixel(Framebuffer& fb, const Rect& r) {
+    for (int y = r.y; y < r.y + r.h; y++) {
+        for (int x = r.x; x < r.x + r.w; x++) {
+            fb.setPixel(x, y, r.color);
+        }
+    }
+}
+
+static uint8_t getNibble(const uint8_t* row, int x) {
+    return (x % 2 == 0) ? (row[x / 2] >> 4) : (row[x / 2] & 0x0F);
+}
+
+static void setNibble(uint8_t* row, int x, uint8_t value) {
+    uint8_t& packed = row[x / 2];
+    packed = (x % 2 == 0) ? ((packed & 0x0F) | (value << 4)) : ((packed & 0xF0) | value);
+}
+
+static void randomize(std::vector<uint8_t>& data) {
+    for (uint8_t& byte : data) byte = rand() & 0xFF;
+}
+
+// Random colors 0-7 with about half the pixels set to keyColor
+static void randomSprite(std::vector<uint8_t>& data, uint8_t keyColor) {
+    for (uint8_t& byte : data) {
+        uint8_t upper = rand() % 2 ? keyColor : rand() % 8;
+        uint8_t lower = rand() % 2 ? keyColor : rand() % 8;
+        byte = (upper << 4) | lower;
+    }
+}
+
+static void compare(const char* name, const std::vector<Rect>& rects) {
+    size_t size = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+    std::vector<uint8_t> reference(size, 0x11), kernel(size, 0x11);
+    Framebuffer referenceFb(reference.data()), kernelFb(kernel.data());
+
+    double perPixel = medianMicros(BENCH_RUNS, [&]() {
+        for (const Rect& r : rects) fillPerPixel(referenceFb, r);
+    });
+    double words = medianMicros(BENCH_RUNS, [&]() {
+        for (const Rect& r : rects) kernelFb.fillRect(r.x, r.y, r.w, r.h, r.color);
+    });
+
+    printf("%-24s per-pixel %9.1f us   word kernel %8.1f us   x%.1f\n", name, perPixel, words,
+           words > 0 ? perPixel / words : 0.0);
+    CHECK(reference == kernel);
+}
+
+// copySpan and compositeSpan on rows whose buffers start at every byte
+// offset within a word, with spans starting and ending on both nibbles
+static void checkSpans() {
+    const int width = 96;
+    for (int dstPhase = 0; dstPhase < 4; dstPhase++) {
+        for (int srcPhase = 0; srcPhase < 4; srcPhase++) {
+            for (int trial = 0; trial < 200; trial++) {
+                std::vector<uint8_t> dstStore(width / 2 + 8), srcStore(width / 2 + 8);
+                randomize(dstStore);
+                randomSprite(srcStore, EPD_7IN3F_CLEAN);
+                uint8_t* dst = dstStore.data() + dstPhase;
+                const uint8_t* src = srcStore.data() + srcPhase;
+                int x0 = rand() % width;
+                int x1 = x0 + rand() % (width - x0 + 1);
+
+                std::vector<uint8_t> expected(dst, dst + width / 2), copied = expected, composited = expected;
+                for (int x = x0; x < x1; x++) setNibble(expected.data(), x, getNibble(src, x));
+                NibbleKernels::copySpan(copied.data(), src, x0, x1);
+                memcpy(dst, copied.data(), copied.size());
+                CHECK(std::equal(expected.begin(), expected.end(), dst));
+
+                // Keyed: only the non-key sprite pixels replace the row
+                memcpy(dst, composited.data(), composited.size());
+                expected = composited;
+                for (int x = x0; x < x1; x++) {
+                    if (getNibble(src, x) != EPD_7IN3F_CLEAN) setNibble(expected.data(), x, getNibble(src, x));
+                }
+                NibbleKernels::compositeSpan(dst, src, x0, x1, EPD_7IN3F_CLEAN);
+                CHECK(std::equal(expected.begin(), expected.end(), dst));
+            }
+        }
+    }
+
+    // opaqueMask flags exactly the nibbles that differ from the key
+    for (int key = 0; key < 16; key++) {
+        for (int value = 0; value < 16; value++) {
+            uint32_t word = NibbleKernels::replicate(value) & 0x0F0F0F0Fu;
+            word |= NibbleKernels::replicate(key) & 0xF0F0F0F0u;
+            uint32_t expected = (value != key) ? 0x0F0F0F0Fu : 0;
+            CHECK(NibbleKernels::opaqueMask(word, NibbleKernels::replicate(key)) == expected);
+        }
+    }
+}
+
+// Framebuffer::composite at aligned, even, odd and off-frame positions, and
+// drawMask (blendWords) with masks at every pixel phase, clipped at the edges
+static void checkSprites() {
+    size_t size = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+    std::vector<uint8_t> background(size);
+    randomize(background);
+
+    const int spriteWidth = 72, spriteHeight = 40;
+    std::vector<uint8_t> spritePixels(spriteWidth / 2 * spriteHeight);
+    randomSprite(spritePixels, EPD_7IN3F_CLEAN);
+    Framebuffer sprite(spritePixels.data(), spriteWidth, spriteHeight);
+
+    const int maskWidth = 21, maskHeight = 13;
+    std::vector<uint8_t> mask((maskWidth + 7) / 8 * maskHeight);
+    randomize(mask);
+
+    const int positions[][2] = {
+        {0, 0}, {64, 40}, {66, 41}, {67, 3}, {1, 1}, {-9, -5}, {-8, 10}, {-10, 470},
+        {DISPLAY_WIDTH - 30, 100}, {DISPLAY_WIDTH - 31, 200}, {DISPLAY_WIDTH - 8, DISPLAY_HEIGHT - 4},
+    };
+    for (const auto& position : positions) {
+        int px = position[0], py = position[1];
+
+        std::vector<uint8_t> expected = background, frame = background;
+        for (int y = 0; y < spriteHeight; y++) {
+            for (int x = 0; x < spriteWidth; x++) {
+                int fx = px + x, fy = py + y;
+                uint8_t pixel = getNibble(spritePixels.data() + y * spriteWidth / 2, x);
+                if (fx < 0 || fx >= DISPLAY_WIDTH || fy < 0 || fy >= DISPLAY_HEIGHT || pixel == EPD_7IN3F_CLEAN) continue;
+                setNibble(expected.data() + (size_t)fy * (DISPLAY_WIDTH / 2), fx, pixel);
+            }
+        }
+        Framebuffer fb(frame.data());
+        fb.composite(sprite, px, py, EPD_7IN3F_CLEAN);
+        if (frame != expected) {
+            fprintf(stderr, "composite at (%d, %d) differs from the per-pixel result\n", px, py);
+            hostTestFailures++;
+        }
+
+        expected = background;
+        frame = background;
+        int rowBytes = (maskWidth + 7) / 8;
+        for (int y = 0; y < maskHeight; y++) {
+            for (int x = 0; x < maskWidth; x++) {
+                int fx = px + x, fy = py + y;
+                if (!(mask[y * rowBytes + x / 8] & (1 << (x % 8)))) continue;
+                if (fx < 0 || fx >= DISPLAY_WIDTH || fy < 0 || fy >= DISPLAY_HEIGHT) continue;
+                setNibble(expected.data() + (size_t)fy * (DISPLAY_WIDTH / 2), fx, EPD_7IN3F_RED);
+            }
+        }
+        fb.drawMask(px, py, maskWidth, maskHeight, mask.data(), EPD_7IN3F_RED);
+        if (frame != expected) {
+            fprintf(stderr, "drawMask at (%d, %d) differs from the per-pixel result\n", px, py);
+            hostTestFailures++;
+        }
+    }
+
+    // Inside a viewport the position is local and the clip rect applies
+    std::vector<uint8_t> expected = background, frame = background;
+    Framebuffer reference(expected.data()), fb(frame.data());
+    reference.pushViewport(101, 50, 40, 30);
+    fb.pushViewport(101, 50, 40, 30);
+    for (int y = 0; y < spriteHeight; y++) {
+        for (int x = 0; x < spriteWidth; x++) {
+            uint8_t pixel = getNibble(spritePixels.data() + y * spriteWidth / 2, x);
+            if (pixel != EPD_7IN3F_CLEAN) reference.setPixel(x - 5, y - 3, pixel);
+        }
+    }
+    fb.composite(sprite, -5, -3, EPD_7IN3F_CLEAN);
+    CHECK(frame == expected);
+}
+
+// Full-frame keyed composite and copy: word kernels against per-pixel loops
+static void benchComposite() {
+    size_t size = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+    std::vector<uint8_t> background(size), overlay(size), reference, kernel;
+    randomize(background);
+    // Mostly transparent with opaque blocks, like an overlay of badges and text
+    for (size_t i = 0; i < size; i++) {
+        overlay[i] = (i / 64) % 8 == 0 ? (rand() % 7) * 0x11 : EPD_7IN3F_CLEAN * 0x11;
+    }
+    Framebuffer overlayFb(overlay.data());
+
+    double perPixel = medianMicros(BENCH_RUNS, [&]() {
+        reference = background;
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                uint8_t pixel = getNibble(overlay.data() + (size_t)y * (DISPLAY_WIDTH / 2), x);
+                if (pixel != EPD_7IN3F_CLEAN) setNibble(reference.data() + (size_t)y * (DISPLAY_WIDTH / 2), x, pixel);
+            }
+        }
+    });
+    double words = medianMicros(BENCH_RUNS, [&]() {
+        kernel = background;
+        Framebuffer fb(kernel.data());
+        fb.composite(overlayFb, 0, 0, EPD_7IN3F_CLEAN);
+    });
+    printf("%-24s per-pixel %9.1f us   word kernel %8.1f us   x%.1f\n", "keyed composite", perPixel, words,
+           words > 0 ? perPixel / words : 0.0);
+    CHECK(reference == kernel);
+
+    perPixel = medianMicros(BENCH_RUNS, [&]() {
+        reference = background;
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+            for (int x = 1; x < DISPLAY_WIDTH - 1; x++) {
+                setNibble(reference.data() + (size_t)y * (DISPLAY_WIDTH / 2), x,
+                          getNibble(overlay.data() + (size_t)y * (DISPLAY_WIDTH / 2), x));
+            }
+        }
+    });
+    words = medianMicros(BENCH_RUNS, [&]() {
+        kernel = background;
+        Framebuffer fb(kernel.data());
+        fb.copyRect(overlayFb, 1, 0, DISPLAY_WIDTH - 2, DISPLAY_HEIGHT);
+    });
+    printf("%-24s per-pixel %9.1f us   word kernel %8.1f us   x%.1f\n", "rect copy", perPixel, words,
+           words > 0 ? perPixel / words : 0.0);
+    CHECK(reference == kernel);
+}
+
+int main() {
+    compare("full-frame fill", {{0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, EPD_7IN3F_BLUE}});
+
+    // Odd and even edges, partly off-screen, every color
+    std::vector<Rect> rects;
+    srand(1);
+    for (int i = 0; i < RANDOM_RECTS; i++) {
+        rects.push_back({rand() % (DISPLAY_WIDTH + 40) - 20, rand() % (DISPLAY_HEIGHT + 40) - 20,
+                         rand() % 120, rand() % 40, (uint8_t)(rand() % 8)});
+    }
+    compare("random rects", rects);
+
+    // Narrow spans as drawn by text and the QR modules
+    std::vector<Rect> spans;
+    for (int i = 0; i < RANDOM_RECTS; i++) {
+        spans.push_back({rand() % DISPLAY_WIDTH, rand() % DISPLAY_HEIGHT, 1 + rand() % 16, 1 + rand() % 2,
+                         (uint8_t)(rand() % 8)});
+    }
+    compare("short spans", spans);
+
+    // pixelMask table against the nibble layout: even pixels in the upper nibble
+    for (int bits = 0; bits < 256; bits++) {
+        uint8_t row[4] = {0, 0, 0, 0};
+        for (int pixel = 0; pixel < 8; pixel++) {
+            if (bits & (1 << pixel)) row[pixel / 2] |= (pixel % 2 == 0) ? 0xF0 : 0x0F;
+        }
+        uint32_t expected;
+        memcpy(&expected, row, sizeof(expected));
+        CHECK(NibbleKernels::pixelMask(bits) == expected);
+    }
+
+    checkSpans();
+    checkSprites();
+    benchComposite();
+
+    return hostTestResult("nibble_kernels_bench");
+}
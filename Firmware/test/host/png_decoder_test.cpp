@@ -0,0 +1,115 @@
+// PngStreamDecoder (and the InflateStream under it) on the checked-in
+// *_epd.png maps, fed in input pieces from 1 byte up to the whole file as a
+// TCP stream would deliver them: the decoded portrait frame, rotated to the
+// panel, must equal the matching .bin. Also round trips indexed PNGs and
+// checks that damaged files are refused.
+
+#include "host_test.h"
+#include "png_decoder.h"
+#include "frame_transpose.h"
+#include <string.h>
+
+#define BENCH_RUNS 10
+
+static const size_t FRAME_SIZE = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+
+struct ChunkedInput {
+    const std::vector<uint8_t>* data;
+    size_t position;
+    size_t chunkSize;
+};
+
+static size_t readChunked(void* context, uint8_t* buffer, size_t length) {
+    ChunkedInput* input = static_cast<ChunkedInput*>(context);
+    size_t available = input->data->size() - input->position;
+    if (length > input->chunkSize) length = input->chunkSize;
+    if (length > available) length = available;
+    memcpy(buffer, input->data->data() + input->position, length);
+    input->position += length;
+    return length;
+}
+
+struct FrameOutput {
+    std::vector<uint8_t>* frame;
+    int rows;
+};
+
+static bool storeRow(void* context, int row, const uint8_t* packedRow, size_t length) {
+    FrameOutput* output = static_cast<FrameOutput*>(context);
+    size_t offset = (size_t)row * length;
+    if (offset + length > output->frame->size()) return false;
+    memcpy(output->frame->data() + offset, packedRow, length);
+    output->rows++;
+    return true;
+}
+
+static bool decode(const std::vector<uint8_t>& png, size_t chunkSize, std::vector<uint8_t>& frame,
+                   int& width, int& height, bool expectFailure = false) {
+    PngStreamDecoder decoder;
+    ChunkedInput input = {&png, 0, chunkSize};
+    frame.assign(FRAME_SIZE, 0xFF);
+    FrameOutput output = {&frame, 0};
+    bool ok = decoder.decode(readChunked, &input, storeRow, &output);
+    width = decoder.getWidth();
+    height = decoder.getHeight();
+    if (!ok && !expectFailure) fprintf(stderr, "decode failed: %s\n", decoder.getError());
+    return ok && output.rows == height;
+}
+
+static void checkMap(const char* name) {
+    std::vector<uint8_t> png, expected;
+    CHECK(readFile(mapPath(name, "_epd.png"), png));
+    CHECK(readFile(mapPath(name, ".bin"), expected));
+    if (png.empty() || expected.size() != FRAME_SIZE) return;
+
+    for (size_t chunkSize : {(size_t)1, (size_t)7, (size_t)256, (size_t)1460, (size_t)4096, png.size()}) {
+        std::vector<uint8_t> portrait, landscape(FRAME_SIZE);
+        int width = 0, height = 0;
+        CHECK(decode(png, chunkSize, portrait, width, height));
+        CHECK(width == PORTRAIT_WIDTH && height == PORTRAIT_HEIGHT);
+        FrameTranspose::portraitToLandscape(portrait.data(), landscape.data());
+        if (landscape != expected) {
+            fprintf(stderr, "%s: frame differs from .bin with %u byte input pieces\n", name, (unsigned)chunkSize);
+            hostTestFailures++;
+        }
+    }
+
+    std::vector<uint8_t> portrait;
+    int width, height;
+    double micros = medianMicros(BENCH_RUNS, [&]() { decode(png, 1460, portrait, width, height); });
+    printf("%-16s %7u byte PNG: %8.1f us, %6.1f MB/s decoded\n", name, (unsigned)png.size(), micros,
+           megabytesPerSecond(FRAME_SIZE, micros));
+
+    // A flipped bit in the image data fails the chunk CRC or the inflate
+    std::vector<uint8_t> damaged = png;
+    damaged[damaged.size() / 2] ^= 0x40;
+    CHECK(!decode(damaged, 1460, portrait, width, height, true));
+
+    // So does a file cut short
+    std::vector<uint8_t> truncated(png.begin(), png.begin() + png.size() / 3);
+    CHECK(!decode(truncated, 1460, portrait, width, height, true));
+}
+
+int main() {
+    checkMap("Vienna_Austria");
+    checkMap("Shenzhen_China");
+
+    // 4-bit indexed PNG in panel palette order with all seven colors in both nibbles
+    std::vector<uint8_t> frame(FRAME_SIZE);
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = (((i / 240) % 7) << 4) | ((i / 3) % 7);
+    }
+    std::string path = "png_decoder_test_indexed.png";
+    CHECK(writeFramePng(path, frame.data(), DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    std::vector<uint8_t> png, decoded;
+    CHECK(readFile(path, png));
+    int width = 0, height = 0;
+    for (size_t chunkSize : {(size_t)1, (size_t)33, png.size()}) {
+        CHECK(decode(png, chunkSize, decoded, width, height));
+        CHECK(width == DISPLAY_WIDTH && height == DISPLAY_HEIGHT);
+        CHECK(decoded == frame);
+    }
+    remove(path.c_str());
+
+    return hostTestResult("png_decoder_test");
+}
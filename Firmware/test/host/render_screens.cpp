@@ -0,0 +1,89 @@
+// Renders the firmware's built-in screens off-device, checks each against its
+// golden FNV-1a hash (the value DisplayHandler logs on the device), reports
+// the rasterisation time and optionally writes every screen as a PNG.
+//
+// Usage: render_screens [png-output-dir]
+
+#include "host_test.h"
+#include "framebuffer.h"
+#include "screen_renderer.h"
+#include <functional>
+#include <string.h>
+
+#define RENDER_RUNS 50
+
+struct Screen {
+    const char* name;
+    uint32_t goldenHash;
+    std::function<void(Framebuffer&)> render;
+    bool portrait;              // 480x800 frame, as the widget base map
+};
+
+int main(int argc, char** argv) {
+    const char* outputDir = argc > 1 ? argv[1] : nullptr;
+
+    // Battery overlays are drawn on a white frame, as over a blank image
+    auto battery = [](int percentage) {
+        return [percentage](Framebuffer& fb) {
+            fb.clear(EPD_7IN3F_WHITE);
+            ScreenRenderer::renderBatteryOverlay(fb, percentage);
+        };
+    };
+
+    // Weather widgets over a green base map, so that any pixel the icon
+    // sprite wrongly writes or drops shows up
+    auto widget = [](const char* icon) {
+        return [icon](Framebuffer& fb) {
+            WidgetData data = {};
+            strcpy(data.city, "Vienna");
+            strcpy(data.country, "Austria");
+            data.latitude = 48.2082f;
+            data.longitude = 16.3738f;
+            strcpy(data.date, "18 October");
+            strcpy(data.time, "14:30");
+            data.hasWeather = true;
+            data.temperature = 17;
+            strcpy(data.icon, icon);
+            fb.clear(EPD_7IN3F_GREEN);
+            ScreenRenderer::renderWeatherWidget(fb, data);
+        };
+    };
+
+    const Screen screens[] = {
+        {"configuration_qr", 0x6AD59E09, ScreenRenderer::renderConfigurationQR, false},
+        {"simple_message", 0x556A0C01, [](Framebuffer& fb) {
+            ScreenRenderer::renderSimpleMessage(fb, "Config Server Failed");
+        }, false},
+        {"battery_5", 0x91B5C114, battery(5), false},
+        {"battery_42", 0xFBDE805C, battery(42), false},
+        {"battery_100", 0x8EA2519C, battery(100), false},
+        {"color_test", 0x4DC4E0C5, ScreenRenderer::renderColorTest, false},
+        {"widget_clear_day", 0x72976BE9, widget("01d"), true},
+        {"widget_clear_night", 0x5E4EBD65, widget("01n"), true},
+        {"widget_few_clouds", 0xF694FA60, widget("02d"), true},
+        {"widget_clouds", 0x49336F29, widget("04d"), true},
+        {"widget_rain", 0x2FD9859D, widget("10d"), true},
+        {"widget_thunderstorm", 0xAF20031C, widget("11d"), true},
+        {"widget_snow", 0x0897B993, widget("13d"), true},
+        {"widget_mist", 0x179A0E20, widget("50d"), true},
+    };
+
+    std::vector<uint8_t> buffer((size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2);
+    for (const Screen& screen : screens) {
+        Framebuffer fb(buffer.data(), screen.portrait ? DISPLAY_HEIGHT : DISPLAY_WIDTH,
+                       screen.portrait ? DISPLAY_WIDTH : DISPLAY_HEIGHT);
+        double micros = medianMicros(RENDER_RUNS, [&]() { screen.render(fb); });
+        uint32_t hash = fb.hash();
+
+        printf("%-18s %8.1f us  hash 0x%08X%s\n", screen.name, micros, hash,
+               hash == screen.goldenHash ? "" : "  (golden mismatch)");
+        CHECK(hash == screen.goldenHash);
+
+        if (outputDir) {
+            std::string path = std::string(outputDir) + "/" + screen.name + ".png";
+            CHECK(writeFramePng(path, fb.getBuffer(), fb.getWidth(), fb.getHeight()));
+        }
+    }
+
+    return hostTestResult("render_screens");
+}
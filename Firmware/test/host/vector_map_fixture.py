@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+Writes .vmap files for vector_map_test together with the frames the reference
+rasteriser in Server/utils/vector_map_encoder.py draws from them.
+
+The features are synthetic (no Mapbox access needed) but go through the same
+VectorMapEncoder.encode() path as real maps: every style layer, polygons with
+holes and self-intersections, parts crossing the view edges, horizontal,
+vertical and diagonal lines of every width, at several precisions.
+
+Usage: python vector_map_fixture.py <output-dir>
+  -> <output-dir>/vector_map_p<bits>.vmap and .bin (packed 4bpp, 800x480)
+"""
+
+import math
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..', 'Server', 'utils'))
+
+from vector_map_encoder import LAYER_FILL, PANEL_HEIGHT, PANEL_WIDTH, VectorMapEncoder, rasterise_vector_map
+
+PRECISIONS = (0, 1, 4)
+
+
+def _polygon(rng, cx, cy, radius, points):
+    return [(cx + radius * rng.uniform(0.4, 1.0) * math.cos(2 * math.pi * i / points),
+             cy + radius * rng.uniform(0.4, 1.0) * math.sin(2 * math.pi * i / points))
+            for i in range(points)]
+
+
+def _polyline(rng, width, height, margin, points):
+    x, y = rng.uniform(-margin, width + margin), rng.uniform(-margin, height + margin)
+    line = [(x, y)]
+    for _ in range(points - 1):
+        step = rng.choice(('horizontal', 'vertical', 'diagonal'))
+        length = rng.uniform(2, 120)
+        angle = rng.uniform(0, 2 * math.pi)
+        if step == 'horizontal':
+            x += length * rng.choice((-1, 1))
+        elif step == 'vertical':
+            y += length * rng.choice((-1, 1))
+        else:
+            x += length * math.cos(angle)
+            y += length * math.sin(angle)
+        line.append((x, y))
+    return line
+
+
+def build_encoder(precision_bits, seed=26):
+    """Encoder filled with synthetic features in portrait view coordinates."""
+    rng = random.Random(seed)
+    encoder = VectorMapEncoder(48.2082, 16.3738, 14, precision_bits=precision_bits)
+    width, height, margin = encoder.width, encoder.height, encoder.margin
+
+    for index, (_, _, _, kind, _, _) in enumerate(encoder.style_layers):
+        features = encoder.layers[index]
+        if kind == LAYER_FILL:
+            # Ring with a hole, a self-intersecting star and random blobs,
+            # some crossing the view edges
+            features.append([[(40, 60), (300, 60), (300, 400), (40, 400)],
+                             [(100, 120), (220, 120), (220, 300), (100, 300)]])
+            features.append([[(240 + 150 * math.cos(4 * math.pi * i / 5), 600 + 150 * math.sin(4 * math.pi * i / 5))
+                              for i in range(5)]])
+            for _ in range(40):
+                cx = rng.uniform(-margin, width + margin)
+                cy = rng.uniform(-margin, height + margin)
+                features.append([_polygon(rng, cx, cy, rng.uniform(3, 90), rng.randint(3, 40))])
+        else:
+            for _ in range(30):
+                features.append([_polyline(rng, width, height, margin, rng.randint(2, 12))])
+    return encoder
+
+
+def pack_rows(rows):
+    """Panel color rows as a packed 4bpp frame, left pixel in the upper nibble."""
+    packed = bytearray()
+    for row in rows:
+        for x in range(0, len(row), 2):
+            packed.append((row[x] << 4) | row[x + 1])
+    return bytes(packed)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: python vector_map_fixture.py <output-dir>")
+        return 1
+
+    os.makedirs(sys.argv[1], exist_ok=True)
+    for bits in PRECISIONS:
+        data = build_encoder(bits).encode()
+        frame = pack_rows(rasterise_vector_map(data))
+        assert len(frame) == PANEL_WIDTH * PANEL_HEIGHT // 2
+
+        base = os.path.join(sys.argv[1], f"vector_map_p{bits}")
+        with open(base + '.vmap', 'wb') as f:
+            f.write(data)
+        with open(base + '.bin', 'wb') as f:
+            f.write(frame)
+        print(f"{base}.vmap: {len(data)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
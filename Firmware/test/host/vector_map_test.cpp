@@ -0,0 +1,88 @@
+// VectorMap::renderBand against the reference rasteriser in
+// Server/utils/vector_map_encoder.py: vector_map_fixture.py writes .vmap files
+// and the frames the Python rasteriser draws from them, and every band height
+// the device could use must reproduce those frames pixel for pixel.
+//
+// Usage: vector_map_test <fixture-dir>
+
+#include "host_test.h"
+#include "vector_map.h"
+#include <string.h>
+
+#define BENCH_RUNS 10
+
+static const size_t FRAME_SIZE = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+
+// Render the map band by band into a full frame, as DisplayHandler streams it
+static void renderFrame(const VectorMap& map, int bandRows, std::vector<uint8_t>& frame) {
+    std::vector<uint8_t> band((size_t)bandRows * (DISPLAY_WIDTH / 2));
+    frame.assign(FRAME_SIZE, 0xFF);
+    for (int top = 0; top < DISPLAY_HEIGHT; top += bandRows) {
+        int rows = DISPLAY_HEIGHT - top < bandRows ? DISPLAY_HEIGHT - top : bandRows;
+        Framebuffer fb(band.data(), DISPLAY_WIDTH, rows);
+        map.renderBand(fb, top);
+        memcpy(frame.data() + (size_t)top * (DISPLAY_WIDTH / 2), band.data(), (size_t)rows * (DISPLAY_WIDTH / 2));
+    }
+}
+
+static size_t countDifferences(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int& firstRow) {
+    size_t differences = 0;
+    firstRow = -1;
+    for (size_t i = 0; i < a.size(); i++) {
+        uint8_t diff = a[i] ^ b[i];
+        if (!diff) continue;
+        differences += ((diff & 0xF0) != 0) + ((diff & 0x0F) != 0);
+        if (firstRow < 0) firstRow = i / (DISPLAY_WIDTH / 2);
+    }
+    return differences;
+}
+
+static void checkMap(const std::string& base) {
+    std::vector<uint8_t> data, expected;
+    CHECK(readFile(base + ".vmap", data));
+    CHECK(readFile(base + ".bin", expected));
+    if (data.empty() || expected.size() != FRAME_SIZE) return;
+
+    VectorMap map;
+    if (!map.load(data.data(), data.size())) {
+        fprintf(stderr, "%s.vmap: %s\n", base.c_str(), map.getError());
+        hostTestFailures++;
+        return;
+    }
+    CHECK(map.getWidth() == DISPLAY_WIDTH && map.getHeight() == DISPLAY_HEIGHT);
+
+    std::vector<uint8_t> frame;
+    for (int bandRows : {DISPLAY_HEIGHT, (int)VectorMap::BAND_ROWS, 7, 1}) {
+        renderFrame(map, bandRows, frame);
+        int firstRow;
+        size_t differences = countDifferences(frame, expected, firstRow);
+        if (differences) {
+            fprintf(stderr, "%s: %u pixels differ from the reference with %d-row bands (first in row %d)\n",
+                    base.c_str(), (unsigned)differences, bandRows, firstRow);
+            hostTestFailures++;
+        }
+    }
+
+    double micros = medianMicros(BENCH_RUNS, [&]() { renderFrame(map, VectorMap::BAND_ROWS, frame); });
+    printf("%-24s %6u bytes, %3d layers, %5u points: %8.1f us in %d-row bands\n",
+           base.substr(base.find_last_of('/') + 1).c_str(), (unsigned)data.size(), map.getLayerCount(),
+           (unsigned)map.getPointCount(), micros, VectorMap::BAND_ROWS);
+
+    // Damaged payloads are refused by the hash check
+    data[data.size() / 2] ^= 0x01;
+    VectorMap damaged;
+    CHECK(!damaged.load(data.data(), data.size()));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: vector_map_test <fixture-dir>\n");
+        return 1;
+    }
+
+    for (const char* name : {"vector_map_p0", "vector_map_p1", "vector_map_p4"}) {
+        checkMap(std::string(argv[1]) + "/" + name);
+    }
+
+    return hostTestResult("vector_map_test");
+}
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""
+Writes the widget assets of a checked-in map for widget_base_test: the
+base map (*_base_epd.png) and the widget document whose base_hash the device
+checks the decoded base map against, both from
+Server/utils/widget_exporter.py.
+
+The checked-in 480x800 map PNG stands in for the base map; the exporter
+converts them exactly as it converts a map without its information overlay.
+
+Usage: python widget_base_fixture.py <output-dir>
+  -> <output-dir>/<map>_base_epd.png and <map>_widgets.json
+"""
+
+import os
+import sys
+
+SERVER_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..', 'Server')
+sys.path.insert(0, SERVER_DIR)
+
+from PIL import Image
+
+from utils.widget_exporter import export_widget_assets
+
+# One map: the exporter's dithering takes ~20 s per map in Python
+MAPS = (('Vienna_Austria', 'Vienna', 'Austria', 48.2082, 16.3738),)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: python widget_base_fixture.py <output-dir>")
+        return 1
+
+    os.makedirs(sys.argv[1], exist_ok=True)
+    for name, city, country, lat, lng in MAPS:
+        image = Image.open(os.path.join(SERVER_DIR, 'Maps', name + '.png')).convert('RGB')
+        if not export_widget_assets(image, os.path.join(sys.argv[1], name), city, country, lat, lng,
+                                    '2026-01-01', '12:00'):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+// The base map of the LOCAL_WIDGETS path as GitHubImageFetcher::fetchWidgetFrame
+// gets it: *_base_epd.png decoded without rotation must be a portrait frame
+// whose Framebuffer::hash is the base_hash widget_exporter.py published,
+// since the device refuses and never caches a base map that does not match.
+//
+// Usage: widget_base_test <fixture-dir>
+
+#include "host_test.h"
+#include "png_decoder.h"
+#include "frame_transpose.h"
+#include "framebuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t FRAME_SIZE = (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT / 2;
+
+struct MemoryInput {
+    const std::vector<uint8_t>* data;
+    size_t position;
+};
+
+static size_t readMemory(void* context, uint8_t* buffer, size_t length) {
+    MemoryInput* input = static_cast<MemoryInput*>(context);
+    size_t available = input->data->size() - input->position;
+    if (length > available) length = available;
+    memcpy(buffer, input->data->data() + input->position, length);
+    input->position += length;
+    return length;
+}
+
+static bool storeRow(void* context, int row, const uint8_t* packedRow, size_t length) {
+    std::vector<uint8_t>* frame = static_cast<std::vector<uint8_t>*>(context);
+    size_t offset = (size_t)row * length;
+    if (offset + length > frame->size()) return false;
+    memcpy(frame->data() + offset, packedRow, length);
+    return true;
+}
+
+// "base_hash" of the widget document; the firmware parses it with ArduinoJson
+static bool readBaseHash(const std::string& path, uint32_t& hash) {
+    std::vector<uint8_t> json;
+    if (!readFile(path, json)) return false;
+    std::string text(json.begin(), json.end());
+    size_t at = text.find("\"base_hash\":");
+    if (at == std::string::npos) return false;
+    hash = (uint32_t)strtoul(text.c_str() + at + 12, nullptr, 10);
+    return true;
+}
+
+static void checkMap(const std::string& base) {
+    std::vector<uint8_t> png;
+    uint32_t baseHash = 0;
+    CHECK(readFile(base + "_base_epd.png", png));
+    CHECK(readBaseHash(base + "_widgets.json", baseHash));
+    if (png.empty()) return;
+
+    PngStreamDecoder decoder;
+    MemoryInput input = {&png, 0};
+    std::vector<uint8_t> frame(FRAME_SIZE);
+    if (!decoder.decode(readMemory, &input, storeRow, &frame)) {
+        fprintf(stderr, "%s_base_epd.png: %s\n", base.c_str(), decoder.getError());
+        hostTestFailures++;
+        return;
+    }
+    CHECK(decoder.getWidth() == PORTRAIT_WIDTH && decoder.getHeight() == PORTRAIT_HEIGHT);
+
+    uint32_t hash = Framebuffer::hash(frame.data(), frame.size());
+    if (hash != baseHash) {
+        fprintf(stderr, "%s: base map hash 0x%08X, widget document says 0x%08X\n", base.c_str(), hash, baseHash);
+        hostTestFailures++;
+    }
+
+    // Rotated to the panel, as frames are, it would be refused
+    std::vector<uint8_t> landscape(FRAME_SIZE);
+    FrameTranspose::portraitToLandscape(frame.data(), landscape.data());
+    CHECK(Framebuffer::hash(landscape.data(), landscape.size()) != baseHash);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: widget_base_test <fixture-dir>\n");
+        return 1;
+    }
+
+    checkMap(std::string(argv[1]) + "/Vienna_Austria");
+    return hostTestResult("widget_base_test");
+}
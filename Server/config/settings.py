@@ -59,6 +59,15 @@ class DisplayConfig:
 
 
 
+# Publishing Configuration
+class PublishConfig:
+    """When devices can expect the next maps"""
+    
+    # Minutes between map generation runs (generate-maps workflow schedule);
+    # published as next_update in the frame manifest
+    UPDATE_INTERVAL_MINUTES = int(os.getenv('MAP_UPDATE_INTERVAL_MINUTES', '30'))
+
+
 # File Paths Configuration
 class PathConfig:
     """File and directory paths"""
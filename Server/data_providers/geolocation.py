@@ -230,12 +230,13 @@ class GeolocationProvider:
         except Exception as e:
             raise Exception(f"Failed to get location data for {city}, {country}: {e}")
 
-    def get_local_datetime(self, timezone_name: str) -> Tuple[str, str]:
+    def get_local_datetime(self, timezone_name: str, timestamp: Optional[float] = None) -> Tuple[str, str]:
         """
         Get formatted local date and time for a timezone.
         
         Args:
             timezone_name: Timezone name (e.g., 'Europe/Vienna')
+            timestamp: Unix time to format instead of now (future frames)
             
         Returns:
             Tuple of (date_string, time_string)
@@ -243,7 +244,10 @@ class GeolocationProvider:
         try:
             # Use pytz for timezone handling
             timezone = pytz.timezone(timezone_name)
-            local_time = datetime.now(timezone)
+            if timestamp is None:
+                local_time = datetime.now(timezone)
+            else:
+                local_time = datetime.fromtimestamp(timestamp, timezone)
 
             # Format: "03 August" instead of "03/01/2025"
             date_str = local_time.strftime("%d %B")
@@ -254,7 +258,7 @@ class GeolocationProvider:
         except Exception as e:
             print(f"⚠️  Could not get local time for {timezone_name}: {e}")
             # Fallback to UTC
-            utc_time = datetime.utcnow()
+            utc_time = datetime.utcnow() if timestamp is None else datetime.utcfromtimestamp(timestamp)
             date_str = utc_time.strftime("%d %B")
             time_str = utc_time.strftime("%H:%M")
             return date_str, time_str
@@ -8,7 +8,7 @@ Handles fetching weather data from OpenWeatherMap API and downloading weather ic
 import requests
 import io
 import os
-from typing import Optional, Dict
+from typing import Optional, Dict, List
 from PIL import Image
 
 # Import configuration
@@ -21,6 +21,7 @@ class WeatherProvider:
     
     Features:
     - Current weather data fetching
+    - 3-hourly forecast for pre-rendered future frames
     - Weather icon downloading
     - Temperature in Celsius
     - Error handling and fallbacks
@@ -37,6 +38,7 @@ class WeatherProvider:
         self.api_key = api_key
         self.icons_dir = icons_dir or PathConfig.WEATHER_ICONS_FOLDER
         self.weather_url = "http://api.openweathermap.org/data/2.5/weather"
+        self.forecast_url = "http://api.openweathermap.org/data/2.5/forecast"
         
         # Verify icons directory exists
         if not os.path.exists(self.icons_dir):
@@ -113,6 +115,46 @@ class WeatherProvider:
             print(f"⚠️  Could not fetch weather data: {e}")
             return None
 
+    def get_forecast(self, lat: float, lng: float) -> List[Dict]:
+        """
+        Get the 3-hourly weather forecast for coordinates (next five days).
+
+        Args:
+            lat: Latitude
+            lng: Longitude
+
+        Returns:
+            List of weather dictionaries with a 'timestamp' (Unix, UTC) each,
+            in time order; empty if unavailable
+        """
+        if not self.api_key:
+            return []
+
+        try:
+            params = {
+                'lat': lat,
+                'lon': lng,
+                'appid': self.api_key,
+                'units': 'metric'  # Celsius
+            }
+
+            response = requests.get(self.forecast_url, params=params, timeout=10)
+            response.raise_for_status()
+
+            forecast = [{
+                'timestamp': entry['dt'],
+                'temperature': round(entry['main']['temp']),
+                'description': entry['weather'][0]['description'].title(),
+                'icon': entry['weather'][0]['icon']
+            } for entry in response.json()['list']]
+
+            print(f"🌤️  Forecast: {len(forecast)} entries")
+            return forecast
+
+        except Exception as e:
+            print(f"⚠️  Could not fetch weather forecast: {e}")
+            return []
+
     def download_weather_icon(self, icon_code: str, size: int = None) -> Optional[Image.Image]:
         """
         Load local weather icon PNG file.
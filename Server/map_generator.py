@@ -9,15 +9,19 @@ This is the main orchestration class that coordinates all the specialized module
 """
 
 import os
+import shutil
+import tempfile
 from typing import Dict, Optional
 from PIL import Image
 
 # Import specialized modules
 from data_providers import WeatherProvider, GeolocationProvider
 from image_composition import OverlayComposer
-from utils import EpaperConverter, visualize_epaper_binary
+from utils import EpaperConverter, visualize_epaper_binary, export_widget_assets, export_vector_map, convert_bin_to_binz
+from utils import read_published_frame, export_frame_patch, export_tiled_frame
+from utils import convert_png_to_bin_only, bundle_slots, export_frame_bundle, export_manifest
 from map_providers.mapbox import get_mapbox_provider
-from config.settings import PathConfig
+from config.settings import PathConfig, PublishConfig
 
 
 class MapGenerator:
@@ -198,6 +202,7 @@ class MapGenerator:
 
             # Crop to final size to avoid deformation
             final_image = self.overlay_composer.crop_to_final_size(square_image)
+            base_image = final_image.copy()
 
             # Add information overlay
             final_image = self.overlay_composer.add_info_overlay(
@@ -214,6 +219,9 @@ class MapGenerator:
             final_image.save(save_path, 'PNG', optimize=True)
             print(f"✅ Map saved to: {save_path} ({self.overlay_composer.final_width}x{self.overlay_composer.final_height}px)")
 
+            # Frame devices show until this update, the base of the frame patch
+            previous_frame = read_published_frame(f"{os.path.splitext(save_path)[0]}.bin")
+
             # Generate C array and binary files for e-paper display
             c_path, bin_path = self.epaper_converter.convert_png_to_epaper(save_path)
             
@@ -229,6 +237,33 @@ class MapGenerator:
                     print(f"✅ E-paper preview saved to: {visualized_path}")
                 else:
                     print("⚠️  Failed to generate e-paper visualization")
+                
+                # Same frame DEFLATE-compressed with a small window for streaming
+                convert_bin_to_binz(bin_path)
+
+                # Changed runs against the previous frame for devices that cache it
+                export_frame_patch(previous_frame, bin_path)
+
+                # Tiles behind a hash index for devices with any older frame
+                export_tiled_frame(bin_path)
+
+                # The next hours pre-rendered, shown from flash without WiFi
+                self.export_frame_bundle(
+                    base_image, bin_path, city, country, lat, lng, timezone_name, weather_data
+                )
+            
+            # Base map plus widget data for devices that draw the overlay themselves
+            export_widget_assets(
+                base_image, os.path.splitext(save_path)[0], city, country, lat, lng,
+                date_str, time_str, weather_data, bin_path
+            )
+            
+            # Same view as vector data for devices that rasterise it themselves
+            export_vector_map(self.mapbox, lat, lng, zoom, f"{os.path.splitext(save_path)[0]}.vmap")
+            
+            # Last: frame hash and the files above, read by devices before any frame
+            if bin_path and os.path.exists(bin_path):
+                export_manifest(bin_path, PublishConfig.UPDATE_INTERVAL_MINUTES * 60)
             
             return save_path
 
@@ -280,12 +315,71 @@ class MapGenerator:
                     print(f"✅ E-paper preview saved to: {visualized_path}")
                 else:
                     print("⚠️  Failed to generate e-paper visualization")
+                
+                # Same frame DEFLATE-compressed with a small window for streaming
+                convert_bin_to_binz(bin_path)
+
+                # Last: frame hash and the files above, read by devices before any frame
+                export_manifest(bin_path, PublishConfig.UPDATE_INTERVAL_MINUTES * 60)
 
             return save_path
 
         except Exception as e:
             raise Exception(f"Error generating map: {e}")
 
+    def export_frame_bundle(self, base_image: Image.Image, bin_path: str, city: str, country: str,
+                            lat: float, lng: float, timezone_name: str, weather_data: Optional[Dict]) -> Optional[str]:
+        """
+        Render the frames of the next hours and write them as <name>.bundle.
+
+        The first frame is the one just converted; the following slots get
+        their local time and the forecast entry closest to them (the current
+        weather when there is no forecast) on a copy of the base map.
+
+        Args:
+            base_image: Map without the information overlay
+            bin_path: Binary frame of the current map
+            city, country, lat, lng: Overlay location
+            timezone_name: Timezone of the local clock shown
+            weather_data: Current weather, used without a forecast
+
+        Returns:
+            Path of the bundle, or None if it was not written
+        """
+        slots = bundle_slots()
+        forecast = self.weather_provider.get_forecast(lat, lng) if weather_data else []
+
+        with open(bin_path, 'rb') as f:
+            frames = [(slots[0], f.read())]
+
+        scratch = tempfile.mkdtemp()
+        try:
+            for display_at in slots[1:]:
+                weather = weather_data
+                if forecast:
+                    weather = min(forecast, key=lambda entry: abs(entry['timestamp'] - display_at))
+                icon = self.download_weather_icon(weather['icon']) if weather else None
+                date_str, time_str = self.geolocation_provider.get_local_datetime(timezone_name, display_at)
+
+                image = self.overlay_composer.add_info_overlay(
+                    base_image.copy(), city, country, lat, lng, date_str, time_str, weather, icon
+                )
+                png_path = os.path.join(scratch, f"frame_{display_at}.png")
+                image.save(png_path, 'PNG')
+                slot_bin = convert_png_to_bin_only(png_path)
+                if not slot_bin:
+                    print("⚠️  Failed to render frame bundle")
+                    return None
+                with open(slot_bin, 'rb') as f:
+                    frames.append((display_at, f.read()))
+
+            return export_frame_bundle(frames, bin_path)
+        except Exception as e:
+            print(f"⚠️  Could not export frame bundle: {e}")
+            return None
+        finally:
+            shutil.rmtree(scratch, ignore_errors=True)
+
     def list_cached_locations(self) -> Dict:
         """
         Get all cached locations.
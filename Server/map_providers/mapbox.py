@@ -166,6 +166,32 @@ class MapboxProvider:
             print(f"❌ Error downloading map: {e}")
             return None
     
+    def download_vector_tile(self, z: int, x: int, y: int,
+                             tileset: str = "mapbox.mapbox-streets-v8") -> Optional[bytes]:
+        """
+        Download one Mapbox Vector Tile (MVT).
+        
+        Args:
+            z, x, y: Tile coordinates
+            tileset: Vector tileset ID
+            
+        Returns:
+            Raw tile bytes or None if failed
+        """
+        try:
+            endpoint = f"{self.base_url}/v4/{tileset}/{z}/{x}/{y}.mvt"
+            response = requests.get(endpoint, params={'access_token': self.access_token})
+            
+            if response.status_code != 200:
+                print(f"❌ Vector tile download failed: {response.status_code} - {response.text}")
+                return None
+            
+            return response.content
+            
+        except Exception as e:
+            print(f"❌ Error downloading vector tile: {e}")
+            return None
+    
     def generate_map_image(self, 
                           lat: float, 
                           lng: float, 
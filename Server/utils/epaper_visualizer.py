@@ -127,15 +127,21 @@ class EpaperVisualizer:
                     
                     byte_index += 1
             
-            # Create PIL image and save
-            img = Image.fromarray(img_array, 'RGB')
+            # Save as a 4-bit indexed PNG whose palette indices are the panel
+            # color indices, so the device can use decoded rows as they are
+            index_array = np.zeros((height, width), dtype=np.uint8)
+            for color_idx, rgb in enumerate(self.PALETTE):
+                index_array[np.all(img_array == rgb, axis=2)] = color_idx
+
+            img = Image.fromarray(index_array, 'P')
+            img.putpalette([channel for rgb in self.PALETTE for channel in rgb])
             img = img.rotate(90, expand=True)
 
-            img.save(png_path, 'PNG', optimize=True)
+            img.save(png_path, 'PNG', optimize=True, bits=4)
             
             print(f"✅ Visualization saved to: {png_path}")
             print(f"📊 Image dimensions: {width}x{height}")
-            print(f"🎨 Colors used: {len(set(np.unique(img_array.reshape(-1, 3), axis=0)))} unique colors")
+            print(f"🎨 Colors used: {len(np.unique(img_array.reshape(-1, 3), axis=0))} unique colors")
             
             return png_path
             
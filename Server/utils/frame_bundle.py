@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Time-indexed frame bundles (.bundle) for Smart City Maps.
+
+The frames a device should show over the next hours, rendered in advance
+(clock and forecast weather of each slot on the same map) and sent in one
+download. The device keeps the bundle in flash and on later wakes shows the
+frame that is due without starting WiFi (see Firmware/include/frame_bundle.h):
+
+    Header (16 bytes, little-endian)
+        uint32 magic "FBND", uint8 version, uint8 frame count,
+        uint16 reserved (0), uint32 creation time, uint32 stale after
+    Entry per frame, in display order (16 bytes each):
+        uint32 display at, uint32 offset of the frame from the start of the
+        file, uint32 length, uint32 FNV-1a hash of the packed frame
+    Frames: complete .binz files (see binz_encoder.py), one after the other
+
+Times are Unix seconds (UTC). A frame is due from its display time until the
+next one's; past "stale after" the device fetches a new bundle even when
+frames are left, so a forecast that changed is picked up.
+"""
+
+import os
+import struct
+import time
+
+from .binz_encoder import encode_binz, decode_binz, fnv1a_32
+
+
+BUNDLE_MAGIC = 0x444E4246   # "FBND"
+BUNDLE_VERSION = 1
+BUNDLE_HEADER = struct.Struct('<IBBHII')
+BUNDLE_ENTRY = struct.Struct('<IIII')
+BUNDLE_FRAMES = 6           # Current frame plus five future slots
+BUNDLE_INTERVAL = 30 * 60   # Seconds between frames, the device's active-hours wake
+MAX_FRAMES = 8              # Same as FRAME_BUNDLE_MAX_FRAMES on the device
+MAX_SIZE = 640 * 1024       # Same as FRAME_BUNDLE_MAX_SIZE on the device
+PORTRAIT_PATH_TAG = "480x800"
+
+
+def bundle_slots(start=None, count=BUNDLE_FRAMES, interval=BUNDLE_INTERVAL):
+    """Display times: start itself, then the following multiples of interval."""
+    start = int(start if start is not None else time.time())
+    first = (start // interval + 1) * interval
+    return [start] + [first + i * interval for i in range(count - 1)]
+
+
+def encode_bundle(frames, created=None, stale_after=None, interval=BUNDLE_INTERVAL):
+    """
+    Bundle bytes of [(display_at, packed landscape frame)] in display order.
+    stale_after defaults to one interval past the last frame.
+    """
+    if not 1 <= len(frames) <= MAX_FRAMES:
+        raise ValueError(f"a bundle holds 1..{MAX_FRAMES} frames, got {len(frames)}")
+    times = [display_at for display_at, _ in frames]
+    if times != sorted(times) or len(set(times)) != len(times):
+        raise ValueError("display times must be strictly increasing")
+
+    created = int(created if created is not None else time.time())
+    stale_after = int(stale_after if stale_after is not None else times[-1] + interval)
+
+    payloads = [encode_binz(frame) for _, frame in frames]
+    offset = BUNDLE_HEADER.size + BUNDLE_ENTRY.size * len(frames)
+    entries = bytearray()
+    for (display_at, frame), payload in zip(frames, payloads):
+        entries += BUNDLE_ENTRY.pack(display_at, offset, len(payload), fnv1a_32(frame))
+        offset += len(payload)
+
+    header = BUNDLE_HEADER.pack(BUNDLE_MAGIC, BUNDLE_VERSION, len(frames), 0, created, stale_after)
+    data = header + bytes(entries) + b''.join(payloads)
+    if len(data) > MAX_SIZE:
+        raise ValueError(f"bundle is {len(data)} bytes, the device keeps at most {MAX_SIZE}")
+    return data
+
+
+def decode_bundle(data):
+    """(created, stale_after, [(display_at, frame)]), checking every frame."""
+    magic, version, count, _, created, stale_after = BUNDLE_HEADER.unpack_from(data)
+    if magic != BUNDLE_MAGIC or version != BUNDLE_VERSION:
+        raise ValueError("not a frame bundle")
+
+    frames = []
+    for i in range(count):
+        display_at, offset, length, frame_hash = BUNDLE_ENTRY.unpack_from(
+            data, BUNDLE_HEADER.size + i * BUNDLE_ENTRY.size)
+        _, _, frame = decode_binz(data[offset:offset + length])
+        if fnv1a_32(frame) != frame_hash:
+            raise ValueError(f"frame {i} does not match its entry")
+        frames.append((display_at, frame))
+    return created, stale_after, frames
+
+
+def export_frame_bundle(frames, bin_path, bundle_path=None):
+    """
+    Write <name>.bundle next to a landscape .bin frame from
+    [(display_at, packed frame)]; portrait frames are skipped.
+    """
+    if PORTRAIT_PATH_TAG in os.path.basename(bin_path):
+        return None
+
+    data = encode_bundle(frames)
+    bundle_path = bundle_path or f"{os.path.splitext(bin_path)[0]}.bundle"
+    with open(bundle_path, 'wb') as f:
+        f.write(data)
+
+    first, last = frames[0][0], frames[-1][0]
+    print(f"✅ Frame bundle saved to: {bundle_path} ({len(data)} bytes, {len(frames)} frames "
+          f"{time.strftime('%H:%M', time.gmtime(first))}-{time.strftime('%H:%M', time.gmtime(last))} UTC)")
+    return bundle_path
+
+
+def describe_bundle(path):
+    """Print the frames of a bundle file after checking each one."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    created, stale_after, frames = decode_bundle(data)
+    print(f"{path}: {len(data)} bytes, created {time.strftime('%Y-%m-%d %H:%M', time.gmtime(created))} UTC, "
+          f"stale after {time.strftime('%H:%M', time.gmtime(stale_after))}")
+    for i, (display_at, frame) in enumerate(frames):
+        _, offset, length, frame_hash = BUNDLE_ENTRY.unpack_from(data, BUNDLE_HEADER.size + i * BUNDLE_ENTRY.size)
+        print(f"  {i}: {time.strftime('%H:%M', time.gmtime(display_at))} UTC  0x{frame_hash:08X}  "
+              f"{length} bytes at {offset}")
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) >= 4 and sys.argv[1] == '--build':
+        # Consecutive slots from now, one per .bin, e.g. from a day of renders
+        paths = sys.argv[3:]
+        frames = []
+        for display_at, path in zip(bundle_slots(count=len(paths)), paths):
+            with open(path, 'rb') as f:
+                frames.append((display_at, f.read()))
+        with open(sys.argv[2], 'wb') as f:
+            f.write(encode_bundle(frames))
+        describe_bundle(sys.argv[2])
+    elif len(sys.argv) == 2:
+        describe_bundle(sys.argv[1])
+    else:
+        print("Usage: python -m utils.frame_bundle <map.bundle>")
+        print("       python -m utils.frame_bundle --build <out.bundle> <frame0.bin> <frame1.bin> ...")
+        sys.exit(1)
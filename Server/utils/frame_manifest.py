@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Frame manifests (_manifest.json) for Smart City Maps.
+
+A few hundred bytes of JSON published next to each map that tell a device,
+before any frame transfer, whether there is a new frame and which files it
+can be fetched from:
+
+    {"version": 1, "hash": <FNV-1a of the .bin>, "size": <.bin bytes>,
+     "width": 800, "height": 480, "sha256": <hex SHA-256 of the .bin>,
+     "generated": <Unix time of this run>, "next_update": <expected next run>,
+     "encodings": {"bin": 192000, "binz": 84203, "epd_png": 127734,
+                   "bpatch": 23811, "tiles": 80312, "bundle": 503282,
+                   "widgets": 251, "vmap": 31877},
+     "patch_base": <hash of the frame the .bpatch applies to>}
+
+Only files that exist are listed under "encodings", with their size. The
+firmware reads the document with a filtered streaming parse and skips the
+frame requests when "hash" is the frame it shows, and the requests for
+encodings that are not listed (see github_fetcher.cpp, fetchManifest()), so
+a wake never asks for a file that is not there.
+Every frame it receives, whatever the encoding, is checked against "sha256"
+before the panel is refreshed. "width" and "height" give the layout of the
+raw .bin, which has no header of its own: 480x800 frames are rotated by the
+device while uploading.
+"""
+
+import hashlib
+import json
+import os
+import time
+
+from .binz_encoder import BINZ_HEADER, BINZ_MAGIC, PORTRAIT_PATH_TAG
+from .frame_patch import PATCH_HEADER, PATCH_MAGIC
+
+
+MANIFEST_VERSION = 1
+MAX_MANIFEST_SIZE = 1024    # Same as MAX_MANIFEST_SIZE on the device
+
+# Encoding name -> file next to <name>.bin
+ENCODING_SUFFIXES = {
+    'bin': '.bin',
+    'binz': '.binz',
+    'epd_png': '_epd.png',
+    'bpatch': '.bpatch',
+    'tiles': '.tiles',
+    'bundle': '.bundle',
+    'widgets': '_widgets.json',
+    'vmap': '.vmap',
+}
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def frame_dimensions(bin_path):
+    """(width, height) of the .bin frame: from the .binz header when one is
+    published, else by the naming convention the .binz encoder uses."""
+    binz_path = os.path.splitext(bin_path)[0] + '.binz'
+    if os.path.exists(binz_path):
+        with open(binz_path, 'rb') as f:
+            magic, _, _, width, height, _, _ = BINZ_HEADER.unpack(f.read(BINZ_HEADER.size))
+        if magic == BINZ_MAGIC:
+            return width, height
+    return (480, 800) if PORTRAIT_PATH_TAG in os.path.basename(bin_path) else (800, 480)
+
+
+def build_manifest(bin_path, generated=None, update_interval=None):
+    """Manifest dict for the frame at bin_path and the files published with it."""
+    with open(bin_path, 'rb') as f:
+        frame = f.read()
+
+    generated = int(generated if generated is not None else time.time())
+    base_name = os.path.splitext(bin_path)[0]
+    width, height = frame_dimensions(bin_path)
+    manifest = {
+        'version': MANIFEST_VERSION,
+        'hash': fnv1a_32(frame),
+        'size': len(frame),
+        'width': width,
+        'height': height,
+        'sha256': hashlib.sha256(frame).hexdigest(),
+        'generated': generated,
+    }
+    if update_interval:
+        manifest['next_update'] = generated + int(update_interval)
+
+    manifest['encodings'] = {name: os.path.getsize(base_name + suffix)
+                             for name, suffix in ENCODING_SUFFIXES.items()
+                             if os.path.exists(base_name + suffix)}
+
+    # Devices whose cached frame is not the patch base skip the .bpatch request
+    if 'bpatch' in manifest['encodings']:
+        with open(base_name + '.bpatch', 'rb') as f:
+            magic, _, _, _, base_hash, _, _ = PATCH_HEADER.unpack(f.read(PATCH_HEADER.size))
+        if magic == PATCH_MAGIC:
+            manifest['patch_base'] = base_hash
+    return manifest
+
+
+def export_manifest(bin_path, update_interval=None, manifest_path=None):
+    """Write <name>_manifest.json next to a .bin frame; call after all other files."""
+    manifest = build_manifest(bin_path, update_interval=update_interval)
+    data = json.dumps(manifest, separators=(',', ':'))
+    if len(data) > MAX_MANIFEST_SIZE:
+        raise ValueError(f"manifest is {len(data)} bytes, the device reads at most {MAX_MANIFEST_SIZE}")
+
+    manifest_path = manifest_path or f"{os.path.splitext(bin_path)[0]}_manifest.json"
+    with open(manifest_path, 'w') as f:
+        f.write(data)
+
+    print(f"✅ Manifest saved to: {manifest_path} ({len(data)} bytes, frame 0x{manifest['hash']:08X}, "
+          f"{len(manifest['encodings'])} encodings)")
+    return manifest_path
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) not in (2, 3):
+        print("Usage: python -m utils.frame_manifest <frame.bin> [update interval in minutes]")
+        sys.exit(1)
+
+    interval = int(sys.argv[2]) * 60 if len(sys.argv) == 3 else None
+    path = export_manifest(sys.argv[1], interval)
+    with open(path) as f:
+        print(f.read())
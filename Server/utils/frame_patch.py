@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Frame patches (.bpatch) for Smart City Maps.
+
+Successive frames of a city differ around the information box: time,
+temperature and weather icon change, and Floyd-Steinberg dithering carries
+the difference to the right of and below the box. A patch lists the changed
+byte runs of the packed .bin frame relative to the previous one, so a device
+that still shows that previous frame downloads a fraction of the full frame
+(see Firmware/include/frame_patch.h):
+
+    Header (20 bytes, little-endian)
+        uint32 magic "BPAT", uint8 version, uint8 window bits, uint16 reserved,
+        uint32 FNV-1a hash of the base frame, uint32 FNV-1a hash of the result,
+        uint32 run count
+    Raw DEFLATE stream (same small window as .binz) of the runs:
+        varint bytes kept since the end of the previous run, varint length,
+        length replacement bytes
+
+Runs closer than MERGE_GAP bytes are merged: the few unchanged bytes cost
+less than another run header, and new bytes compress better than an XOR
+against the base because they keep the dithering patterns.
+"""
+
+import os
+import struct
+import zlib
+
+
+PATCH_MAGIC = 0x54415042   # "BPAT"
+PATCH_VERSION = 1
+PATCH_HEADER = struct.Struct('<IBBHIII')
+DEFAULT_WINDOW_BITS = 10
+MERGE_GAP = 16
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def _varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def changed_runs(base, frame, merge_gap=MERGE_GAP):
+    """(start, end) byte ranges where frame differs from base."""
+    runs = []
+    for i in range(len(frame)):
+        if base[i] != frame[i]:
+            if runs and i - runs[-1][1] <= merge_gap:
+                runs[-1][1] = i + 1
+            else:
+                runs.append([i, i + 1])
+    return [tuple(r) for r in runs]
+
+
+def encode_patch(base, frame, window_bits=DEFAULT_WINDOW_BITS):
+    """Patch bytes that turn base into frame (both packed frames of equal size)."""
+    if len(base) != len(frame):
+        raise ValueError(f"frame sizes differ: {len(base)} vs {len(frame)}")
+
+    runs = changed_runs(base, frame)
+    body = bytearray()
+    position = 0
+    for start, end in runs:
+        body += _varint(start - position) + _varint(end - start) + frame[start:end]
+        position = end
+
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -window_bits, 9)
+    payload = compressor.compress(bytes(body)) + compressor.flush()
+    header = PATCH_HEADER.pack(PATCH_MAGIC, PATCH_VERSION, window_bits, 0,
+                               fnv1a_32(base), fnv1a_32(frame), len(runs))
+    return header + payload
+
+
+def apply_patch(base, data):
+    """Reference implementation of the device side; returns the new frame."""
+    magic, version, window_bits, _, base_hash, frame_hash, run_count = PATCH_HEADER.unpack_from(data)
+    if magic != PATCH_MAGIC or version != PATCH_VERSION:
+        raise ValueError("not a frame patch")
+    if fnv1a_32(base) != base_hash:
+        raise ValueError("patch is for a different base frame")
+
+    body = zlib.decompressobj(-window_bits).decompress(data[PATCH_HEADER.size:])
+    frame = bytearray(base)
+    position = offset = 0
+
+    def varint():
+        nonlocal offset
+        value = shift = 0
+        while True:
+            byte = body[offset]
+            offset += 1
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    for _ in range(run_count):
+        position += varint()
+        length = varint()
+        frame[position:position + length] = body[offset:offset + length]
+        offset += length
+        position += length
+
+    if offset != len(body) or fnv1a_32(frame) != frame_hash:
+        raise ValueError("patched frame does not match")
+    return bytes(frame)
+
+
+def read_published_frame(bin_path):
+    """Frame currently published at bin_path (what devices show), or None."""
+    if not os.path.exists(bin_path):
+        return None
+    with open(bin_path, 'rb') as f:
+        return f.read()
+
+
+def export_frame_patch(previous_frame, bin_path, patch_path=None):
+    """
+    Write <name>.bpatch from the previously published frame to bin_path.
+
+    Without a previous frame of the same size (first run, size change) a
+    stale patch is removed, so devices fall back to the full frame.
+    """
+    patch_path = patch_path or f"{os.path.splitext(bin_path)[0]}.bpatch"
+    with open(bin_path, 'rb') as f:
+        frame = f.read()
+
+    if not previous_frame or len(previous_frame) != len(frame):
+        if os.path.exists(patch_path):
+            os.remove(patch_path)
+        return None
+
+    data = encode_patch(previous_frame, frame)
+    with open(patch_path, 'wb') as f:
+        f.write(data)
+
+    print(f"✅ Frame patch saved to: {patch_path} ({len(data)} bytes, "
+          f"{len(changed_runs(previous_frame, frame))} runs, {len(data) / len(frame) * 100:.1f}% of the frame)")
+    return patch_path
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) not in (3, 4):
+        print("Usage: python frame_patch.py <previous.bin> <current.bin> [output.bpatch]")
+        sys.exit(1)
+
+    with open(sys.argv[1], 'rb') as f:
+        previous = f.read()
+    path = export_frame_patch(previous, sys.argv[2], sys.argv[3] if len(sys.argv) == 4 else None)
+    if path:
+        with open(path, 'rb') as f, open(sys.argv[2], 'rb') as g:
+            assert apply_patch(previous, f.read()) == g.read()
+        print("  round trip verified")
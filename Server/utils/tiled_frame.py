@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""
+Tiled frames (.tiles) for Smart City Maps.
+
+The packed landscape .bin frame cut into fixed tiles (80x48 pixels = 40
+bytes x 48 rows, 10 x 10 tiles), each compressed on its own, behind an index
+of per-tile hashes, so every tile is one contiguous byte range (see
+Firmware/include/tiled_frame.h):
+
+    Header (20 bytes, little-endian)
+        uint32 magic "TILE", uint8 version, uint8 window bits, uint16 width,
+        uint16 height, uint16 tile width, uint16 tile height, uint16 tile count,
+        uint32 FNV-1a hash of the frame
+    Index, per tile in row-major order:
+        uint32 FNV-1a hash of the tile bytes, uint32 end offset of its data
+    Tile data in the same order: one raw DEFLATE stream per tile (rows top
+    to bottom), starting where the previous tile ends
+
+A device reads the header and index with one Range request, hashes the tiles
+of the frame it has cached and requests only the ranges of tiles that differ
+(neighbouring ones merged, at most MAX_RANGES requests). replay() runs that
+logic against the local HTTPS test server over a sequence of frames and
+reports the bytes transferred per wake.
+
+Tiles compress nearly as well as the whole frame (a 512-byte window covers
+twelve tile rows): ~80 KB for all 100 tiles against ~84 KB for the .binz.
+"""
+
+import os
+import struct
+import zlib
+
+
+TILES_MAGIC = 0x454C4954   # "TILE"
+TILES_VERSION = 1
+TILES_HEADER = struct.Struct('<IBBHHHHHI')
+TILE_ENTRY = struct.Struct('<II')
+TILE_WIDTH = 80
+TILE_HEIGHT = 48
+WINDOW_BITS = 9
+MAX_RANGES = 8             # Same as TILED_FRAME_MAX_RANGES on the device
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def split_tiles(frame, width=800, height=480, tile_width=TILE_WIDTH, tile_height=TILE_HEIGHT):
+    """Tiles of a packed 4bpp frame, row-major, each as bytes row by row."""
+    stride = width // 2
+    tile_stride = tile_width // 2
+    tiles = []
+    for top in range(0, height, tile_height):
+        for left in range(0, stride, tile_stride):
+            tiles.append(b''.join(frame[(top + y) * stride + left:(top + y) * stride + left + tile_stride]
+                                  for y in range(tile_height)))
+    return tiles
+
+
+def _deflate(data):
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -WINDOW_BITS, 9)
+    return compressor.compress(data) + compressor.flush()
+
+
+def encode_tiles(frame, width=800, height=480):
+    """Tiled frame bytes of a packed 4bpp frame."""
+    if len(frame) != width * height // 2:
+        raise ValueError(f"frame is {len(frame)} bytes, expected {width * height // 2} for {width}x{height}")
+    if width % TILE_WIDTH or height % TILE_HEIGHT:
+        raise ValueError(f"{width}x{height} is not a multiple of the {TILE_WIDTH}x{TILE_HEIGHT} tile")
+
+    tiles = split_tiles(frame, width, height)
+    header = TILES_HEADER.pack(TILES_MAGIC, TILES_VERSION, WINDOW_BITS, width, height,
+                               TILE_WIDTH, TILE_HEIGHT, len(tiles), fnv1a_32(frame))
+    index = bytearray()
+    data = bytearray()
+    for tile in tiles:
+        data += _deflate(tile)
+        index += TILE_ENTRY.pack(fnv1a_32(tile), len(data))
+    return header + bytes(index) + bytes(data)
+
+
+def decode_index(data):
+    """(header fields, [(tile hash, start, end)]) with offsets into the file."""
+    fields = TILES_HEADER.unpack_from(data)
+    magic, version, _, _, _, _, _, count, _ = fields
+    if magic != TILES_MAGIC or version != TILES_VERSION:
+        raise ValueError("not a tiled frame")
+
+    base = index_size(count)
+    entries = []
+    start = 0
+    for i in range(count):
+        tile_hash, end = TILE_ENTRY.unpack_from(data, TILES_HEADER.size + i * TILE_ENTRY.size)
+        entries.append((tile_hash, base + start, base + end))
+        start = end
+    return fields, entries
+
+
+def index_size(count=100):
+    """Bytes of header plus index, the first Range a device requests."""
+    return TILES_HEADER.size + TILE_ENTRY.size * count
+
+
+def changed_ranges(cached_tiles, entries, max_ranges=MAX_RANGES):
+    """
+    Tile runs [first, end) to request: runs of changed tiles, with the
+    smallest gaps (in bytes) merged until at most max_ranges remain.
+    Mirrors TiledFrame::planRanges on the device.
+    """
+    runs = []
+    for index, (tile_hash, _, _) in enumerate(entries):
+        if cached_tiles is not None and fnv1a_32(cached_tiles[index]) == tile_hash:
+            continue
+        if runs and runs[-1][1] == index:
+            runs[-1][1] = index + 1
+        else:
+            runs.append([index, index + 1])
+
+    def gap_bytes(i):
+        return entries[runs[i + 1][0]][1] - entries[runs[i][1]][1]
+
+    while len(runs) > max_ranges:
+        gap = min(range(len(runs) - 1), key=gap_bytes)
+        runs[gap][1] = runs[gap + 1][1]
+        del runs[gap + 1]
+    return [tuple(run) for run in runs]
+
+
+def export_tiled_frame(bin_path, tiles_path=None):
+    """Write <name>.tiles next to a landscape .bin frame; portrait frames
+    (800 rows are no multiple of the tile height) are skipped."""
+    with open(bin_path, 'rb') as f:
+        frame = f.read()
+    if len(frame) != 800 * 480 // 2 or "480x800" in os.path.basename(bin_path):
+        return None
+
+    data = encode_tiles(frame)
+    tiles_path = tiles_path or f"{os.path.splitext(bin_path)[0]}.tiles"
+    with open(tiles_path, 'wb') as f:
+        f.write(data)
+
+    print(f"✅ Tiled frame saved to: {tiles_path} ({len(data)} bytes, 100 tiles of "
+          f"{TILE_WIDTH}x{TILE_HEIGHT}, {index_size()} byte index)")
+    return tiles_path
+
+
+def replay(bin_paths, port=0):
+    """
+    Serve each frame of a sequence in turn from the local HTTPS test server
+    and fetch it like a device that shows the previous one. Prints the body
+    bytes the server sent per wake next to the full .bin, .binz and .bpatch.
+    """
+    import http.client
+    import shutil
+    import ssl
+    import tempfile
+    import threading
+    from .tls_test_server import start_server
+    from .frame_patch import encode_patch
+    from .binz_encoder import encode_binz
+
+    scratch = tempfile.mkdtemp()
+    os.makedirs(os.path.join(scratch, 'Maps'))
+    tiles_file = os.path.join(scratch, 'Maps', 'Replay.tiles')
+    server, context_dir = start_server(scratch, port, quiet=True)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    port = server.server_address[1]
+
+    client_context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    client_context.check_hostname = False
+    client_context.verify_mode = ssl.CERT_NONE
+
+    cached = None
+    totals = {'tiles': 0, 'binz': 0, 'patch': 0}
+    print(f"{'wake':>4} {'tiles':>6} {'requests':>8} {'bytes':>7} {'.binz':>7} {'.bpatch':>8}")
+    try:
+        for wake, path in enumerate(bin_paths):
+            with open(path, 'rb') as f:
+                frame = f.read()
+            with open(tiles_file, 'wb') as f:
+                f.write(encode_tiles(frame))
+
+            connection = http.client.HTTPSConnection('localhost', port, context=client_context)
+            url = '/owner/repo/main/Maps/Replay.tiles'
+            server.reset_counters()
+
+            connection.request('GET', url, headers={'Range': f'bytes=0-{index_size() - 1}'})
+            response = connection.getresponse()
+            etag = response.getheader('ETag')
+            _, entries = decode_index(response.read())
+
+            cached_tiles = split_tiles(cached) if cached is not None else None
+            ranges = changed_ranges(cached_tiles, entries)
+            tiles = list(cached_tiles) if cached_tiles else [b''] * len(entries)
+            for first, end in ranges:
+                start = entries[first][1]
+                connection.request('GET', url, headers={'Range': f'bytes={start}-{entries[end - 1][2] - 1}',
+                                                        'If-Range': etag})
+                response = connection.getresponse()
+                assert response.status == 206, "tiled frame changed during the wake"
+                body = response.read()
+                for i in range(first, end):
+                    tiles[i] = zlib.decompress(body[entries[i][1] - start:entries[i][2] - start], -WINDOW_BITS)
+            connection.close()
+
+            assert [fnv1a_32(t) for t in tiles] == [e[0] for e in entries], "assembled tiles do not match"
+            changed = sum(1 for i, e in enumerate(entries)
+                          if cached_tiles is None or fnv1a_32(cached_tiles[i]) != e[0])
+
+            binz = len(encode_binz(frame))
+            patch = len(encode_patch(cached, frame)) if cached is not None else binz
+            sent = server.body_bytes
+            if wake:
+                totals['tiles'] += sent
+                totals['binz'] += binz
+                totals['patch'] += patch
+            print(f"{wake:>4} {changed:>6} {len(ranges) + 1:>8} {sent:>7} {binz:>7} {patch:>8}")
+            cached = frame
+    finally:
+        server.shutdown()
+        shutil.rmtree(scratch, ignore_errors=True)
+        shutil.rmtree(context_dir, ignore_errors=True)
+
+    wakes = max(len(bin_paths) - 1, 1)
+    print(f"Per update after the first: tiles {totals['tiles'] // wakes} B, "
+          f".binz {totals['binz'] // wakes} B, .bpatch {totals['patch'] // wakes} B (raw .bin 192000 B)")
+    return totals
+
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) >= 3 and sys.argv[1] == '--replay':
+        replay(sys.argv[2:])
+    elif len(sys.argv) == 2:
+        export_tiled_frame(sys.argv[1])
+    else:
+        print("Usage: python -m utils.tiled_frame <frame.bin>")
+        print("       python -m utils.tiled_frame --replay <frame0.bin> <frame1.bin> ...")
+        sys.exit(1)
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""
+Local HTTPS test server for TLS session resumption.
+
+Serves the published map files over HTTPS with keep-alive, so the firmware can
+be pointed at it (GITHUB_HOST / GITHUB_PORT in config.h) instead of GitHub.
+Request paths look like raw.githubusercontent.com URLs; the leading
+owner/repo/branch components are dropped, so running it from the repository
+root serves /JGAguado/Smart_City_Maps/main/Maps/... from ./Maps/...
+
+Every connection is logged with its server-side handshake time and whether
+the client resumed a previous session. TLS is capped at 1.2 like the mbedtls
+build on the device, so resumption uses session tickets or session IDs.
+
+Single byte ranges (Range, If-Range) and If-None-Match are answered like
+raw.githubusercontent.com does, and every connection - one per device wake -
+logs its requests and the body bytes sent when it closes.
+
+--probe HOST[:PORT] measures full versus resumed handshakes from this host
+against any server, e.g. to check that a frame host issues session tickets.
+"""
+
+import argparse
+import functools
+import os
+import re
+import shutil
+import socket
+import ssl
+import subprocess
+import tempfile
+import time
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+
+class RawPathHandler(SimpleHTTPRequestHandler):
+    """Static files with owner/repo/branch stripped from the request path."""
+
+    protocol_version = "HTTP/1.1"   # Keep-alive, like raw.githubusercontent.com
+    strip_components = 3
+    range_remaining = None          # Body bytes of the current response
+
+    def setup(self):
+        super().setup()
+        self.connection_requests = 0
+        self.connection_bytes = 0
+
+    def translate_path(self, path):
+        parts = path.split('?', 1)[0].split('/')
+        kept = [p for p in parts if p][self.strip_components:]
+        return super().translate_path('/' + '/'.join(kept))
+
+    def send_head(self):
+        path = self.translate_path(self.path)
+        if os.path.isdir(path):
+            return super().send_head()
+        try:
+            f = open(path, 'rb')
+        except OSError:
+            self.send_error(404, "File not found")
+            return None
+
+        stat = os.fstat(f.fileno())
+        size = stat.st_size
+        etag = f'"{stat.st_mtime_ns:x}-{size:x}"'
+        self.connection_requests += 1
+        if self.headers.get('If-None-Match') == etag:
+            f.close()
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.end_headers()
+            return None
+
+        # A Range only applies while If-Range still names this version
+        start, end = 0, size
+        requested = self.headers.get('Range')
+        if_range = self.headers.get('If-Range')
+        if requested and (if_range is None or if_range == etag):
+            match = re.fullmatch(r'bytes=(\d+)-(\d*)', requested.strip())
+            if not match or int(match[1]) >= size:
+                f.close()
+                self.send_response(416)
+                self.send_header('Content-Range', f'bytes */{size}')
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return None
+            start = int(match[1])
+            end = min(int(match[2]) + 1, size) if match[2] else size
+            self.send_response(206)
+            self.send_header('Content-Range', f'bytes {start}-{end - 1}/{size}')
+        else:
+            self.send_response(200)
+
+        self.send_header('Content-Type', self.guess_type(path))
+        self.send_header('Content-Length', str(end - start))
+        self.send_header('ETag', etag)
+        self.send_header('Accept-Ranges', 'bytes')
+        self.end_headers()
+        f.seek(start)
+        self.range_remaining = end - start
+        return f
+
+    def copyfile(self, source, outputfile):
+        if self.range_remaining is None:
+            return super().copyfile(source, outputfile)
+        while self.range_remaining > 0:
+            chunk = source.read(min(65536, self.range_remaining))
+            if not chunk:
+                break
+            outputfile.write(chunk)
+            self.range_remaining -= len(chunk)
+            self.connection_bytes += len(chunk)
+            self.server.body_bytes += len(chunk)
+
+    def finish(self):
+        super().finish()
+        if self.connection_requests and not self.server.quiet:
+            print(f"{self.client_address[0]}: connection closed, {self.connection_requests} request(s), "
+                  f"{self.connection_bytes} body bytes")
+
+    def log_message(self, format, *args):
+        if not self.server.quiet:
+            print(f"  {self.client_address[0]} {format % args}")
+
+
+class TlsTestServer(ThreadingHTTPServer):
+    """Threaded HTTPS server that times each handshake."""
+
+    def __init__(self, address, handler, context, quiet=False):
+        super().__init__(address, handler)
+        self.context = context
+        self.quiet = quiet
+        self.full = []
+        self.resumed = []
+        self.body_bytes = 0
+
+    def reset_counters(self):
+        self.body_bytes = 0
+
+    def get_request(self):
+        sock, address = self.socket.accept()
+        tls = self.context.wrap_socket(sock, server_side=True, do_handshake_on_connect=False)
+        start = time.perf_counter()
+        try:
+            tls.do_handshake()
+        except (ssl.SSLError, OSError) as e:
+            print(f"{address[0]}: handshake failed: {e}")
+            tls.close()
+            raise
+        elapsed = (time.perf_counter() - start) * 1000
+        (self.resumed if tls.session_reused else self.full).append(elapsed)
+        if self.quiet:
+            return tls, address
+        print(f"{address[0]}: {'resumed' if tls.session_reused else 'full'} handshake "
+              f"{elapsed:.1f} ms, {tls.version()} {tls.cipher()[0]} "
+              f"({_summary(self.full, self.resumed)})")
+        return tls, address
+
+    def handle_error(self, request, client_address):
+        # Dropped keep-alive connections are expected when a device sleeps
+        pass
+
+
+def _summary(full, resumed):
+    def avg(values):
+        return f"{sum(values) / len(values):.1f} ms" if values else "-"
+    return f"full {len(full)} x {avg(full)}, resumed {len(resumed)} x {avg(resumed)}"
+
+
+def _self_signed_certificate(directory, common_name):
+    """Create a throwaway certificate; the device does not verify it."""
+    cert = os.path.join(directory, "cert.pem")
+    key = os.path.join(directory, "key.pem")
+    subprocess.run(["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+                    "-nodes", "-days", "30", "-subj", f"/CN={common_name}",
+                    "-keyout", key, "-out", cert],
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def start_server(directory, port, cert=None, key=None, quiet=False):
+    """
+    Create (not start) a test server for directory; port 0 picks a free one.
+    Returns the server and the scratch directory holding its certificate.
+    """
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    scratch = tempfile.mkdtemp()
+    if not cert:
+        cert, key = _self_signed_certificate(scratch, socket.gethostname())
+    context.load_cert_chain(cert, key)
+
+    handler = functools.partial(RawPathHandler, directory=directory)
+    return TlsTestServer(("", port), handler, context, quiet), scratch
+
+
+def serve(directory, port, cert=None, key=None):
+    server, scratch = start_server(directory, port, cert, key)
+    print(f"Serving {os.path.abspath(directory)} on https://0.0.0.0:{port}/<owner>/<repo>/<branch>/...")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(_summary(server.full, server.resumed))
+        server.server_close()
+        shutil.rmtree(scratch, ignore_errors=True)
+
+
+def probe(host, port, rounds=5):
+    """Time full and resumed handshakes against host from this machine."""
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    full, resumed = [], []
+    session = None
+    for i in range(rounds * 2):
+        offer = session if i % 2 else None
+        with socket.create_connection((host, port), timeout=10) as sock:
+            start = time.perf_counter()
+            with context.wrap_socket(sock, server_hostname=host, session=offer) as tls:
+                elapsed = (time.perf_counter() - start) * 1000
+                (resumed if tls.session_reused else full).append(elapsed)
+                session = tls.session
+    print(f"{host}:{port}: {_summary(full, resumed)}")
+    return full, resumed
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="HTTPS test server for TLS session resumption")
+    parser.add_argument("--directory", default=".", help="Directory that contains Maps/ (default: .)")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", help="PEM certificate (default: self-signed)")
+    parser.add_argument("--key", help="PEM private key for --cert")
+    parser.add_argument("--probe", metavar="HOST[:PORT]", help="Measure handshakes against a server instead")
+    args = parser.parse_args()
+
+    if args.probe:
+        host, _, probe_port = args.probe.partition(':')
+        probe(host, int(probe_port or 443))
+    else:
+        serve(args.directory, args.port, args.cert, args.key)
@@ -0,0 +1,670 @@
+#!/usr/bin/env python3
+"""
+Vector Map Encoder for Smart City Maps.
+
+Builds the compact .vmap format the firmware rasterises itself (see
+Firmware/include/vector_map.h): water, park and road geometry from Mapbox
+vector tiles, clipped to the 480x800 map view, simplified, rotated into panel
+coordinates, quantised and delta/zigzag/varint encoded with one style per
+layer. A city view is a few tens of KB instead of a 192000-byte frame, and it
+is drawn with solid panel colors instead of dithered ones.
+
+The module also contains a reference rasteriser that follows the device rules
+(pixel-center sampling, even-odd fill, quads with round joins for lines), so
+encoded maps can be compared against the server's PNG renders on a host.
+"""
+
+import gzip
+import math
+import os
+import struct
+import zlib
+
+
+VMAP_MAGIC = 0x50414D56  # "VMAP"
+VMAP_VERSION = 1
+HEADER_SIZE = 16
+
+LAYER_FILL = 0
+LAYER_LINE = 1
+
+# Panel color indices (Firmware/include/epd_colors.h)
+BLACK, WHITE, GREEN, BLUE, RED, YELLOW, ORANGE = range(7)
+
+# Panel frame the coordinates refer to (landscape, as in the .bin files)
+PANEL_WIDTH = 800
+PANEL_HEIGHT = 480
+
+# Style layers in drawing order:
+# (name, source layer, classes or None for all, kind, color, line width)
+STYLE_LAYERS = [
+    ('parks', 'landuse', {'park', 'grass', 'wood', 'scrub', 'pitch', 'cemetery'}, LAYER_FILL, GREEN, 0),
+    ('water', 'water', None, LAYER_FILL, BLUE, 0),
+    ('waterways', 'waterway', {'river', 'canal'}, LAYER_LINE, BLUE, 3),
+    ('streets', 'road', {'street', 'street_limited', 'service'}, LAYER_LINE, BLACK, 1),
+    ('rail', 'road', {'major_rail'}, LAYER_LINE, BLACK, 1),
+    ('main_roads', 'road', {'secondary', 'tertiary', 'secondary_link', 'tertiary_link'}, LAYER_LINE, BLACK, 2),
+    ('major_roads', 'road', {'primary', 'trunk', 'primary_link', 'trunk_link'}, LAYER_LINE, ORANGE, 3),
+    ('motorways', 'road', {'motorway', 'motorway_link'}, LAYER_LINE, RED, 4),
+]
+
+# MVT geometry types
+GEOM_LINESTRING = 2
+GEOM_POLYGON = 3
+
+
+# ---------------------------------------------------------------------------
+# Mapbox Vector Tile decoding (protobuf subset, no external dependencies)
+# ---------------------------------------------------------------------------
+
+def _read_varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return result, pos
+        shift += 7
+
+
+def _iter_fields(buf):
+    """Yield (field number, wire type, value) for a protobuf message."""
+    pos = 0
+    while pos < len(buf):
+        key, pos = _read_varint(buf, pos)
+        field, wire_type = key >> 3, key & 7
+        if wire_type == 0:
+            value, pos = _read_varint(buf, pos)
+        elif wire_type == 1:
+            value, pos = buf[pos:pos + 8], pos + 8
+        elif wire_type == 2:
+            size, pos = _read_varint(buf, pos)
+            value, pos = buf[pos:pos + size], pos + size
+        elif wire_type == 5:
+            value, pos = buf[pos:pos + 4], pos + 4
+        else:
+            raise ValueError(f"Unsupported protobuf wire type {wire_type}")
+        yield field, wire_type, value
+
+
+def _packed_varints(buf):
+    values = []
+    pos = 0
+    while pos < len(buf):
+        value, pos = _read_varint(buf, pos)
+        values.append(value)
+    return values
+
+
+def _decode_value(buf):
+    for field, wire_type, value in _iter_fields(buf):
+        if field == 1:
+            return value.decode('utf-8')
+        if field == 2:
+            return struct.unpack('<f', value)[0]
+        if field == 3:
+            return struct.unpack('<d', value)[0]
+        if field in (4, 5):
+            return value
+        if field == 6:
+            return (value >> 1) ^ -(value & 1)
+        if field == 7:
+            return bool(value)
+    return None
+
+
+def decode_mvt(data):
+    """
+    Decode a Mapbox Vector Tile.
+
+    Returns:
+        dict: layer name -> (extent, [(geometry type, properties, command integers)])
+    """
+    if data[:2] == b'\x1f\x8b':
+        data = gzip.decompress(data)
+
+    layers = {}
+    for field, _, layer_buf in _iter_fields(data):
+        if field != 3:
+            continue
+
+        name, extent = None, 4096
+        keys, values, raw_features = [], [], []
+        for lfield, _, lvalue in _iter_fields(layer_buf):
+            if lfield == 1:
+                name = lvalue.decode('utf-8')
+            elif lfield == 2:
+                raw_features.append(lvalue)
+            elif lfield == 3:
+                keys.append(lvalue.decode('utf-8'))
+            elif lfield == 4:
+                values.append(_decode_value(lvalue))
+            elif lfield == 5:
+                extent = lvalue
+
+        features = []
+        for feature_buf in raw_features:
+            geom_type, tags, geometry = 0, [], []
+            for ffield, _, fvalue in _iter_fields(feature_buf):
+                if ffield == 2:
+                    tags = _packed_varints(fvalue)
+                elif ffield == 3:
+                    geom_type = fvalue
+                elif ffield == 4:
+                    geometry = _packed_varints(fvalue)
+            properties = {keys[tags[i]]: values[tags[i + 1]] for i in range(0, len(tags) - 1, 2)}
+            features.append((geom_type, properties, geometry))
+
+        layers[name] = (extent, features)
+    return layers
+
+
+def decode_geometry(commands):
+    """Turn MVT geometry commands into parts (lists of (x, y) in tile units)."""
+    parts = []
+    current = None
+    x = y = 0
+    i = 0
+    while i < len(commands):
+        command, count = commands[i] & 7, commands[i] >> 3
+        i += 1
+        if command == 7:  # ClosePath
+            continue
+        for _ in range(count):
+            dx, dy = commands[i], commands[i + 1]
+            i += 2
+            x += (dx >> 1) ^ -(dx & 1)
+            y += (dy >> 1) ^ -(dy & 1)
+            if command == 1:  # MoveTo starts a new part
+                current = [(x, y)]
+                parts.append(current)
+            else:
+                current.append((x, y))
+    return parts
+
+
+# ---------------------------------------------------------------------------
+# Geometry helpers
+# ---------------------------------------------------------------------------
+
+def _clip_ring(ring, x0, y0, x1, y1):
+    """Sutherland-Hodgman clip of a closed ring against a rectangle."""
+    def clip(points, inside, intersect):
+        result = []
+        for i, current in enumerate(points):
+            previous = points[i - 1]
+            if inside(current):
+                if not inside(previous):
+                    result.append(intersect(previous, current))
+                result.append(current)
+            elif inside(previous):
+                result.append(intersect(previous, current))
+        return result
+
+    def at_x(a, b, x):
+        return (x, a[1] + (b[1] - a[1]) * (x - a[0]) / (b[0] - a[0]))
+
+    def at_y(a, b, y):
+        return (a[0] + (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]), y)
+
+    points = list(ring)
+    for inside, intersect in (
+        (lambda p: p[0] >= x0, lambda a, b: at_x(a, b, x0)),
+        (lambda p: p[0] <= x1, lambda a, b: at_x(a, b, x1)),
+        (lambda p: p[1] >= y0, lambda a, b: at_y(a, b, y0)),
+        (lambda p: p[1] <= y1, lambda a, b: at_y(a, b, y1)),
+    ):
+        if not points:
+            break
+        points = clip(points, inside, intersect)
+    return points
+
+
+def _clip_line(line, x0, y0, x1, y1):
+    """Liang-Barsky clip of a polyline; returns the visible pieces."""
+    pieces = []
+    current = None
+    for a, b in zip(line, line[1:]):
+        dx, dy = b[0] - a[0], b[1] - a[1]
+        t0, t1 = 0.0, 1.0
+        visible = True
+        for p, q in ((-dx, a[0] - x0), (dx, x1 - a[0]), (-dy, a[1] - y0), (dy, y1 - a[1])):
+            if p == 0:
+                if q < 0:
+                    visible = False
+                    break
+                continue
+            t = q / p
+            if p < 0:
+                t0 = max(t0, t)
+            else:
+                t1 = min(t1, t)
+            if t0 > t1:
+                visible = False
+                break
+        if not visible:
+            current = None
+            continue
+
+        start = (a[0] + t0 * dx, a[1] + t0 * dy)
+        end = (a[0] + t1 * dx, a[1] + t1 * dy)
+        if current is None or t0 > 0:
+            current = [start]
+            pieces.append(current)
+        current.append(end)
+        if t1 < 1:
+            current = None
+    return pieces
+
+
+def _simplify(points, tolerance):
+    """Douglas-Peucker simplification."""
+    if len(points) < 3:
+        return list(points)
+
+    keep = [False] * len(points)
+    keep[0] = keep[-1] = True
+    stack = [(0, len(points) - 1)]
+    tolerance_sq = tolerance * tolerance
+    while stack:
+        first, last = stack.pop()
+        ax, ay = points[first]
+        bx, by = points[last]
+        dx, dy = bx - ax, by - ay
+        length_sq = dx * dx + dy * dy
+        worst, worst_index = 0.0, -1
+        for i in range(first + 1, last):
+            px, py = points[i]
+            if length_sq == 0:
+                distance_sq = (px - ax) ** 2 + (py - ay) ** 2
+            else:
+                cross = dx * (py - ay) - dy * (px - ax)
+                distance_sq = cross * cross / length_sq
+            if distance_sq > worst:
+                worst, worst_index = distance_sq, i
+        if worst > tolerance_sq:
+            keep[worst_index] = True
+            stack.append((first, worst_index))
+            stack.append((worst_index, last))
+    return [p for p, k in zip(points, keep) if k]
+
+
+def _ring_area(ring):
+    return abs(sum(ring[i - 1][0] * ring[i][1] - ring[i][0] * ring[i - 1][1] for i in range(len(ring)))) / 2
+
+
+def _zigzag(value):
+    return -2 * value - 1 if value < 0 else 2 * value
+
+
+def _varint(value, out):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+# ---------------------------------------------------------------------------
+# Encoder
+# ---------------------------------------------------------------------------
+
+class VectorMapEncoder:
+    """Collects vector tile features for one map view and encodes a .vmap."""
+
+    def __init__(self, lat, lng, zoom, width=480, height=800, precision_bits=1,
+                 tolerance=0.5, margin=8, background=WHITE, style_layers=None):
+        """
+        Args:
+            lat, lng, zoom: Map view, as passed to the Mapbox Static Images API
+            width, height: Portrait view size in pixels (the server's map PNG)
+            precision_bits: Fractional coordinate bits on the wire (0-4)
+            tolerance: Simplification tolerance in pixels
+            margin: Pixels kept outside the view so line caps are not cut
+            background: Panel color of everything not covered by a layer
+            style_layers: Style table, defaults to STYLE_LAYERS
+        """
+        self.width = width
+        self.height = height
+        self.precision_bits = precision_bits
+        self.tolerance = tolerance
+        self.margin = margin
+        self.background = background
+        self.style_layers = style_layers or STYLE_LAYERS
+
+        # The server renders @2x static images and crops the center, so a
+        # world pixel at the requested zoom is 2 view pixels: 1024 * 2^zoom
+        self.world_size = 1024 * (2 ** zoom)
+        self.center_x, self.center_y = self._project(lat, lng)
+        self.tile_zoom = min(16, zoom + 1)
+        self.layers = [[] for _ in self.style_layers]
+
+    def _project(self, lat, lng):
+        x = (lng + 180.0) / 360.0 * self.world_size
+        sin_lat = math.sin(math.radians(lat))
+        y = (0.5 - math.log((1 + sin_lat) / (1 - sin_lat)) / (4 * math.pi)) * self.world_size
+        return x, y
+
+    def tiles_for_view(self):
+        """(z, x, y) of the vector tiles covering the view plus margin."""
+        tile_pixels = self.world_size / (2 ** self.tile_zoom)
+        left = self.center_x - self.width / 2 - self.margin
+        right = self.center_x + self.width / 2 + self.margin
+        top = self.center_y - self.height / 2 - self.margin
+        bottom = self.center_y + self.height / 2 + self.margin
+        return [(self.tile_zoom, tx, ty)
+                for ty in range(int(top // tile_pixels), int(bottom // tile_pixels) + 1)
+                for tx in range(int(left // tile_pixels), int(right // tile_pixels) + 1)]
+
+    def add_tile(self, z, x, y, data):
+        """Decode one vector tile and keep the styled features inside the view."""
+        tile_pixels = self.world_size / (2 ** z)
+        origin_x = x * tile_pixels - self.center_x + self.width / 2
+        origin_y = y * tile_pixels - self.center_y + self.height / 2
+
+        # Clip to the tile itself as well, so the buffer zone tiles share
+        # with their neighbours is not encoded twice
+        clip_x0 = max(origin_x, -self.margin)
+        clip_y0 = max(origin_y, -self.margin)
+        clip_x1 = min(origin_x + tile_pixels, self.width + self.margin)
+        clip_y1 = min(origin_y + tile_pixels, self.height + self.margin)
+        if clip_x0 >= clip_x1 or clip_y0 >= clip_y1:
+            return
+
+        for layer_name, (extent, features) in decode_mvt(data).items():
+            scale = tile_pixels / extent
+            for index, (_, source, classes, kind, _, _) in enumerate(self.style_layers):
+                if source != layer_name:
+                    continue
+                wanted_type = GEOM_POLYGON if kind == LAYER_FILL else GEOM_LINESTRING
+                for geom_type, properties, commands in features:
+                    if geom_type != wanted_type:
+                        continue
+                    if classes is not None and properties.get('class') not in classes:
+                        continue
+
+                    parts = [[(origin_x + px * scale, origin_y + py * scale) for px, py in part]
+                             for part in decode_geometry(commands)]
+                    if kind == LAYER_FILL:
+                        parts = [_clip_ring(ring, clip_x0, clip_y0, clip_x1, clip_y1) for ring in parts]
+                        parts = [_simplify(ring + ring[:1], self.tolerance)[:-1] for ring in parts if len(ring) >= 3]
+                        parts = [ring for ring in parts if len(ring) >= 3 and _ring_area(ring) >= 1.0]
+                    else:
+                        parts = [piece for line in parts
+                                 for piece in _clip_line(line, clip_x0, clip_y0, clip_x1, clip_y1)]
+                        parts = [_simplify(line, self.tolerance) for line in parts]
+                    if parts:
+                        self.layers[index].append(parts)
+
+    def _quantise(self, point):
+        # Portrait view -> panel: panel (x, y) = (height - v, u), as the
+        # server converter rotates maps clockwise
+        scale = 1 << self.precision_bits
+        return (int(round((self.height - point[1]) * scale)), int(round(point[0] * scale)))
+
+    def encode(self):
+        """Serialise the collected features; returns the .vmap bytes."""
+        payload = bytearray()
+        layer_count = 0
+        for (name, _, _, kind, color, line_width), features in zip(self.style_layers, self.layers):
+            encoded = []
+            for parts in features:
+                quantised = []
+                for part in parts:
+                    points = []
+                    for point in part:
+                        q = self._quantise(point)
+                        if not points or q != points[-1]:
+                            points.append(q)
+                    if len(points) >= (3 if kind == LAYER_FILL else 2):
+                        quantised.append(points)
+                if quantised:
+                    encoded.append(quantised)
+            if not encoded:
+                continue
+
+            layer_count += 1
+            payload += bytes((kind, color, line_width))
+            _varint(len(encoded), payload)
+            cursor_x = cursor_y = 0
+            for parts in encoded:
+                _varint(len(parts), payload)
+                for points in parts:
+                    _varint(len(points), payload)
+                    for px, py in points:
+                        _varint(_zigzag(px - cursor_x), payload)
+                        _varint(_zigzag(py - cursor_y), payload)
+                        cursor_x, cursor_y = px, py
+
+        header = struct.pack('<IBBBBHHI', VMAP_MAGIC, VMAP_VERSION, self.precision_bits,
+                             self.background, layer_count, PANEL_WIDTH, PANEL_HEIGHT,
+                             fnv1a_32(payload))
+        return header + bytes(payload)
+
+
+# ---------------------------------------------------------------------------
+# Reference rasteriser (same rules and integer math as VectorMap::renderBand)
+# ---------------------------------------------------------------------------
+
+def _cdiv(a, b):
+    """C integer division (truncates toward zero)."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+class _Frame:
+    def __init__(self, width, height, color):
+        self.width = width
+        self.height = height
+        self.rows = [bytearray([color]) * width for _ in range(height)]
+
+    def fill_rect(self, x, y, w, h, color):
+        x0, y0 = max(x, 0), max(y, 0)
+        x1, y1 = min(x + w, self.width), min(y + h, self.height)
+        for row in range(y0, y1):
+            if x1 > x0:
+                self.rows[row][x0:x1] = bytes([color]) * (x1 - x0)
+
+    def fill_circle(self, cx, cy, radius, color):
+        half_width = radius
+        for dy in range(radius + 1):
+            while half_width > 0 and half_width * half_width + dy * dy > radius * radius:
+                half_width -= 1
+            self.fill_rect(cx - half_width, cy - dy, 2 * half_width + 1, 1, color)
+            if dy > 0:
+                self.fill_rect(cx - half_width, cy + dy, 2 * half_width + 1, 1, color)
+
+    def draw_line(self, x0, y0, x1, y1, color):
+        if y0 == y1 or x0 == x1:
+            self.fill_rect(min(x0, x1), min(y0, y1), abs(x1 - x0) + 1, abs(y1 - y0) + 1, color)
+            return
+        dx, dy = abs(x1 - x0), -abs(y1 - y0)
+        step_x, step_y = (1 if x0 < x1 else -1), (1 if y0 < y1 else -1)
+        error = dx + dy
+        while True:
+            self.fill_rect(x0, y0, 1, 1, color)
+            if x0 == x1 and y0 == y1:
+                break
+            doubled = 2 * error
+            if doubled >= dy:
+                error += dy
+                x0 += step_x
+            if doubled <= dx:
+                error += dx
+                y0 += step_y
+
+    def fill_edges(self, edges, shift, color):
+        if len(edges) < 2:
+            return
+        one = 1 << shift
+        half = one >> 1
+        edges = sorted(edges, key=lambda e: e[1])
+        row_start = max(edges[0][1] >> shift, 0)
+        row_end = min((max(e[3] for e in edges) >> shift) + 1, self.height)
+        for row in range(row_start, row_end):
+            sample_y = (row << shift) + half
+            xs = sorted(x0 + _cdiv((sample_y - y0) * (x1 - x0), y1 - y0)
+                        for x0, y0, x1, y1 in edges if y0 <= sample_y < y1)
+            for k in range(0, len(xs) - 1, 2):
+                start = (xs[k] - half + one - 1) >> shift
+                end = (xs[k + 1] - half + one - 1) >> shift
+                if end > start:
+                    self.fill_rect(start, row, end - start, 1, color)
+
+
+def _ring_edges(points):
+    edges = []
+    for i in range(len(points)):
+        (ax, ay), (bx, by) = points[i], points[(i + 1) % len(points)]
+        if ay != by:
+            edges.append((ax, ay, bx, by) if ay < by else (bx, by, ax, ay))
+    return edges
+
+
+def rasterise_vector_map(data):
+    """
+    Rasterise .vmap bytes to panel color indices (list of PANEL_HEIGHT rows).
+
+    Raises:
+        ValueError: If the data is not a valid .vmap
+    """
+    magic, version, precision, background, layer_count, width, height, payload_hash = \
+        struct.unpack_from('<IBBBBHHI', data)
+    if magic != VMAP_MAGIC or version != VMAP_VERSION:
+        raise ValueError("Not a .vmap file")
+    if fnv1a_32(data[HEADER_SIZE:]) != payload_hash:
+        raise ValueError(".vmap hash mismatch")
+
+    frame = _Frame(width, height, background)
+    shift = precision + 1
+    pos = HEADER_SIZE
+    for _ in range(layer_count):
+        kind, color, line_width = data[pos], data[pos + 1], data[pos + 2]
+        pos += 3
+        feature_count, pos = _read_varint(data, pos)
+        x = y = 0
+        for _ in range(feature_count):
+            part_count, pos = _read_varint(data, pos)
+            edges = []
+            for _ in range(part_count):
+                point_count, pos = _read_varint(data, pos)
+                points = []
+                for _ in range(point_count):
+                    dx, pos = _read_varint(data, pos)
+                    dy, pos = _read_varint(data, pos)
+                    x += (dx >> 1) ^ -(dx & 1)
+                    y += (dy >> 1) ^ -(dy & 1)
+                    points.append((x * 2, y * 2))
+                if kind == LAYER_FILL:
+                    edges += _ring_edges(points)
+                else:
+                    _draw_polyline(frame, points, line_width, shift, color)
+            if kind == LAYER_FILL:
+                frame.fill_edges(edges, shift, color)
+    return frame.rows
+
+
+def _draw_polyline(frame, points, line_width, shift, color):
+    for (ax, ay), (bx, by) in zip(points, points[1:]):
+        if line_width == 1:
+            frame.draw_line(ax >> shift, ay >> shift, bx >> shift, by >> shift, color)
+            continue
+        dx, dy = bx - ax, by - ay
+        length = math.isqrt(dx * dx + dy * dy)
+        if length == 0:
+            continue
+        half_width = (line_width << shift) // 2
+        nx = _cdiv(-dy * half_width, length)
+        ny = _cdiv(dx * half_width, length)
+        quad = [(ax + nx, ay + ny), (bx + nx, by + ny), (bx - nx, by - ny), (ax - nx, ay - ny)]
+        frame.fill_edges(_ring_edges(quad), shift, color)
+    for px, py in points:
+        frame.fill_circle(px >> shift, py >> shift, line_width // 2, color)
+
+
+def compare_with_frame(vmap_path, bin_path):
+    """
+    Compare a rasterised .vmap with the server's e-paper frame (.bin).
+
+    Returns:
+        dict: Overall pixel agreement and, per color of the vector render,
+        the share of its pixels that have the same color in the frame
+    """
+    with open(vmap_path, 'rb') as f:
+        rows = rasterise_vector_map(f.read())
+    with open(bin_path, 'rb') as f:
+        packed = f.read()
+
+    matches = 0
+    per_color = {}
+    for y, row in enumerate(rows):
+        for x, color in enumerate(row):
+            byte = packed[(y * PANEL_WIDTH + x) // 2]
+            reference = byte >> 4 if x % 2 == 0 else byte & 0x0F
+            total, same = per_color.get(color, (0, 0))
+            per_color[color] = (total + 1, same + (reference == color))
+            matches += reference == color
+
+    return {
+        'agreement': matches / (PANEL_WIDTH * PANEL_HEIGHT),
+        'per_color': {color: same / total for color, (total, same) in per_color.items()},
+    }
+
+
+def export_vector_map(mapbox, lat, lng, zoom, vmap_path, **encoder_options):
+    """
+    Fetch the vector tiles of a map view and write its .vmap file.
+
+    Args:
+        mapbox: MapboxProvider used to download the vector tiles
+        lat, lng, zoom: Map view, as used for the PNG render
+        vmap_path: Output path
+
+    Returns:
+        str: Path of the .vmap, or None if failed
+    """
+    try:
+        encoder = VectorMapEncoder(lat, lng, zoom, **encoder_options)
+        for z, x, y in encoder.tiles_for_view():
+            tile = mapbox.download_vector_tile(z, x, y)
+            if tile is None:
+                print(f"⚠️  Vector tile {z}/{x}/{y} not available")
+                return None
+            encoder.add_tile(z, x, y, tile)
+
+        data = encoder.encode()
+        with open(vmap_path, 'wb') as f:
+            f.write(data)
+
+        print(f"✅ Vector map saved to: {vmap_path} ({len(data)} bytes, "
+              f"{len(zlib.compress(data, 9))} bytes deflated)")
+        return vmap_path
+
+    except Exception as e:
+        print(f"❌ Error exporting vector map: {e}")
+        return None
+
+
+# Compare an encoded map with the server's frame when run directly
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) == 3:
+        result = compare_with_frame(sys.argv[1], sys.argv[2])
+        print(f"Pixel agreement: {result['agreement'] * 100:.1f}%")
+        for color, share in sorted(result['per_color'].items()):
+            print(f"  color {color}: {share * 100:.1f}% of vector pixels match the frame")
+    else:
+        print("Usage: python vector_map_encoder.py <map.vmap> <map.bin>")
+        print(f"Example: python vector_map_encoder.py {os.path.join('..', 'Maps', 'Vienna_Austria.vmap')} "
+              f"{os.path.join('..', 'Maps', 'Vienna_Austria.bin')}")
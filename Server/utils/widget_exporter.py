@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Widget Exporter for Smart City Maps.
+
+Publishes the map without its information overlay plus a small JSON document
+with the values the firmware draws on top of it (city, coordinates, date,
+time, weather). The base map only changes when the map style or location
+changes, so a device that keeps it in flash downloads ~1 KB per wake instead
+of a full 192 KB frame.
+"""
+
+import json
+import os
+
+import numpy as np
+
+from .png_to_epaper_converter import EpaperColorConverter
+from .epaper_visualizer import visualize_epaper_binary
+
+
+WIDGET_FORMAT_VERSION = 1
+
+
+def fnv1a_32(data):
+    """FNV-1a 32-bit hash, identical to Framebuffer::hash on the device."""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def portrait_frame_hash(bin_path):
+    """
+    Hash of the 480x800 packed frame the device decodes from *_base_epd.png.
+
+    The .bin is landscape (rotated clockwise); the device keeps the portrait
+    orientation and rotates while uploading, so hash that layout.
+    """
+    with open(bin_path, 'rb') as f:
+        packed = np.frombuffer(f.read(), dtype=np.uint8)
+
+    landscape = np.empty(packed.size * 2, dtype=np.uint8)
+    landscape[0::2] = packed >> 4
+    landscape[1::2] = packed & 0x0F
+    landscape = landscape.reshape(480, 800)
+
+    portrait = np.rot90(landscape)
+    repacked = (portrait[:, 0::2] << 4) | portrait[:, 1::2]
+    return fnv1a_32(repacked.astype(np.uint8).tobytes())
+
+
+def export_widget_assets(base_image, base_name, city, country, lat, lng,
+                         date_str, time_str, weather_data=None, frame_bin_path=None):
+    """
+    Write <base_name>_base_epd.png and <base_name>_widgets.json.
+
+    Args:
+        base_image: Cropped 480x800 map without the information overlay
+        base_name: Output path without extension (e.g. Maps/Vienna_Austria)
+        city, country, lat, lng: Location shown in the widget title
+        date_str, time_str: Local date and time of the location
+        weather_data: Weather dict from WeatherProvider (optional)
+        frame_bin_path: Full frame (.bin) whose hash devices check after streaming it
+
+    Returns:
+        str: Path of the widget JSON, or None if failed
+    """
+    base_png_path = f"{base_name}_base.png"
+    base_epd_path = f"{base_name}_base_epd.png"
+    widgets_path = f"{base_name}_widgets.json"
+
+    try:
+        base_image.save(base_png_path, 'PNG')
+        converter = EpaperColorConverter()
+        bin_path = converter.convert_png_to_epaper(base_png_path, generate_c_file=False)
+        if not bin_path or not visualize_epaper_binary(bin_path, base_epd_path):
+            print("⚠️  Failed to convert base map for widgets")
+            return None
+
+        base_hash = portrait_frame_hash(bin_path)
+
+        # Only the quantised base map is published
+        os.remove(bin_path)
+        os.remove(base_png_path)
+
+        widgets = {
+            'version': WIDGET_FORMAT_VERSION,
+            'base_map': os.path.basename(base_epd_path),
+            'base_hash': base_hash,
+            'city': city,
+            'country': country,
+            'lat': round(lat, 4),
+            'lng': round(lng, 4),
+            'date': date_str,
+            'time': time_str,
+        }
+        if frame_bin_path and os.path.exists(frame_bin_path):
+            with open(frame_bin_path, 'rb') as f:
+                widgets['frame_hash'] = fnv1a_32(f.read())
+        if weather_data:
+            widgets['temperature'] = round(weather_data['temperature'])
+            widgets['icon'] = weather_data['icon']
+            widgets['description'] = weather_data['description']
+
+        with open(widgets_path, 'w') as f:
+            json.dump(widgets, f, separators=(',', ':'))
+
+        print(f"✅ Widget data saved to: {widgets_path} (base 0x{base_hash:08X})")
+        return widgets_path
+
+    except Exception as e:
+        print(f"❌ Error exporting widget assets: {e}")
+        return None